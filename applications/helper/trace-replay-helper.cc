@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "trace-replay-helper.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/names.h"
+
+namespace ns3 {
+
+TraceReplayHelper::TraceReplayHelper (std::string protocol, Address address, std::string traceFile)
+{
+  m_factory.SetTypeId ("ns3::TraceReplayApplication");
+  m_factory.Set ("Protocol", StringValue (protocol));
+  m_factory.Set ("Remote", AddressValue (address));
+  m_factory.Set ("TraceFile", StringValue (traceFile));
+}
+
+TraceReplayHelper::TraceReplayHelper (std::string protocol, Ipv4Address address, std::string traceFile)
+{
+  m_factory.SetTypeId ("ns3::TraceReplayApplication");
+  m_factory.Set ("Protocol", StringValue (protocol));
+  m_factory.Set ("Remote", AddressValue (Address (address)));
+  m_factory.Set ("TraceFile", StringValue (traceFile));
+}
+
+void
+TraceReplayHelper::SetAttribute (std::string name, const AttributeValue &value)
+{
+  m_factory.Set (name, value);
+}
+
+ApplicationContainer
+TraceReplayHelper::Install (Ptr<Node> node) const
+{
+  return ApplicationContainer (InstallPriv (node));
+}
+
+ApplicationContainer
+TraceReplayHelper::Install (std::string nodeName) const
+{
+  Ptr<Node> node = Names::Find<Node> (nodeName);
+  return ApplicationContainer (InstallPriv (node));
+}
+
+ApplicationContainer
+TraceReplayHelper::Install (NodeContainer c) const
+{
+  ApplicationContainer apps;
+  uint32_t index = 0;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i, ++index)
+    {
+      Ptr<Application> app = InstallPriv (*i);
+      app->SetAttribute ("FlowCount", UintegerValue (c.GetN ()));
+      app->SetAttribute ("FlowIndex", UintegerValue (index));
+      apps.Add (app);
+    }
+
+  return apps;
+}
+
+Ptr<Application>
+TraceReplayHelper::InstallPriv (Ptr<Node> node) const
+{
+  Ptr<Application> app = m_factory.Create<Application> ();
+  node->AddApplication (app);
+
+  return app;
+}
+
+} // namespace ns3
@@ -0,0 +1,89 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACE_REPLAY_HELPER_H
+#define TRACE_REPLAY_HELPER_H
+
+#include <stdint.h>
+#include <string>
+#include "ns3/object-factory.h"
+#include "ns3/address.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/attribute.h"
+#include "ns3/node-container.h"
+#include "ns3/application-container.h"
+
+namespace ns3 {
+
+/**
+ * \brief A helper to make it easier to instantiate an
+ * ns3::TraceReplayApplication on a set of nodes.
+ */
+class TraceReplayHelper
+{
+public:
+  /**
+   * \param protocol the name of the socket factory of the applications,
+   *        typically ns3::UdpSocketFactory.
+   * \param address the address of the remote node to send traffic to.
+   * \param traceFile the trace to replay.
+   */
+  TraceReplayHelper (std::string protocol, Address address, std::string traceFile);
+
+  TraceReplayHelper (std::string protocol, Ipv4Address address, std::string traceFile);
+
+  /**
+   * Helper function used to set the underlying application attributes.
+   *
+   * \param name the name of the application attribute to set
+   * \param value the value of the application attribute to set
+   */
+  void SetAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * Install an application on each node of the input container. The
+   * flows of the trace are split between the nodes, each replaying those
+   * whose id modulo the number of nodes is its index in the container.
+   *
+   * \param c NodeContainer of the set of nodes on which an Application
+   * will be installed.
+   * \returns Container of Ptr to the applications installed.
+   */
+  ApplicationContainer Install (NodeContainer c) const;
+
+  /**
+   * Install an application replaying the flows set with the FlowCount and
+   * FlowIndex attributes, all of them by default.
+   *
+   * \param node The node on which an Application will be installed.
+   * \returns Container of Ptr to the applications installed.
+   */
+  ApplicationContainer Install (Ptr<Node> node) const;
+
+  /**
+   * \param nodeName The node on which an Application will be installed.
+   * \returns Container of Ptr to the applications installed.
+   */
+  ApplicationContainer Install (std::string nodeName) const;
+
+private:
+  Ptr<Application> InstallPriv (Ptr<Node> node) const;
+  ObjectFactory m_factory;
+};
+
+} // namespace ns3
+
+#endif /* TRACE_REPLAY_HELPER_H */
@@ -32,6 +32,10 @@
 #include "ns3/udp-socket-factory.h"
 #include "ns3/double.h"
 #include "ns3/pointer.h"
+#include "ns3/nstime.h" // edit
+#include "ns3/boolean.h" // edit
+#include <cmath> // edit
+#include <algorithm> // edit
 
 NS_LOG_COMPONENT_DEFINE ("PPBPApplication");
 
@@ -75,6 +79,20 @@ namespace ns3 {
 					   TypeIdValue (UdpSocketFactory::GetTypeId ()),
 					   MakeTypeIdAccessor (&PPBPApplication::m_protocolTid),
 					   MakeTypeIdChecker ())
+		.AddAttribute ("TrainGranularity",
+					   "Send the packets due as a train every TrainGranularity, "
+					   "0 to schedule an event per packet; ignored in FluidMode",
+					   TimeValue (Seconds (0)),
+					   MakeTimeAccessor (&PPBPApplication::m_trainGranularity),
+					   MakeTimeChecker ())
+		.AddAttribute ("FluidMode",
+					   "Add the rate of the process to the links given with AddFluidDevice "
+					   "instead of sending packets",
+					   BooleanValue (false),
+					   MakeBooleanAccessor (&PPBPApplication::m_fluidMode),
+					   MakeBooleanChecker ())
+		.AddTraceSource ("FluidRate", "The rate of the process changed, in FluidMode",
+						 MakeTraceSourceAccessor (&PPBPApplication::m_fluidRateTrace))
 		.AddTraceSource ("Tx", "A new packet is created and is sent",
 						 MakeTraceSourceAccessor (&PPBPApplication::m_txTrace))
 		;
@@ -90,6 +108,9 @@ namespace ns3 {
 		m_totalBytes = 0;
 		m_activebursts = 0;
 		m_offPeriod = true;
+		m_trainCredit = 0; // edit
+		m_fluidMode = false; // edit
+		m_fluidRate = 0; // edit
 	}
 	
 	PPBPApplication::~PPBPApplication()
@@ -103,6 +124,33 @@ namespace ns3 {
 		return m_totalBytes;
 	}
 	
+	void
+	PPBPApplication::AddFluidDevice(Ptr<NetDevice> device) // edit
+	{
+		NS_LOG_FUNCTION (this << device);
+		m_fluidLinks.push_back (FluidLinkLoad::GetOrCreate (device));
+	}
+	
+	void
+	PPBPApplication::UpdateFluidRate() // edit
+	{
+		// the bytes of the fluid are those the packets would have carried
+		m_totalBytes += static_cast<uint32_t>((Simulator::Now () - m_lastCredit).GetSeconds () * m_fluidRate / 8);
+		m_lastCredit = Simulator::Now ();
+
+		double rate = (m_activebursts > 0) ? m_activebursts * static_cast<double>(m_cbrRate.GetBitRate()) : 0;
+		if (rate == m_fluidRate)
+		{
+			return;
+		}
+		for (std::vector<Ptr<FluidLinkLoad> >::iterator it = m_fluidLinks.begin (); it != m_fluidLinks.end (); ++it)
+		{
+			(*it)->AddRate (rate - m_fluidRate);
+		}
+		m_fluidRate = rate;
+		m_fluidRateTrace (m_fluidRate);
+	}
+	
 	void
 	PPBPApplication::DoDispose (void)
 	{
@@ -120,7 +168,7 @@ namespace ns3 {
 		NS_LOG_FUNCTION_NOARGS ();
 		
 		// Create the socket if not already
-		if (!m_socket)
+		if (!m_socket && !m_fluidMode) // edit
 		{
 			m_socket = Socket::CreateSocket (GetNode(), m_protocolTid);
 			m_socket->Bind ();
@@ -136,27 +184,72 @@ namespace ns3 {
 	{
 		NS_LOG_FUNCTION_NOARGS ();
 		
-		double inter_burst_intervals;
-		inter_burst_intervals = 1/m_burstArrivals.GetValue();
-
-		ExponentialVariable exp(inter_burst_intervals);
-		Time t_poisson_arrival = Seconds (exp.GetValue());
-		m_PoissonArrival = Simulator::Schedule(t_poisson_arrival,&PPBPApplication::PoissonArrival, this);
+		// edit: a burst ending now ends before one arriving now begins
+		Time now = Simulator::Now ();
+		while (!m_departures.empty () && m_departures.top () <= now)
+		{
+			m_departures.pop ();
+			ParetoDeparture ();
+		}
+		if (m_nextArrival <= now)
+		{
+			PoissonArrival ();
+			m_departures.push (now + Seconds (DrawBurstLength ()));
+			m_nextArrival = now + Seconds (DrawInterArrival ());
+		}
 		
-		// Pareto
+		Time next = m_nextArrival;
+		if (!m_departures.empty () && m_departures.top () < next)
+		{
+			next = m_departures.top ();
+		}
+		m_ppbp = Simulator::Schedule(next - now,&PPBPApplication::PPBP, this);
+	}
+	
+	double
+	PPBPApplication::DrawInterArrival() // edit
+	{
+		// exponential of mean 1 / lambda_p
+		double inter_burst_intervals = 1/m_burstArrivals.GetValue();
+		return -inter_burst_intervals * std::log (1 - m_uniform.GetValue ());
+	}
+	
+	double
+	PPBPApplication::DrawBurstLength() // edit
+	{
+		// Pareto of mean Ton, the same law as ParetoVariable (Ton, m_shape)
 		m_shape = 3 - 2 * m_h;
-		m_timeSlot = Seconds((double) (m_shape - 1) * m_burstLength.GetValue() / m_shape);
-		
-		ParetoVariable pareto(m_burstLength.GetValue(), m_shape);
-		
-		m_ParetoDeparture = Simulator::Schedule(t_poisson_arrival + Seconds (pareto.GetValue()),&PPBPApplication::ParetoDeparture, this);
-		
-		m_ppbp = Simulator::Schedule(t_poisson_arrival,&PPBPApplication::PPBP, this);
+		double scale = (m_shape - 1) * m_burstLength.GetValue() / m_shape;
+		m_timeSlot = Seconds(scale);
+		return scale / std::pow (1 - m_uniform.GetValue (), 1 / m_shape);
 	}
 	
 	void PPBPApplication::PoissonArrival()
 	{
 		NS_LOG_FUNCTION_NOARGS ();
+		if (m_fluidMode) // edit
+		{
+			++m_activebursts;
+			UpdateFluidRate ();
+			return;
+		}
+		if (!m_trainGranularity.IsZero ()) // edit
+		{
+			AccumulateCredit ();
+			++m_activebursts;
+			// the next train was planned at the former rate: bring it forward
+			// if needed, never postpone it
+			if (m_sendEvent.IsRunning ())
+			{
+				if (Simulator::GetDelayLeft (m_sendEvent) <= GetTrainDelay ())
+				{
+					return;
+				}
+				Simulator::Cancel (m_sendEvent);
+			}
+			ScheduleNextTx ();
+			return;
+		}
 		++m_activebursts;
 		if (m_offPeriod) ScheduleNextTx();
 	}
@@ -165,7 +258,43 @@ namespace ns3 {
 	PPBPApplication::ParetoDeparture()
 	{
 		NS_LOG_FUNCTION_NOARGS ();
+		// edit: in FluidMode m_lastCredit times the fluid bytes, not a credit
+		if (!m_trainGranularity.IsZero () && !m_fluidMode)
+		{
+			AccumulateCredit ();
+		}
 		--m_activebursts;
+		if (m_fluidMode) // edit
+		{
+			UpdateFluidRate ();
+		}
+	}
+	
+	double
+	PPBPApplication::GetPacketRate() const // edit
+	{
+		if (m_activebursts <= 0)
+		{
+			return 0;
+		}
+		uint32_t bits = (m_pktSize + 30) * 8;
+		return m_activebursts * static_cast<double>(m_cbrRate.GetBitRate()) / bits;
+	}
+	
+	Time
+	PPBPApplication::GetTrainDelay() const // edit
+	{
+		// below one packet per granularity, a train is a single packet on time
+		double rate = GetPacketRate ();
+		NS_ASSERT (rate > 0);
+		return Seconds (std::max (m_trainGranularity.GetSeconds (), (1 - m_trainCredit) / rate));
+	}
+	
+	void
+	PPBPApplication::AccumulateCredit() // edit
+	{
+		m_trainCredit += (Simulator::Now () - m_lastCredit).GetSeconds () * GetPacketRate ();
+		m_lastCredit = Simulator::Now ();
 	}
 	
 	void
@@ -174,6 +303,12 @@ namespace ns3 {
 		NS_LOG_FUNCTION_NOARGS ();
 		
 		CancelEvents ();
+		if (m_fluidMode) // edit: the links are left unloaded
+		{
+			m_activebursts = 0;
+			UpdateFluidRate ();
+			return;
+		}
 		if(m_socket != 0) m_socket->Close ();
 		else NS_LOG_WARN("PPBPApplication found null socket to close in StopApplication");
 	}
@@ -186,8 +321,9 @@ namespace ns3 {
 		Simulator::Cancel(m_startStopEvent);
 		
 		Simulator::Cancel(m_ppbp);
-		Simulator::Cancel(m_PoissonArrival);
-		Simulator::Cancel(m_ParetoDeparture);
+		// edit: the bursts end with the process
+		m_departures = std::priority_queue<Time, std::vector<Time>, std::greater<Time> > ();
+		m_activebursts = 0;
 	}
 	
 	// Event handlers 
@@ -196,7 +332,11 @@ namespace ns3 {
 	{
 		NS_LOG_FUNCTION_NOARGS ();
 		m_lastStartTime = Simulator::Now();
-		ScheduleNextTx();					// Schedule the send packet event
+		m_lastCredit = Simulator::Now(); // edit
+		if (!m_fluidMode) // edit
+		{
+			ScheduleNextTx();					// Schedule the send packet event
+		}
 		ScheduleStopEvent();
 	}
 
@@ -213,6 +353,18 @@ namespace ns3 {
 	PPBPApplication::ScheduleNextTx()
 	{
 		NS_LOG_FUNCTION_NOARGS ();
+		if (!m_trainGranularity.IsZero ()) // edit
+		{
+			double rate = GetPacketRate ();
+			if (rate == 0)
+			{
+				m_offPeriod = true;
+				return;
+			}
+			m_offPeriod = false;
+			m_sendEvent = Simulator::Schedule(GetTrainDelay (),&PPBPApplication::SendTrain, this);
+			return;
+		}
 		uint32_t bits = (m_pktSize + 30) * 8;
 		Time nextTime(Seconds (bits / 
 							   static_cast<double>(m_cbrRate.GetBitRate())));
@@ -234,7 +386,8 @@ namespace ns3 {
 	PPBPApplication::ScheduleStartEvent()
 	{
 		NS_LOG_FUNCTION_NOARGS ();
-		m_ppbp = Simulator::Schedule(Seconds(0.0), &PPBPApplication::PPBP, this);
+		m_nextArrival = Simulator::Now () + Seconds (DrawInterArrival ()); // edit
+		m_ppbp = Simulator::Schedule(m_nextArrival - Simulator::Now (), &PPBPApplication::PPBP, this);
 		m_startStopEvent = Simulator::Schedule(Seconds(0.0), &PPBPApplication::StartSending, this);
 	}
 	
@@ -256,6 +409,25 @@ namespace ns3 {
 		ScheduleNextTx();
 	}
 	
+	void
+	PPBPApplication::SendTrain() // edit
+	{
+		NS_LOG_FUNCTION_NOARGS ();
+		AccumulateCredit ();
+		uint32_t packets = static_cast<uint32_t>(std::floor (m_trainCredit));
+		m_trainCredit -= packets;
+		NS_LOG_LOGIC ("train of " << packets << " packets, " << m_activebursts << " active bursts");
+		for (uint32_t i = 0; i < packets; ++i)
+		{
+			Ptr<Packet> packet = Create<Packet> (m_pktSize);
+			m_txTrace (packet);
+			m_socket->Send (packet);
+			m_totalBytes += packet->GetSize();
+		}
+		m_lastStartTime = Simulator::Now();
+		ScheduleNextTx();
+	}
+	
 	void
 	PPBPApplication::ConnectionSucceeded(Ptr<Socket>)
 	{
@@ -28,6 +28,11 @@
 #include "ns3/random-variable.h"
 #include "ns3/traced-callback.h"
 #include "ns3/data-rate.h"
+#include "ns3/net-device.h" // edit
+#include "fluid-link-load.h" // edit
+#include <vector> // edit
+#include <queue> // edit
+#include <functional> // edit
 
 namespace ns3 {
 	
@@ -76,6 +81,18 @@ namespace ns3 {
 	 * straightforward to compute the overall rate of the PPBP, lambda:
 	 * lambda = Ton x lambda_p x r
 	 *
+	 * With a TrainGranularity, the packets due at the current rate are sent
+	 * back to back once per granularity instead of one event per packet, so
+	 * that the number of events no longer grows with the aggregate rate.
+	 * The rate is integrated exactly across burst arrivals and departures;
+	 * a packet is at most one granularity late.
+	 *
+	 * In FluidMode no packet is sent: the rate of the process, active
+	 * bursts x r, is added as a FluidLinkLoad to the devices of the path
+	 * given with AddFluidDevice, whose capacity left to the packets shrinks
+	 * accordingly. Only the burst arrivals and departures are events, and
+	 * TrainGranularity is ignored.
+	 *
 	 * References:
 	 * - - - - - -
 	 * [1]	A new tool for generating realistic Internet traffic in NS-3,
@@ -101,6 +118,13 @@ namespace ns3 {
 		 * \brief Return total bytes sent by this object.
 		 */
 		uint32_t      GetTotalBytes() const;
+
+		/**
+		 * \brief In FluidMode, add the transmitting device of a link the
+		 * background traffic crosses. Its DataRate is read when the link
+		 * carries no background load, see FluidLinkLoad.
+		 */
+		void          AddFluidDevice(Ptr<NetDevice> device); // edit
 		
 	protected:
 		virtual void DoDispose ();
@@ -117,6 +141,7 @@ namespace ns3 {
 		void StartSending();
 		void StopSending();
 		void SendPacket();
+		void SendTrain(); // edit
 		
 		Ptr<Socket>     m_socket;						// Associated socket
 		TypeId          m_protocolTid;					// protocol type id
@@ -129,9 +154,10 @@ namespace ns3 {
 		EventId         m_startStopEvent;				// Event id for next start or stop event
 		EventId         m_sendEvent;					// Event id of pending "send packet" event
 		EventId			m_getUtilization;				// Event id to get the utilization factor
-		EventId			m_PoissonArrival;				// Event id for next burst arrival
-		EventId			m_ppbp;							// Event id for the length of a pending burst arrival
-		EventId			m_ParetoDeparture;				// Event id of burst departure
+		EventId			m_ppbp;							// Event id of the next burst arrival or departure // edit
+		Time			m_nextArrival;					// Time of the next burst arrival // edit
+		std::priority_queue<Time, std::vector<Time>, std::greater<Time> > m_departures;	// End of each active burst // edit
+		UniformVariable	m_uniform;						// Drawn from for the arrivals and the lengths // edit
 		
 		uint32_t		m_pktSize;						// Size of packets
 		
@@ -146,6 +172,13 @@ namespace ns3 {
 		Time			m_timeSlot;						// The time slot
 		int				m_activebursts;					// Number of active bursts at time t
 		bool			m_offPeriod;
+		Time			m_trainGranularity;				// Time between trains, 0 for one event per packet // edit
+		double			m_trainCredit;					// Packets due and not sent yet // edit
+		Time			m_lastCredit;					// Time the credit was last brought up to date // edit
+		bool			m_fluidMode;					// Load the links as a fluid instead of sending packets // edit
+		double			m_fluidRate;					// Rate added to the links, in bit/s // edit
+		std::vector<Ptr<FluidLinkLoad> > m_fluidLinks;	// Links of the path in FluidMode // edit
+		TracedCallback<double> m_fluidRateTrace;		// Trace callback for each change of the fluid rate // edit
 
 		
 	private:
@@ -158,8 +191,14 @@ namespace ns3 {
 		 * \ Functions that allows to keep track of the current number of active bursts at time t, nt,
 		 * taking into account that their arrival process follows a Poisson process and that their
 		 * length is determined by a Pareto distribution.
+		 *
+		 * The end of each active burst is kept in a min-heap: PPBP handles the
+		 * arrivals and departures due and schedules itself for the next one,
+		 * the only pending event of the process whatever the number of bursts.
 		 */
 		void PPBP();
+		double DrawInterArrival(); // edit
+		double DrawBurstLength(); // edit
 		void PoissonArrival();
 		void ParetoDeparture();
 		
@@ -167,6 +206,26 @@ namespace ns3 {
 		 * \ Function thet generates the packets departure at a constant bit-rate nt x r.
 		 */
 		void ScheduleNextTx();
+
+		/**
+		 * \ Add the packets due at the current rate since the last update
+		 */
+		void AccumulateCredit(); // edit
+
+		/**
+		 * \returns the current rate in packets per second
+		 */
+		double GetPacketRate() const; // edit
+
+		/**
+		 * \returns the time to the next train at the current rate
+		 */
+		Time GetTrainDelay() const; // edit
+
+		/**
+		 * \ Set the rate of the links to the current number of active bursts
+		 */
+		void UpdateFluidRate(); // edit
 	};
 	
 } // namespace ns3
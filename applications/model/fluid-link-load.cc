@@ -0,0 +1,122 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "fluid-link-load.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/net-device.h"
+#include "ns3/trace-source-accessor.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FluidLinkLoad");
+
+NS_OBJECT_ENSURE_REGISTERED (FluidLinkLoad);
+
+TypeId
+FluidLinkLoad::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FluidLinkLoad")
+    .SetParent<Object> ()
+    .AddConstructor<FluidLinkLoad> ()
+    .AddAttribute ("MinResidualFraction",
+                   "Fraction of the nominal rate always left to the packets",
+                   DoubleValue (0.01),
+                   MakeDoubleAccessor (&FluidLinkLoad::m_minResidualFraction),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddTraceSource ("Load", "The background load of the link changed",
+                     MakeTraceSourceAccessor (&FluidLinkLoad::m_loadTrace))
+  ;
+  return tid;
+}
+
+FluidLinkLoad::FluidLinkLoad ()
+  : m_load (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FluidLinkLoad::~FluidLinkLoad ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FluidLinkLoad::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_device = 0;
+  Object::DoDispose ();
+}
+
+Ptr<FluidLinkLoad>
+FluidLinkLoad::GetOrCreate (Ptr<NetDevice> device)
+{
+  Ptr<FluidLinkLoad> load = device->GetObject<FluidLinkLoad> ();
+  if (load == 0)
+    {
+      load = CreateObject<FluidLinkLoad> ();
+      load->Attach (device);
+      device->AggregateObject (load);
+    }
+  return load;
+}
+
+void
+FluidLinkLoad::Attach (Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+  DataRateValue rate;
+  NS_ABORT_MSG_UNLESS (device->GetAttributeFailSafe ("DataRate", rate),
+                       "device " << device->GetInstanceTypeId ().GetName () << " has no DataRate to share");
+  m_device = device;
+  m_nominalRate = rate.Get ();
+}
+
+void
+FluidLinkLoad::AddRate (double delta)
+{
+  if (m_load == 0)
+    {
+      // unloaded, the rate of the device is the nominal one
+      DataRateValue rate;
+      m_device->GetAttribute ("DataRate", rate);
+      m_nominalRate = rate.Get ();
+    }
+  m_load = std::max (0.0, m_load + delta);
+  double nominal = static_cast<double> (m_nominalRate.GetBitRate ());
+  double residual = std::max (nominal - m_load, nominal * m_minResidualFraction);
+  DataRate rate (static_cast<uint64_t> (residual));
+  NS_LOG_LOGIC ("load " << m_load << " bit/s, " << rate.GetBitRate () << " bit/s left to the packets");
+  m_device->SetAttribute ("DataRate", DataRateValue (rate));
+  m_loadTrace (m_load, rate);
+}
+
+double
+FluidLinkLoad::GetLoad (void) const
+{
+  return m_load;
+}
+
+DataRate
+FluidLinkLoad::GetNominalRate (void) const
+{
+  return m_nominalRate;
+}
+
+} // namespace ns3
@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLUID_LINK_LOAD_H
+#define FLUID_LINK_LOAD_H
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/data-rate.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+class NetDevice;
+
+/**
+ * \ingroup PPBP
+ * \brief Background load of a link, accounted for as a fluid
+ *
+ * Aggregated to the transmitting NetDevice of a link, it sums the rates of
+ * the fluid background flows crossing it and gives the packets left the
+ * remaining capacity: the DataRate attribute of the device is set to the
+ * nominal rate minus the load, never below MinResidualFraction of it.
+ *
+ * The nominal rate is read from the device whenever the link is unloaded,
+ * so it may be set after AddFluidDevice, but not while a background flow
+ * crossing the link is active.
+ */
+class FluidLinkLoad : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  FluidLinkLoad ();
+  virtual ~FluidLinkLoad ();
+
+  /**
+   * \param device a device with a DataRate attribute
+   * \return the load aggregated to the device, created the first time
+   */
+  static Ptr<FluidLinkLoad> GetOrCreate (Ptr<NetDevice> device);
+
+  /**
+   * \param delta the change of the rate of a flow crossing the link, in bit/s
+   */
+  void AddRate (double delta);
+
+  /**
+   * \return the background load in bit/s
+   */
+  double GetLoad (void) const;
+
+  DataRate GetNominalRate (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  void Attach (Ptr<NetDevice> device);
+
+  Ptr<NetDevice> m_device;
+  DataRate m_nominalRate;
+  double m_load;
+  double m_minResidualFraction;
+
+  /// the background load (bit/s) and the rate left to the packets
+  TracedCallback<double, DataRate> m_loadTrace;
+};
+
+} // namespace ns3
+
+#endif /* FLUID_LINK_LOAD_H */
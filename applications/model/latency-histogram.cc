@@ -0,0 +1,166 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "latency-histogram.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LatencyHistogram");
+
+LatencyHistogram::LatencyHistogram (uint32_t bits)
+  : m_bits (bits),
+    m_subBuckets (1ULL << bits)
+{
+  NS_ASSERT_MSG (bits > 0 && bits < 32, "unsupported precision " << bits);
+  Reset ();
+}
+
+void
+LatencyHistogram::Reset (void)
+{
+  m_counts.clear ();
+  m_count = 0;
+  m_min = 0;
+  m_max = 0;
+  m_sum = 0;
+}
+
+uint32_t
+LatencyHistogram::GetIndex (uint64_t value) const
+{
+  if (value < 2 * m_subBuckets)
+    {
+      return (uint32_t) value;
+    }
+  // shift the value to [2^bits, 2^(bits+1)): the bucket of its shift
+  uint32_t msb = 0;
+  for (uint64_t v = value; v > 1; v >>= 1)
+    {
+      ++msb;
+    }
+  uint32_t shift = msb - m_bits;
+  return (uint32_t) (shift * m_subBuckets + (value >> shift));
+}
+
+uint64_t
+LatencyHistogram::GetLowerBound (uint32_t index) const
+{
+  if (index < 2 * m_subBuckets)
+    {
+      return index;
+    }
+  uint32_t shift = (uint32_t) (index / m_subBuckets) - 1;
+  return (index - shift * m_subBuckets) << shift;
+}
+
+uint64_t
+LatencyHistogram::GetWidth (uint32_t index) const
+{
+  if (index < 2 * m_subBuckets)
+    {
+      return 1;
+    }
+  return 1ULL << ((uint32_t) (index / m_subBuckets) - 1);
+}
+
+void
+LatencyHistogram::Record (uint64_t value)
+{
+  uint32_t index = GetIndex (value);
+  if (index >= m_counts.size ())
+    {
+      m_counts.resize (index + 1, 0);
+    }
+  ++m_counts[index];
+  if (m_count == 0 || value < m_min)
+    {
+      m_min = value;
+    }
+  if (value > m_max)
+    {
+      m_max = value;
+    }
+  ++m_count;
+  m_sum += value;
+}
+
+uint64_t
+LatencyHistogram::GetCount (void) const
+{
+  return m_count;
+}
+
+uint64_t
+LatencyHistogram::GetMin (void) const
+{
+  return m_min;
+}
+
+uint64_t
+LatencyHistogram::GetMax (void) const
+{
+  return m_max;
+}
+
+double
+LatencyHistogram::GetMean (void) const
+{
+  return (m_count > 0) ? m_sum / m_count : 0;
+}
+
+uint64_t
+LatencyHistogram::GetValueAtPercentile (double p) const
+{
+  if (m_count == 0)
+    {
+      return 0;
+    }
+  uint64_t rank = (uint64_t) std::ceil (p / 100.0 * m_count);
+  if (rank == 0)
+    {
+      rank = 1;
+    }
+  uint64_t seen = 0;
+  for (uint32_t index = 0; index < m_counts.size (); ++index)
+    {
+      seen += m_counts[index];
+      if (seen >= rank)
+        {
+          uint64_t value = GetLowerBound (index) + GetWidth (index) / 2;
+          // the middle of the bucket may lie beyond what was recorded
+          return (value < m_min) ? m_min : ((value > m_max) ? m_max : value);
+        }
+    }
+  return m_max;
+}
+
+void
+LatencyHistogram::PrintBuckets (std::ostream &os) const
+{
+  for (uint32_t index = 0; index < m_counts.size (); ++index)
+    {
+      if (m_counts[index] > 0)
+        {
+          uint64_t lower = GetLowerBound (index);
+          os << lower << "\t" << lower + GetWidth (index) << "\t" << m_counts[index] << "\n";
+        }
+    }
+}
+
+} // namespace ns3
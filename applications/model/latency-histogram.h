@@ -0,0 +1,79 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <ostream>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup udpecho
+ * \brief Histogram of latencies with a bounded relative error (HDR-style)
+ *
+ * Values below 2^(bits+1) have a bucket each; above, each power of two is
+ * split in 2^bits buckets, so that a value is known within 1/2^bits of
+ * itself whatever its magnitude, and recording costs a shift and an
+ * increment. The buckets are allocated up to the largest value recorded.
+ */
+class LatencyHistogram
+{
+public:
+  /**
+   * \param bits the number of significant bits kept of each value
+   */
+  LatencyHistogram (uint32_t bits = 7);
+
+  void Record (uint64_t value);
+  void Reset (void);
+
+  uint64_t GetCount (void) const;
+  uint64_t GetMin (void) const;
+  uint64_t GetMax (void) const;
+  double GetMean (void) const;
+
+  /**
+   * \param p a percentile in [0, 100]
+   * \return the middle of the bucket holding the value at the percentile,
+   * 0 if nothing was recorded
+   */
+  uint64_t GetValueAtPercentile (double p) const;
+
+  /**
+   * Write "lower bound, upper bound, count" for each non empty bucket
+   */
+  void PrintBuckets (std::ostream &os) const;
+
+private:
+  uint32_t GetIndex (uint64_t value) const;
+  uint64_t GetLowerBound (uint32_t index) const;
+  uint64_t GetWidth (uint32_t index) const;
+
+  uint32_t m_bits;
+  uint64_t m_subBuckets;          ///< 2^bits
+  std::vector<uint64_t> m_counts;
+  uint64_t m_count;
+  uint64_t m_min;
+  uint64_t m_max;
+  double m_sum;
+};
+
+} // namespace ns3
+
+#endif /* LATENCY_HISTOGRAM_H */
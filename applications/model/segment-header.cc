@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "segment-header.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SegmentHeader");
+
+NS_OBJECT_ENSURE_REGISTERED (SegmentHeader);
+
+SegmentHeader::SegmentHeader ()
+  : m_segment (0),
+    m_finalSegment (0),
+    m_objectSize (0)
+{
+}
+
+TypeId
+SegmentHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SegmentHeader")
+    .SetParent<Header> ()
+    .AddConstructor<SegmentHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+SegmentHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+SegmentHeader::GetSerializedSize (void) const
+{
+  return 12;
+}
+
+void
+SegmentHeader::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteHtonU32 (m_segment);
+  i.WriteHtonU32 (m_finalSegment);
+  i.WriteHtonU32 (m_objectSize);
+}
+
+uint32_t
+SegmentHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_segment = i.ReadNtohU32 ();
+  m_finalSegment = i.ReadNtohU32 ();
+  m_objectSize = i.ReadNtohU32 ();
+  return GetSerializedSize ();
+}
+
+void
+SegmentHeader::Print (std::ostream &os) const
+{
+  os << "Segment=" << m_segment << "/" << m_finalSegment
+     << " ObjectSize=" << m_objectSize;
+}
+
+uint32_t
+SegmentHeader::GetSegment (void) const
+{
+  return m_segment;
+}
+
+void
+SegmentHeader::SetSegment (uint32_t segment)
+{
+  m_segment = segment;
+}
+
+uint32_t
+SegmentHeader::GetFinalSegment (void) const
+{
+  return m_finalSegment;
+}
+
+void
+SegmentHeader::SetFinalSegment (uint32_t finalSegment)
+{
+  m_finalSegment = finalSegment;
+}
+
+uint32_t
+SegmentHeader::GetObjectSize (void) const
+{
+  return m_objectSize;
+}
+
+void
+SegmentHeader::SetObjectSize (uint32_t objectSize)
+{
+  m_objectSize = objectSize;
+}
+
+} // namespace ns3
@@ -0,0 +1,68 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SEGMENT_HEADER_H
+#define SEGMENT_HEADER_H
+
+#include "ns3/header.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup udpecho
+ * \brief Header at the front of the payload of a segment of an object
+ *
+ * An object larger than a packet is served as the contents
+ * /<prefix>/<object>/<segment>, segment 0 to FinalSegment. The header
+ * travels in the payload so that the caches of the eNBs and of the
+ * SGW/PGW keep it with the content.
+ */
+class SegmentHeader : public Header
+{
+public:
+  SegmentHeader ();
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+  uint32_t GetSegment (void) const;
+  void SetSegment (uint32_t segment);
+
+  /**
+   * \return the number of the last segment of the object
+   */
+  uint32_t GetFinalSegment (void) const;
+  void SetFinalSegment (uint32_t finalSegment);
+
+  /**
+   * \return the size of the whole object in bytes
+   */
+  uint32_t GetObjectSize (void) const;
+  void SetObjectSize (uint32_t objectSize);
+
+private:
+  uint32_t m_segment;
+  uint32_t m_finalSegment;
+  uint32_t m_objectSize;
+};
+
+} // namespace ns3
+
+#endif /* SEGMENT_HEADER_H */
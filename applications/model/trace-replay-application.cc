@@ -0,0 +1,230 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "trace-replay-application.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+#include "ns3/socket-factory.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/packet.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/trace-source-accessor.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TraceReplayApplication");
+
+NS_OBJECT_ENSURE_REGISTERED (TraceReplayApplication);
+
+TypeId
+TraceReplayApplication::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TraceReplayApplication")
+    .SetParent<Application> ()
+    .AddConstructor<TraceReplayApplication> ()
+    .AddAttribute ("TraceFile",
+                   "The trace to replay, see TraceReplayFile",
+                   StringValue (""),
+                   MakeStringAccessor (&TraceReplayApplication::m_traceFilename),
+                   MakeStringChecker ())
+    .AddAttribute ("Remote", "The address of the destination",
+                   AddressValue (),
+                   MakeAddressAccessor (&TraceReplayApplication::m_peer),
+                   MakeAddressChecker ())
+    .AddAttribute ("Protocol", "The type of protocol to use.",
+                   TypeIdValue (UdpSocketFactory::GetTypeId ()),
+                   MakeTypeIdAccessor (&TraceReplayApplication::m_protocolTid),
+                   MakeTypeIdChecker ())
+    .AddAttribute ("TimeScale",
+                   "Factor applied to the times of the trace, 0.5 to replay it twice as fast; "
+                   "must be positive",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&TraceReplayApplication::m_timeScale),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Loop", "Start the trace over when it ends",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TraceReplayApplication::m_loop),
+                   MakeBooleanChecker ())
+    .AddAttribute ("FlowCount",
+                   "Number of shares the flows of the trace are split into",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&TraceReplayApplication::m_flowCount),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("FlowIndex",
+                   "Share of the flows replayed, those whose id modulo FlowCount is FlowIndex",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TraceReplayApplication::m_flowIndex),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxPacketSize",
+                   "Size the packets of the trace are cut to",
+                   UintegerValue (1472),
+                   MakeUintegerAccessor (&TraceReplayApplication::m_maxPacketSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddTraceSource ("Tx", "A new packet is created and is sent",
+                     MakeTraceSourceAccessor (&TraceReplayApplication::m_txTrace))
+  ;
+  return tid;
+}
+
+TraceReplayApplication::TraceReplayApplication ()
+  : m_socket (0),
+    m_index (0),
+    m_loops (0),
+    m_totalBytes (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TraceReplayApplication::~TraceReplayApplication ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+TraceReplayApplication::GetTotalBytes (void) const
+{
+  return m_totalBytes;
+}
+
+void
+TraceReplayApplication::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_socket = 0;
+  m_trace = 0;
+  Application::DoDispose ();
+}
+
+void
+TraceReplayApplication::StartApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (m_traceFilename.empty (), "TraceReplayApplication without a TraceFile");
+  NS_ABORT_MSG_UNLESS (m_flowIndex < m_flowCount, "FlowIndex " << m_flowIndex << " of " << m_flowCount);
+  NS_ABORT_MSG_UNLESS (m_timeScale > 0, "TimeScale " << m_timeScale << " would replay the trace in no time");
+
+  if (m_socket == 0)
+    {
+      m_socket = Socket::CreateSocket (GetNode (), m_protocolTid);
+      m_socket->Bind ();
+      m_socket->Connect (m_peer);
+    }
+  m_trace = TraceReplayFile::Get (m_traceFilename);
+  m_start = Simulator::Now ();
+  m_index = 0;
+  m_loops = 0;
+  if (m_trace->GetN () == 0)
+    {
+      NS_LOG_WARN ("empty trace " << m_traceFilename);
+      return;
+    }
+  if (m_trace->GetFlowId (0) % m_flowCount != m_flowIndex && !NextRecord ())
+    {
+      NS_LOG_WARN ("no flow of share " << m_flowIndex << " in " << m_traceFilename);
+      return;
+    }
+  ScheduleNext ();
+}
+
+void
+TraceReplayApplication::StopApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  Simulator::Cancel (m_sendEvent);
+  if (m_socket != 0)
+    {
+      m_socket->Close ();
+    }
+}
+
+bool
+TraceReplayApplication::NextRecord (void)
+{
+  uint64_t n = m_trace->GetN ();
+  // at most a whole round of the trace without a record of the share
+  for (uint64_t scanned = 0; scanned < n; ++scanned)
+    {
+      if (++m_index == n)
+        {
+          // a round lasts the trace and the mean gap between its packets
+          if (!m_loop || n < 2 || m_trace->GetDuration () == 0)
+            {
+              return false;
+            }
+          m_index = 0;
+          ++m_loops;
+        }
+      if (m_trace->GetFlowId (m_index) % m_flowCount == m_flowIndex)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+Time
+TraceReplayApplication::GetRecordTime (void) const
+{
+  double ns = m_trace->GetTimestamp (m_index);
+  if (m_loops > 0)
+    {
+      uint64_t n = m_trace->GetN ();
+      ns += m_loops * (m_trace->GetDuration () * (double) n / (n - 1));
+    }
+  return m_start + NanoSeconds ((int64_t) (ns * m_timeScale));
+}
+
+void
+TraceReplayApplication::ScheduleNext (void)
+{
+  Time next = GetRecordTime ();
+  Time now = Simulator::Now ();
+  m_sendEvent = Simulator::Schedule ((next > now) ? next - now : Seconds (0),
+                                     &TraceReplayApplication::Send, this);
+}
+
+void
+TraceReplayApplication::Send (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time now = Simulator::Now ();
+  // at most a round of the trace per event, however small the TimeScale
+  uint64_t sent = 0;
+  do
+    {
+      uint32_t size = std::min (m_trace->GetSize (m_index), m_maxPacketSize);
+      Ptr<Packet> packet = Create<Packet> (size);
+      m_txTrace (packet);
+      m_socket->Send (packet);
+      m_totalBytes += size;
+      NS_LOG_LOGIC ("record " << m_index << ", flow " << m_trace->GetFlowId (m_index) << ": " << size << " bytes");
+      if (!NextRecord ())
+        {
+          NS_LOG_INFO ("end of " << m_traceFilename << ", " << m_totalBytes << " bytes sent");
+          return;
+        }
+    }
+  while (++sent < m_trace->GetN () && GetRecordTime () <= now);
+  ScheduleNext ();
+}
+
+} // namespace ns3
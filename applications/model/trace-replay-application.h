@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACE_REPLAY_APPLICATION_H
+#define TRACE_REPLAY_APPLICATION_H
+
+#include "ns3/application.h"
+#include "ns3/address.h"
+#include "ns3/event-id.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+#include "trace-replay-file.h"
+
+namespace ns3 {
+
+class Socket;
+class Packet;
+
+/**
+ * \ingroup applications
+ * \brief Background traffic replaying a packet trace
+ *
+ * Sends a packet of the size of each record of a TraceReplayFile at the
+ * time of the record since the start of the application, the inter-packet
+ * times multiplied by TimeScale. The application replays the records whose
+ * flow id modulo FlowCount is FlowIndex, so that the flows of one trace can
+ * be spread over several nodes, and goes back to the first record when the
+ * trace ends if Loop is set.
+ *
+ * The records due at the same time are sent by the same event, and a
+ * single event is pending whatever the size of the trace.
+ */
+class TraceReplayApplication : public Application
+{
+public:
+  static TypeId GetTypeId (void);
+
+  TraceReplayApplication ();
+  virtual ~TraceReplayApplication ();
+
+  /**
+   * \return the number of bytes sent
+   */
+  uint64_t GetTotalBytes (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  virtual void StartApplication (void);
+  virtual void StopApplication (void);
+
+  /**
+   * Move m_index to the next record of the flows of the application,
+   * wrapping around in Loop mode.
+   *
+   * \return false when the replay is over
+   */
+  bool NextRecord (void);
+
+  /**
+   * \return the time at which the record m_index is due
+   */
+  Time GetRecordTime (void) const;
+
+  void ScheduleNext (void);
+  void Send (void);
+
+  Ptr<TraceReplayFile> m_trace;
+  Ptr<Socket> m_socket;
+  EventId m_sendEvent;
+
+  std::string m_traceFilename;
+  Address m_peer;
+  TypeId m_protocolTid;
+  double m_timeScale;
+  bool m_loop;
+  uint32_t m_flowCount;
+  uint32_t m_flowIndex;
+  uint32_t m_maxPacketSize;
+
+  uint64_t m_index;       ///< next record to replay
+  uint64_t m_loops;       ///< number of times the trace went round
+  Time m_start;           ///< time of the first record
+  uint64_t m_totalBytes;
+
+  TracedCallback<Ptr<const Packet> > m_txTrace;
+};
+
+} // namespace ns3
+
+#endif /* TRACE_REPLAY_APPLICATION_H */
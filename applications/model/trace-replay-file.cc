@@ -0,0 +1,249 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "trace-replay-file.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/pcap-file.h"
+#include <fstream>
+#include <map>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TraceReplayFile");
+
+static const uint32_t TRACE_REPLAY_MAGIC = 0x5052534e; // "NSRP"
+static const uint32_t TRACE_REPLAY_VERSION = 1;
+static const uint32_t TRACE_REPLAY_HEADER_SIZE = 16;
+static const uint32_t TRACE_REPLAY_RECORD_SIZE = 16;
+
+// the pcap link types with an IPv4 header at a known offset
+static const uint32_t PCAP_LINKTYPE_ETHERNET = 1;
+static const uint32_t PCAP_LINKTYPE_RAW = 101;
+
+static uint32_t
+ReadLe32 (const uint8_t *p)
+{
+  return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint64_t
+ReadLe64 (const uint8_t *p)
+{
+  return (uint64_t) ReadLe32 (p) | ((uint64_t) ReadLe32 (p + 4) << 32);
+}
+
+static void
+WriteLe32 (uint8_t *p, uint32_t v)
+{
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      p[i] = (v >> (8 * i)) & 0xff;
+    }
+}
+
+static void
+WriteLe64 (uint8_t *p, uint64_t v)
+{
+  WriteLe32 (p, v & 0xffffffff);
+  WriteLe32 (p + 4, v >> 32);
+}
+
+TraceReplayFile::TraceReplayFile (std::string filename)
+  : m_filename (filename),
+    m_data (0),
+    m_length (0),
+    m_n (0)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  int fd = open (filename.c_str (), O_RDONLY);
+  NS_ABORT_MSG_IF (fd < 0, "Can't open trace file " << filename);
+  struct stat st;
+  NS_ABORT_MSG_IF (fstat (fd, &st) < 0, "Can't stat trace file " << filename);
+  m_length = st.st_size;
+  NS_ABORT_MSG_IF (m_length < TRACE_REPLAY_HEADER_SIZE, "Trace file " << filename << " too short");
+
+  void *data = mmap (0, m_length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  NS_ABORT_MSG_IF (data == MAP_FAILED, "Can't map trace file " << filename);
+  m_data = static_cast<const uint8_t *> (data);
+  // the replay goes through the records once, in order
+  madvise (data, m_length, MADV_SEQUENTIAL);
+
+  NS_ABORT_MSG_UNLESS (ReadLe32 (m_data) == TRACE_REPLAY_MAGIC, filename << " is not a replay trace");
+  NS_ABORT_MSG_UNLESS (ReadLe32 (m_data + 4) == TRACE_REPLAY_VERSION,
+                       "Unsupported version " << ReadLe32 (m_data + 4) << " of trace file " << filename);
+  m_n = ReadLe64 (m_data + 8);
+  NS_ABORT_MSG_IF (m_n > (m_length - TRACE_REPLAY_HEADER_SIZE) / TRACE_REPLAY_RECORD_SIZE,
+                   "Trace file " << filename << " truncated, " << m_n << " records expected");
+  NS_LOG_INFO (filename << ": " << m_n << " records over " << GetDuration () << " ns");
+}
+
+TraceReplayFile::~TraceReplayFile ()
+{
+  NS_LOG_FUNCTION (this);
+  munmap (const_cast<uint8_t *> (m_data), m_length);
+}
+
+Ptr<TraceReplayFile>
+TraceReplayFile::Get (std::string filename)
+{
+  static std::map<std::string, Ptr<TraceReplayFile> > files;
+  Ptr<TraceReplayFile> &file = files[filename];
+  if (file == 0)
+    {
+      file = Create<TraceReplayFile> (filename);
+    }
+  return file;
+}
+
+uint64_t
+TraceReplayFile::ConvertPcap (std::string pcapFilename, std::string traceFilename)
+{
+  NS_LOG_FUNCTION (pcapFilename << traceFilename);
+
+  PcapFile pcap;
+  pcap.Open (pcapFilename, std::ios::in);
+  NS_ABORT_MSG_IF (pcap.Fail (), "Can't open capture " << pcapFilename);
+  // offset of the IPv4 header in a captured frame
+  uint32_t linkOffset;
+  switch (pcap.GetDataLinkType ())
+    {
+    case PCAP_LINKTYPE_ETHERNET:
+      linkOffset = 14;
+      break;
+    case PCAP_LINKTYPE_RAW:
+      linkOffset = 0;
+      break;
+    default:
+      NS_LOG_WARN ("Link type " << pcap.GetDataLinkType () << " of " << pcapFilename << ", flow ids set to 0");
+      linkOffset = 0xffffffff;
+      break;
+    }
+
+  std::ofstream out (traceFilename.c_str (), std::ios::out | std::ios::binary);
+  NS_ABORT_MSG_UNLESS (out.is_open (), "Can't open trace file " << traceFilename);
+  uint8_t header[TRACE_REPLAY_HEADER_SIZE];
+  WriteLe32 (header, TRACE_REPLAY_MAGIC);
+  WriteLe32 (header + 4, TRACE_REPLAY_VERSION);
+  WriteLe64 (header + 8, 0);
+  out.write ((const char *) header, TRACE_REPLAY_HEADER_SIZE);
+
+  std::vector<uint8_t> frame (pcap.GetSnapLen ());
+  uint64_t n = 0;
+  uint64_t first = 0;
+  while (true)
+    {
+      uint32_t tsSec, tsUsec, inclLen, origLen, readLen;
+      pcap.Read (&frame[0], frame.size (), tsSec, tsUsec, inclLen, origLen, readLen);
+      if (pcap.Eof () || pcap.Fail ())
+        {
+          break;
+        }
+      uint64_t ts = tsSec * 1000000000ULL + tsUsec * 1000ULL;
+      if (n == 0)
+        {
+          first = ts;
+        }
+
+      uint32_t flowId = 0;
+      if (linkOffset != 0xffffffff && readLen >= linkOffset + 20
+          && (linkOffset == 0 || (frame[12] == 0x08 && frame[13] == 0x00))
+          && (frame[linkOffset] >> 4) == 4)
+        {
+          // FNV-1a of the addresses, the protocol and the ports
+          const uint8_t *ip = &frame[linkOffset];
+          uint32_t ihl = (ip[0] & 0x0f) * 4;
+          uint32_t keyLength = (readLen >= linkOffset + ihl + 4) ? 13 : 9;
+          uint8_t key[13];
+          for (uint32_t i = 0; i < 8; ++i)
+            {
+              key[i] = ip[12 + i];
+            }
+          key[8] = ip[9];
+          for (uint32_t i = 9; i < keyLength; ++i)
+            {
+              key[i] = ip[ihl + i - 9];
+            }
+          flowId = 2166136261U;
+          for (uint32_t i = 0; i < keyLength; ++i)
+            {
+              flowId = (flowId ^ key[i]) * 16777619U;
+            }
+        }
+
+      uint8_t record[TRACE_REPLAY_RECORD_SIZE];
+      WriteLe64 (record, (ts > first) ? ts - first : 0);
+      WriteLe32 (record + 8, flowId);
+      WriteLe32 (record + 12, origLen);
+      out.write ((const char *) record, TRACE_REPLAY_RECORD_SIZE);
+      ++n;
+    }
+  pcap.Close ();
+
+  WriteLe64 (header + 8, n);
+  out.seekp (0);
+  out.write ((const char *) header, TRACE_REPLAY_HEADER_SIZE);
+  out.close ();
+  NS_LOG_INFO (pcapFilename << ": " << n << " records written to " << traceFilename);
+  return n;
+}
+
+uint64_t
+TraceReplayFile::GetN (void) const
+{
+  return m_n;
+}
+
+const uint8_t *
+TraceReplayFile::GetRecord (uint64_t i) const
+{
+  NS_ASSERT_MSG (i < m_n, "record " << i << " of " << m_n);
+  return m_data + TRACE_REPLAY_HEADER_SIZE + i * TRACE_REPLAY_RECORD_SIZE;
+}
+
+uint64_t
+TraceReplayFile::GetTimestamp (uint64_t i) const
+{
+  return ReadLe64 (GetRecord (i));
+}
+
+uint32_t
+TraceReplayFile::GetFlowId (uint64_t i) const
+{
+  return ReadLe32 (GetRecord (i) + 8);
+}
+
+uint32_t
+TraceReplayFile::GetSize (uint64_t i) const
+{
+  return ReadLe32 (GetRecord (i) + 12);
+}
+
+uint64_t
+TraceReplayFile::GetDuration (void) const
+{
+  return (m_n > 0) ? GetTimestamp (m_n - 1) : 0;
+}
+
+} // namespace ns3
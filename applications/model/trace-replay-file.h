@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACE_REPLAY_FILE_H
+#define TRACE_REPLAY_FILE_H
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/ptr.h"
+#include <string>
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \brief Read-only packet trace mapped in memory
+ *
+ * The trace is a 16 byte header, the magic "NSRP", the version (1) and the
+ * number of records, followed by one 16 byte record per packet: the time
+ * since the first packet in nanoseconds (uint64), the flow id (uint32) and
+ * the size of the packet on the wire (uint32), all little endian and in
+ * time order. ConvertPcap builds such a trace from a capture.
+ *
+ * The file is mapped and not read: the pages are brought in by the system
+ * as the replay goes through them and can be dropped again behind it, so
+ * that a trace of several gigabytes costs no more memory than the pages
+ * being replayed.
+ */
+class TraceReplayFile : public SimpleRefCount<TraceReplayFile>
+{
+public:
+  TraceReplayFile (std::string filename);
+  ~TraceReplayFile ();
+
+  /**
+   * The applications replaying the same file share a single mapping.
+   *
+   * \return the trace of the given file
+   */
+  static Ptr<TraceReplayFile> Get (std::string filename);
+
+  /**
+   * Write the trace of a pcap capture. The flow id of a packet is a hash of
+   * its IPv4 addresses, protocol and ports for the Ethernet and raw IP
+   * captures, 0 otherwise.
+   *
+   * \param pcapFilename the capture to convert
+   * \param traceFilename the trace to write
+   * \return the number of records written
+   */
+  static uint64_t ConvertPcap (std::string pcapFilename, std::string traceFilename);
+
+  uint64_t GetN (void) const;
+
+  /**
+   * \param i the index of a record
+   * \return the time of the packet since the first one, in nanoseconds
+   */
+  uint64_t GetTimestamp (uint64_t i) const;
+  uint32_t GetFlowId (uint64_t i) const;
+  uint32_t GetSize (uint64_t i) const;
+
+  /**
+   * \return the time of the last packet since the first one, in nanoseconds
+   */
+  uint64_t GetDuration (void) const;
+
+private:
+  const uint8_t *GetRecord (uint64_t i) const;
+
+  std::string m_filename;
+  const uint8_t *m_data; ///< the mapped file
+  uint64_t m_length;     ///< length of the mapping, in bytes
+  uint64_t m_n;          ///< number of records
+};
+
+} // namespace ns3
+
+#endif /* TRACE_REPLAY_FILE_H */
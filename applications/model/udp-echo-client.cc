@@ -35,6 +35,11 @@
 #include <stdlib.h> // edit
 #include <stdio.h> // edit
 #include "ns3/string.h" // edit
+#include "ns3/double.h" // edit
+#include "ns3/enum.h" // edit
+#include "ns3/boolean.h" // edit
+#include <algorithm> // edit
+#include <cmath> // edit
 
 namespace ns3 {
 
@@ -76,6 +81,142 @@ UdpEchoClient::GetTypeId (void)
                    StringValue ("simulation"),
                    MakeStringAccessor (&UdpEchoClient::m_simName),
                    MakeStringChecker ())
+    .AddAttribute ("RequestMode",
+                   "How the content requested by each Interest is chosen: in sequence, "
+                   "or drawn from a catalog of CatalogSize items",
+                   EnumValue (REQUEST_SEQUENTIAL),
+                   MakeEnumAccessor (&UdpEchoClient::m_requestMode),
+                   MakeEnumChecker (REQUEST_SEQUENTIAL, "Sequential",
+                                    REQUEST_CATALOG,    "Catalog"))
+    .AddAttribute ("CatalogSize",
+                   "The number of contents of the catalog",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&UdpEchoClient::m_catalogSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("ZipfExponent",
+                   "The exponent alpha of the popularity law, the content of rank i "
+                   "being requested with a probability proportional to 1/(i+1+q)^alpha",
+                   DoubleValue (0.8),
+                   MakeDoubleAccessor (&UdpEchoClient::m_zipfExponent),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("ZipfPlateau",
+                   "The plateau q of the Mandelbrot-Zipf law, 0 for a pure Zipf law",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&UdpEchoClient::m_zipfPlateau),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TemporalLocality",
+                   "The probability that an Interest asks again for one of the last "
+                   "RecentWindow contents drawn from the catalog",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&UdpEchoClient::m_temporalLocality),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("RecentWindow",
+                   "The number of contents remembered for the temporal locality",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&UdpEchoClient::m_recentWindow),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("PopularityDriftInterval",
+                   "Every interval of simulation time, the popularity ranking shifts by "
+                   "PopularityDriftStep contents, the same for every client. 0 for no drift.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&UdpEchoClient::m_driftInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("PopularityDriftStep",
+                   "The number of contents the popularity ranking shifts by at each drift",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&UdpEchoClient::m_driftStep),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("ConsumerMode",
+                   "Interval: one Interest every Interval. Window: as many Interests in "
+                   "flight as the congestion window allows, retransmitted on timeout.",
+                   EnumValue (CONSUMER_INTERVAL),
+                   MakeEnumAccessor (&UdpEchoClient::m_consumerMode),
+                   MakeEnumChecker (CONSUMER_INTERVAL, "Interval",
+                                    CONSUMER_WINDOW,   "Window"))
+    .AddAttribute ("CongestionControl",
+                   "How the congestion window of the Window mode is controlled",
+                   EnumValue (CC_AIMD),
+                   MakeEnumAccessor (&UdpEchoClient::m_congestionControl),
+                   MakeEnumChecker (CC_AIMD,  "Aimd",
+                                    CC_CUBIC, "Cubic"))
+    .AddAttribute ("InitialWindow",
+                   "The initial congestion window, in Interests",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&UdpEchoClient::m_initialWindow),
+                   MakeDoubleChecker<double> (1.0))
+    .AddAttribute ("MaxWindow",
+                   "The largest congestion window, in Interests",
+                   DoubleValue (256.0),
+                   MakeDoubleAccessor (&UdpEchoClient::m_maxWindow),
+                   MakeDoubleChecker<double> (1.0))
+    .AddAttribute ("AimdDecrease",
+                   "The factor applied to the window on timeout with Aimd",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&UdpEchoClient::m_aimdDecrease),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("CubicBeta",
+                   "The factor applied to the window on timeout with Cubic",
+                   DoubleValue (0.7),
+                   MakeDoubleAccessor (&UdpEchoClient::m_cubicBeta),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("CubicC",
+                   "The scaling constant of the cubic growth, in Interests/s^3",
+                   DoubleValue (0.4),
+                   MakeDoubleAccessor (&UdpEchoClient::m_cubicC),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("MaxRetransmissions",
+                   "The number of times a timed out Interest is sent again before the "
+                   "content is given up",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&UdpEchoClient::m_maxRetx),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("InitialRto",
+                   "The retransmission timeout before the first RTT sample",
+                   TimeValue (Seconds (1.0)),
+                   MakeTimeAccessor (&UdpEchoClient::m_initialRto),
+                   MakeTimeChecker ())
+    .AddAttribute ("MinRto",
+                   "The smallest retransmission timeout",
+                   TimeValue (MilliSeconds (200)),
+                   MakeTimeAccessor (&UdpEchoClient::m_minRto),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxRto",
+                   "The largest retransmission timeout, reached by exponential backoff",
+                   TimeValue (Seconds (8.0)),
+                   MakeTimeAccessor (&UdpEchoClient::m_maxRto),
+                   MakeTimeChecker ())
+    .AddAttribute ("SegmentedObjects",
+                   "Request objects every Interval, each fetched as the segments "
+                   "/video/<object>/<segment> and reassembled, instead of single contents",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&UdpEchoClient::m_segmented),
+                   MakeBooleanChecker ())
+    .AddAttribute ("SegmentWindow",
+                   "Number of segment Interests of an object in flight at once",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&UdpEchoClient::m_segmentWindow),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("PacketFiles",
+                   "Append a line per Interest and per content to the _TX.csv and _RX.csv files",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&UdpEchoClient::m_packetFiles),
+                   MakeBooleanChecker ())
+    .AddAttribute ("RawLatencySamples",
+                   "Also write every latency sample, not only the summary",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&UdpEchoClient::m_rawLatency),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LatencyTimeout",
+                   "Age after which an unanswered Interest is counted as timed out",
+                   TimeValue (Seconds (4.0)),
+                   MakeTimeAccessor (&UdpEchoClient::m_latencyTimeout),
+                   MakeTimeChecker ())
+    .AddTraceSource ("CongestionWindow", "The congestion window of the Window mode changed",
+                     MakeTraceSourceAccessor (&UdpEchoClient::m_cwndTrace))
+    .AddTraceSource ("Timeout", "An Interest of the Window mode timed out",
+                     MakeTraceSourceAccessor (&UdpEchoClient::m_timeoutTrace))
+    .AddTraceSource ("ObjectComplete", "All the segments of an object were received",
+                     MakeTraceSourceAccessor (&UdpEchoClient::m_objectTrace))
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&UdpEchoClient::m_txTrace))
   ;
@@ -91,6 +232,8 @@ UdpEchoClient::UdpEchoClient ()
   m_sendEvent = EventId ();
   m_data = 0;
   m_dataSize = 0;
+  m_rankRng = CreateObject<UniformRandomVariable> (); // edit
+  m_localityRng = CreateObject<UniformRandomVariable> (); // edit
 }
 
 UdpEchoClient::~UdpEchoClient()
@@ -127,6 +270,15 @@ UdpEchoClient::SetRemote (Ipv6Address ip, uint16_t port)
   m_peerPort = port;
 }
 
+int64_t
+UdpEchoClient::AssignStreams (int64_t stream) // edit
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_rankRng->SetStream (stream);
+  m_localityRng->SetStream (stream + 1);
+  return 2;
+}
+
 void
 UdpEchoClient::DoDispose (void)
 {
@@ -162,6 +314,33 @@ UdpEchoClient::StartApplication (void)
 
   m_socket->SetRecvCallback (MakeCallback (&UdpEchoClient::HandleRead, this));
 
+  if (m_requestMode == REQUEST_CATALOG) // edit
+    {
+      m_popularity = ZipfAliasTable::Get (m_catalogSize, m_zipfExponent, m_zipfPlateau);
+      m_recent.clear ();
+    }
+
+  // edit
+  m_cwnd = std::min (m_initialWindow, m_maxWindow);
+  m_ssthresh = m_maxWindow;
+  m_cubicWmax = 0;
+  m_cubicEpoch = Simulator::Now ();
+  m_lastDecrease = Simulator::Now ();
+  m_srtt = Seconds (0);
+  m_rttvar = Seconds (0);
+  m_rto = m_initialRto;
+
+  m_outstanding.clear (); // edit
+  m_outstandingOrder.clear ();
+  m_latency.Reset ();
+  m_latencySamples.clear ();
+  m_timeouts = 0;
+  m_duplicates = 0;
+  m_objects.clear ();
+  m_objectRecords.clear ();
+  m_objectLatency.Reset ();
+  m_objectsFailed = 0;
+
   ScheduleTransmit (Seconds (0.));
 }
 
@@ -178,6 +357,19 @@ UdpEchoClient::StopApplication ()
     }
 
   Simulator::Cancel (m_sendEvent);
+
+  for (std::map<uint32_t, PendingInterest>::iterator it = m_pending.begin (); it != m_pending.end (); ++it) // edit
+    {
+      Simulator::Cancel (it->second.m_timeout);
+    }
+  m_pending.clear ();
+
+  while (!m_objects.empty ()) // edit
+    {
+      CancelObject (m_objects.begin ()->first);
+    }
+
+  DumpLatency (); // edit
 }
 
 void
@@ -290,6 +482,35 @@ UdpEchoClient::ScheduleTransmit (Time dt)
   m_sendEvent = Simulator::Schedule (dt, &UdpEchoClient::Send, this);
 }
 
+uint32_t
+UdpEchoClient::NextContentId (void) // edit
+{
+  if (m_requestMode == REQUEST_SEQUENTIAL)
+    {
+      return m_sent;
+    }
+
+  if (!m_recent.empty () && m_localityRng->GetValue () < m_temporalLocality)
+    {
+      return m_recent[m_localityRng->GetInteger (0, m_recent.size () - 1)];
+    }
+
+  uint32_t rank = m_popularity->Sample (m_rankRng->GetValue (), m_rankRng->GetValue ());
+  uint64_t drift = 0;
+  if (!m_driftInterval.IsZero ())
+    {
+      drift = (Simulator::Now ().GetTimeStep () / m_driftInterval.GetTimeStep ()) * m_driftStep;
+    }
+  uint32_t contentId = (rank + drift) % m_catalogSize;
+
+  m_recent.push_back (contentId);
+  if (m_recent.size () > m_recentWindow)
+    {
+      m_recent.pop_front ();
+    }
+  return contentId;
+}
+
 void
 UdpEchoClient::Send (void)
 {
@@ -297,11 +518,41 @@ UdpEchoClient::Send (void)
 
   NS_ASSERT (m_sendEvent.IsExpired ());
 
+  if (m_segmented) // edit
+    {
+      StartObject (NextContentId ());
+    }
+  else if (m_consumerMode == CONSUMER_WINDOW) // edit
+    {
+      FillWindow ();
+      return;
+    }
+  else
+    {
+      SendInterest (NextContentId ()); // edit
+    }
+  ++m_sent;
+
+  if (m_sent < m_count)
+    {
+      ScheduleTransmit (m_interval);
+    }
+}
+
+void
+UdpEchoClient::SendInterest (uint32_t contentId, int64_t segment) // edit
+{
+  NS_LOG_FUNCTION (this << contentId << segment);
+
   Ptr<Packet> packet;
   ns3::ndn::Interest interestHeader;
 
   Ptr<ns3::ndn::Name> nameWithSequence = Create<ns3::ndn::Name> ("/video");
-  (*nameWithSequence) (m_sent);
+  (*nameWithSequence) (contentId); // edit
+  if (segment >= 0) // edit
+    {
+      (*nameWithSequence) (segment);
+    }
 
   interestHeader.SetName                (nameWithSequence);
 
@@ -313,6 +564,13 @@ UdpEchoClient::Send (void)
   m_txTrace (packet);
   m_socket->Send (packet);
 
+  // edit: latency from the first Interest, a retransmission keeps it
+  ExpireOutstanding ();
+  if (segment < 0 && m_outstanding.insert (std::make_pair (contentId, Simulator::Now ())).second)
+    {
+      m_outstandingOrder.push_back (std::make_pair (contentId, Simulator::Now ()));
+    }
+
   if (Ipv4Address::IsMatchingType (m_peerAddress))
     {
       NS_LOG_INFO ("Node ID: " << GetNode()->GetId ());
@@ -323,14 +581,11 @@ UdpEchoClient::Send (void)
       NS_LOG_INFO ("IP dest: " << Ipv4Address::ConvertFrom (m_peerAddress));
       NS_LOG_INFO ("Port: " << m_peerPort);
 
+      if (!m_packetFiles) // edit
+        {
+          return;
+        }
       ofstream out ((ueFileTx.str ()).c_str (), ios::app);
-//      out << " Sequence Number: " << m_sent <<
-//             " Tx time (s) " << Simulator::Now ().GetSeconds () <<
-//             " Interest name: " << interestHeader.GetName() <<
-//             " Interest size (Byte): " << packet->GetSize () <<
-//             " IP source: " << GetNode()->GetObject<Ipv4> ()->GetAddress(1,0).GetLocal() <<
-//             " IP dest: " << Ipv4Address::ConvertFrom (m_peerAddress) <<
-//             " Port: " << m_peerPort << endl;
       out << m_sent << "\t";
       std::list<std::string> myList = interestHeader.GetName().GetComponents();
       std::list<std::string>::iterator iter;
@@ -351,12 +606,377 @@ UdpEchoClient::Send (void)
       NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds () << "s client sent " << m_size << " bytes to " <<
                    Ipv6Address::ConvertFrom (m_peerAddress) << " port " << m_peerPort);
     }
+}
 
-  ++m_sent;
+void
+UdpEchoClient::FillWindow (void) // edit
+{
+  NS_LOG_FUNCTION (this << m_cwnd << m_pending.size ());
+  while (m_pending.size () < (uint32_t) m_cwnd && m_sent < m_count)
+    {
+      uint32_t contentId = NextContentId ();
+      ++m_sent;
+      if (m_pending.find (contentId) != m_pending.end ())
+        {
+          // already in flight: the same content answers both
+          continue;
+        }
+      PendingInterest &pending = m_pending[contentId];
+      pending.m_sendTime = Simulator::Now ();
+      pending.m_retx = 0;
+      pending.m_timeout = Simulator::Schedule (m_rto, &UdpEchoClient::OnTimeout, this, contentId);
+      SendInterest (contentId);
+    }
+}
 
-  if (m_sent < m_count)
+void
+UdpEchoClient::OnContent (uint32_t contentId) // edit
+{
+  std::map<uint32_t, PendingInterest>::iterator it = m_pending.find (contentId);
+  if (it == m_pending.end ())
     {
-      ScheduleTransmit (m_interval);
+      NS_LOG_LOGIC ("content " << contentId << " not pending, duplicate or given up");
+      return;
+    }
+  NS_LOG_FUNCTION (this << contentId);
+  Simulator::Cancel (it->second.m_timeout);
+  // Karn: the RTT of a retransmitted Interest is ambiguous
+  if (it->second.m_retx == 0)
+    {
+      RttSample (Simulator::Now () - it->second.m_sendTime);
+    }
+  m_pending.erase (it);
+  IncreaseWindow ();
+  FillWindow ();
+}
+
+void
+UdpEchoClient::StartObject (uint32_t objectId) // edit
+{
+  NS_LOG_FUNCTION (this << objectId);
+  if (m_objects.find (objectId) != m_objects.end ())
+    {
+      NS_LOG_LOGIC ("object " << objectId << " already being fetched");
+      return;
+    }
+  ObjectFetch &fetch = m_objects[objectId];
+  fetch.m_start = Simulator::Now ();
+  fetch.m_finalKnown = false;
+  fetch.m_finalSegment = 0;
+  fetch.m_nextSegment = 1;
+  fetch.m_segmentsReceived = 0;
+  fetch.m_bytes = 0;
+  SendSegment (objectId, 0);
+}
+
+void
+UdpEchoClient::FillSegments (uint32_t objectId) // edit
+{
+  ObjectFetch &fetch = m_objects[objectId];
+  while (fetch.m_finalKnown && fetch.m_nextSegment <= fetch.m_finalSegment
+         && fetch.m_inFlight.size () < m_segmentWindow)
+    {
+      uint32_t segment = fetch.m_nextSegment++;
+      if (!fetch.m_received[segment])
+        {
+          SendSegment (objectId, segment);
+        }
+    }
+}
+
+void
+UdpEchoClient::SendSegment (uint32_t objectId, uint32_t segment) // edit
+{
+  PendingInterest &pending = m_objects[objectId].m_inFlight[segment];
+  pending.m_sendTime = Simulator::Now ();
+  pending.m_retx = 0;
+  pending.m_timeout = Simulator::Schedule (m_rto, &UdpEchoClient::OnSegmentTimeout, this, objectId, segment);
+  SendInterest (objectId, segment);
+}
+
+void
+UdpEchoClient::OnSegment (uint32_t objectId, const SegmentHeader &segmentHeader, uint32_t payloadSize) // edit
+{
+  NS_LOG_FUNCTION (this << objectId << segmentHeader.GetSegment ());
+  std::map<uint32_t, ObjectFetch>::iterator objectIt = m_objects.find (objectId);
+  if (objectIt == m_objects.end ())
+    {
+      ++m_duplicates;
+      return;
+    }
+  ObjectFetch &fetch = objectIt->second;
+  uint32_t segment = segmentHeader.GetSegment ();
+  std::map<uint32_t, PendingInterest>::iterator it = fetch.m_inFlight.find (segment);
+  if (it == fetch.m_inFlight.end ())
+    {
+      ++m_duplicates;
+      return;
+    }
+  Simulator::Cancel (it->second.m_timeout);
+  if (it->second.m_retx == 0)
+    {
+      RttSample (Simulator::Now () - it->second.m_sendTime);
+    }
+  fetch.m_inFlight.erase (it);
+
+  if (!fetch.m_finalKnown)
+    {
+      fetch.m_finalKnown = true;
+      fetch.m_finalSegment = segmentHeader.GetFinalSegment ();
+      fetch.m_received.assign (fetch.m_finalSegment + 1, false);
+    }
+  if (segment > fetch.m_finalSegment || fetch.m_received[segment])
+    {
+      ++m_duplicates;
+      return;
+    }
+  fetch.m_received[segment] = true;
+  fetch.m_bytes += payloadSize;
+
+  if (++fetch.m_segmentsReceived <= fetch.m_finalSegment)
+    {
+      FillSegments (objectId);
+      return;
+    }
+
+  ObjectRecord record;
+  record.m_objectId = objectId;
+  record.m_start = fetch.m_start;
+  record.m_completion = Simulator::Now () - fetch.m_start;
+  record.m_bytes = fetch.m_bytes;
+  NS_LOG_INFO ("Object " << objectId << " of " << record.m_bytes << " bytes complete in "
+               << record.m_completion.GetSeconds () << "s");
+  m_objectLatency.Record (record.m_completion.GetMicroSeconds ());
+  m_objectRecords.push_back (record);
+  m_objects.erase (objectIt);
+  m_objectTrace (objectId, record.m_bytes, record.m_completion);
+}
+
+void
+UdpEchoClient::OnSegmentTimeout (uint32_t objectId, uint32_t segment) // edit
+{
+  NS_LOG_FUNCTION (this << objectId << segment);
+  PendingInterest &pending = m_objects[objectId].m_inFlight[segment];
+  m_timeoutTrace (objectId, pending.m_retx);
+  ++m_timeouts;
+  m_rto = std::min (m_rto + m_rto, m_maxRto);
+
+  if (pending.m_retx >= m_maxRetx)
+    {
+      NS_LOG_INFO ("Giving up object " << objectId << ": segment " << segment << " not received");
+      ++m_objectsFailed;
+      CancelObject (objectId);
+      return;
+    }
+  ++pending.m_retx;
+  pending.m_sendTime = Simulator::Now ();
+  pending.m_timeout = Simulator::Schedule (m_rto, &UdpEchoClient::OnSegmentTimeout, this, objectId, segment);
+  SendInterest (objectId, segment);
+}
+
+void
+UdpEchoClient::CancelObject (uint32_t objectId) // edit
+{
+  std::map<uint32_t, ObjectFetch>::iterator objectIt = m_objects.find (objectId);
+  NS_ASSERT (objectIt != m_objects.end ());
+  for (std::map<uint32_t, PendingInterest>::iterator it = objectIt->second.m_inFlight.begin ();
+       it != objectIt->second.m_inFlight.end (); ++it)
+    {
+      Simulator::Cancel (it->second.m_timeout);
+    }
+  m_objects.erase (objectIt);
+}
+
+void
+UdpEchoClient::OnTimeout (uint32_t contentId) // edit
+{
+  NS_LOG_FUNCTION (this << contentId);
+  std::map<uint32_t, PendingInterest>::iterator it = m_pending.find (contentId);
+  NS_ASSERT (it != m_pending.end ());
+  PendingInterest &pending = it->second;
+  m_timeoutTrace (contentId, pending.m_retx);
+
+  // one decrease per window of Interests: the ones sent before the last
+  // decrease were lost to the same congestion
+  if (pending.m_sendTime >= m_lastDecrease)
+    {
+      DecreaseWindow ();
+    }
+  m_rto = std::min (m_rto + m_rto, m_maxRto);
+
+  if (pending.m_retx >= m_maxRetx)
+    {
+      NS_LOG_INFO ("Giving up content " << contentId << " after " << pending.m_retx << " retransmissions");
+      m_pending.erase (it);
+      FillWindow ();
+      return;
+    }
+  ++pending.m_retx;
+  pending.m_sendTime = Simulator::Now ();
+  pending.m_timeout = Simulator::Schedule (m_rto, &UdpEchoClient::OnTimeout, this, contentId);
+  SendInterest (contentId);
+}
+
+void
+UdpEchoClient::RttSample (Time rtt) // edit
+{
+  NS_LOG_FUNCTION (this << rtt);
+  // RFC 6298, alpha = 1/8, beta = 1/4
+  double r = rtt.GetSeconds ();
+  double srtt = m_srtt.GetSeconds ();
+  double rttvar = m_rttvar.GetSeconds ();
+  if (m_srtt.IsZero ())
+    {
+      srtt = r;
+      rttvar = r / 2;
+    }
+  else
+    {
+      rttvar = 0.75 * rttvar + 0.25 * std::fabs (srtt - r);
+      srtt = 0.875 * srtt + 0.125 * r;
+    }
+  m_srtt = Seconds (srtt);
+  m_rttvar = Seconds (rttvar);
+  m_rto = std::min (std::max (Seconds (srtt + 4 * rttvar), m_minRto), m_maxRto);
+}
+
+void
+UdpEchoClient::TrackContent (uint32_t contentId) // edit
+{
+  std::map<uint32_t, Time>::iterator it = m_outstanding.find (contentId);
+  if (it == m_outstanding.end ())
+    {
+      // answered already, or counted as timed out
+      ++m_duplicates;
+      return;
+    }
+  int64_t latency = (Simulator::Now () - it->second).GetMicroSeconds ();
+  m_latency.Record (latency);
+  if (m_rawLatency)
+    {
+      m_latencySamples.push_back ((uint32_t) latency);
+    }
+  // its entry of m_outstandingOrder is dropped when it expires
+  m_outstanding.erase (it);
+}
+
+void
+UdpEchoClient::ExpireOutstanding (void) // edit
+{
+  Time oldest = Simulator::Now () - m_latencyTimeout;
+  while (!m_outstandingOrder.empty () && m_outstandingOrder.front ().second < oldest)
+    {
+      std::map<uint32_t, Time>::iterator it = m_outstanding.find (m_outstandingOrder.front ().first);
+      // the content may have been answered then requested again
+      if (it != m_outstanding.end () && it->second == m_outstandingOrder.front ().second)
+        {
+          ++m_timeouts;
+          m_outstanding.erase (it);
+        }
+      m_outstandingOrder.pop_front ();
+    }
+}
+
+void
+UdpEchoClient::DumpLatency (void) // edit
+{
+  NS_LOG_FUNCTION (this);
+  ExpireOutstanding ();
+
+  std::ostringstream fileName;
+  fileName << m_simName << "_" << GetNode ()->GetId () << "_LATENCY.csv";
+  ofstream out (fileName.str ().c_str ());
+  out << "% sent\treceived\tsamples\ttimeouts\tduplicates\toutstanding\t"
+         "min(us)\tmean(us)\tp50(us)\tp90(us)\tp99(us)\tp99.9(us)\tmax(us)\n";
+  out << m_sent << "\t" << m_received << "\t" << m_latency.GetCount () << "\t"
+      << m_timeouts << "\t" << m_duplicates << "\t" << m_outstanding.size () << "\t"
+      << m_latency.GetMin () << "\t" << m_latency.GetMean () << "\t"
+      << m_latency.GetValueAtPercentile (50) << "\t" << m_latency.GetValueAtPercentile (90) << "\t"
+      << m_latency.GetValueAtPercentile (99) << "\t" << m_latency.GetValueAtPercentile (99.9) << "\t"
+      << m_latency.GetMax () << "\n";
+  out << "% from(us)\tto(us)\tcount\n";
+  m_latency.PrintBuckets (out);
+  if (m_segmented)
+    {
+      out << "% objects\tcomplete\tfailed\tunfinished\tp50(ms)\tp90(ms)\tp99(ms)\tmax(ms)\n";
+      out << m_sent << "\t" << m_objectLatency.GetCount () << "\t" << m_objectsFailed << "\t"
+          << m_objects.size () << "\t" << m_objectLatency.GetValueAtPercentile (50) / 1000.0 << "\t"
+          << m_objectLatency.GetValueAtPercentile (90) / 1000.0 << "\t"
+          << m_objectLatency.GetValueAtPercentile (99) / 1000.0 << "\t"
+          << m_objectLatency.GetMax () / 1000.0 << "\n";
+      out << "% object\tstart(s)\tcompletion(ms)\tbytes\tgoodput(kbps)\n";
+      for (std::vector<ObjectRecord>::const_iterator it = m_objectRecords.begin (); it != m_objectRecords.end (); ++it)
+        {
+          double completion = it->m_completion.GetSeconds ();
+          out << it->m_objectId << "\t" << it->m_start.GetSeconds () << "\t" << completion * 1000.0 << "\t"
+              << it->m_bytes << "\t" << ((completion > 0) ? it->m_bytes * 8 / completion / 1000.0 : 0) << "\n";
+        }
+    }
+  if (m_rawLatency)
+    {
+      out << "% latency(us)\n";
+      for (std::vector<uint32_t>::const_iterator it = m_latencySamples.begin (); it != m_latencySamples.end (); ++it)
+        {
+          out << *it << "\n";
+        }
+    }
+}
+
+void
+UdpEchoClient::IncreaseWindow (void) // edit
+{
+  if (m_cwnd < m_ssthresh)
+    {
+      // slow start
+      SetWindow (m_cwnd + 1.0);
+      return;
+    }
+  if (m_congestionControl == CC_AIMD)
+    {
+      SetWindow (m_cwnd + 1.0 / m_cwnd);
+      return;
+    }
+  // W(t) = C (t - K)^3 + Wmax, K the time to grow back to Wmax
+  double t = (Simulator::Now () - m_cubicEpoch).GetSeconds ();
+  double k = std::pow (m_cubicWmax * (1.0 - m_cubicBeta) / m_cubicC, 1.0 / 3.0);
+  double target = m_cubicC * std::pow (t - k, 3.0) + m_cubicWmax;
+  if (target > m_cwnd)
+    {
+      // reach the target in about one window of contents
+      SetWindow (m_cwnd + (target - m_cwnd) / m_cwnd);
+    }
+  else
+    {
+      // the cubic plateau still grows a little
+      SetWindow (m_cwnd + 0.01 / m_cwnd);
+    }
+}
+
+void
+UdpEchoClient::DecreaseWindow (void) // edit
+{
+  m_lastDecrease = Simulator::Now ();
+  if (m_congestionControl == CC_AIMD)
+    {
+      m_ssthresh = std::max (m_cwnd * m_aimdDecrease, 1.0);
+    }
+  else
+    {
+      m_cubicWmax = m_cwnd;
+      m_cubicEpoch = Simulator::Now ();
+      m_ssthresh = std::max (m_cwnd * m_cubicBeta, 1.0);
+    }
+  SetWindow (m_ssthresh);
+}
+
+void
+UdpEchoClient::SetWindow (double cwnd) // edit
+{
+  cwnd = std::min (std::max (cwnd, 1.0), m_maxWindow);
+  if (cwnd != m_cwnd)
+    {
+      m_cwnd = cwnd;
+      m_cwndTrace (m_cwnd);
     }
 }
 
@@ -380,30 +1000,44 @@ UdpEchoClient::HandleRead (Ptr<Socket> socket)
       NS_LOG_INFO ("Source: " << InetSocketAddress::ConvertFrom (from).GetIpv4 ());
       NS_LOG_INFO ("Port: " << InetSocketAddress::ConvertFrom (from).GetPort ());
 
-      ofstream out ((ueFileRx.str ()).c_str (), ios::app);
-//      out << " Sequence number: " << m_received <<
-//             " Rx time (s) " << Simulator::Now ().GetSeconds () <<
-//             " Content name: " << contentObjectHeader->GetName() <<
-//             " Content size (Byte): " << packet->GetSize () <<
-//             " Source: " << InetSocketAddress::ConvertFrom (from).GetIpv4 () <<
-//             " Port: " << InetSocketAddress::ConvertFrom (from).GetPort () <<
-//             " UE Address: " << GetNode()->GetObject<Ipv4> ()->GetAddress(1,0).GetLocal() << endl;
-      out << m_received << "\t";
       std::list<std::string> myList = contentObjectHeader->GetName().GetComponents();
-      std::list<std::string>::iterator iter;
-      int i = 0;
-      for (iter=myList.begin(); iter!=myList.end(); iter++)
+      if (m_packetFiles) // edit
         {
-           if (i == 1)
-             out << *iter << "\t";
-           i++;
+          ofstream out ((ueFileRx.str ()).c_str (), ios::app);
+          out << m_received << "\t";
+          std::list<std::string>::iterator iter;
+          int i = 0;
+          for (iter=myList.begin(); iter!=myList.end(); iter++)
+            {
+               if (i == 1)
+                 out << *iter << "\t";
+               i++;
+            }
+          out << Simulator::Now ().GetSeconds () << "\t";
+          out << packet->GetSize () << "\t";
+          out << GetNode()->GetObject<Ipv4> ()->GetAddress(1,0).GetLocal() << "\n";
         }
-      out << Simulator::Now ().GetSeconds () << "\t";
-      out << packet->GetSize () << "\t";
-      out << GetNode()->GetObject<Ipv4> ()->GetAddress(1,0).GetLocal() << "\n";
-
 
       ++m_received;
+
+      if (m_segmented && myList.size () >= 3) // edit
+        {
+          // the object latency is recorded when its last segment arrives
+          SegmentHeader segmentHeader;
+          pCopy->RemoveHeader (segmentHeader);
+          std::list<std::string>::reverse_iterator component = myList.rbegin ();
+          ++component;
+          OnSegment ((uint32_t) strtoul (component->c_str (), 0, 10), segmentHeader, pCopy->GetSize ());
+        }
+      else if (!myList.empty ()) // edit
+        {
+          uint32_t contentId = (uint32_t) strtoul (myList.back ().c_str (), 0, 10);
+          TrackContent (contentId);
+          if (m_consumerMode == CONSUMER_WINDOW)
+            {
+              OnContent (contentId);
+            }
+        }
     }
 }
 
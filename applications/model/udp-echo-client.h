@@ -24,8 +24,15 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/traced-callback.h"
+#include "ns3/nstime.h" // edit
+#include "ns3/random-variable-stream.h" // edit
+#include "zipf-alias-table.h" // edit
+#include "latency-histogram.h" // edit
+#include "segment-header.h" // edit
 #include <iostream>
 #include <fstream>
+#include <deque> // edit
+#include <map> // edit
 
 using namespace std;
 
@@ -128,6 +135,43 @@ public:
    */
   void SetFill (uint8_t *fill, uint32_t fillSize, uint32_t dataSize);
 
+  /**
+   * How the content requested by each Interest is chosen
+   */
+  enum RequestMode_t // edit
+  {
+    REQUEST_SEQUENTIAL, ///< /video/0, /video/1, ... in order
+    REQUEST_CATALOG     ///< drawn from a catalog with a Mandelbrot-Zipf popularity
+  };
+
+  /**
+   * When Interests are sent
+   */
+  enum ConsumerMode_t // edit
+  {
+    CONSUMER_INTERVAL, ///< one Interest every Interval
+    CONSUMER_WINDOW    ///< as many as the congestion window allows, retransmitted on timeout
+  };
+
+  /**
+   * How the congestion window of CONSUMER_WINDOW follows the contents and
+   * the timeouts
+   */
+  enum CongestionControl_t // edit
+  {
+    CC_AIMD,  ///< +1 per window of contents, times AimdDecrease on timeout
+    CC_CUBIC  ///< cubic growth towards the window of the last timeout, times CubicBeta on timeout
+  };
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this application.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream); // edit
+
 protected:
   virtual void DoDispose (void);
 
@@ -141,6 +185,60 @@ private:
 
   void HandleRead (Ptr<Socket> socket);
 
+  /**
+   * \return the number of the content to request next
+   */
+  uint32_t NextContentId (void); // edit
+
+  /**
+   * Build, log and send the Interest for a content, or for a segment of
+   * the object contentId if segment is not negative
+   */
+  void SendInterest (uint32_t contentId, int64_t segment = -1); // edit
+
+  /**
+   * Send new Interests while the window has room for them
+   */
+  void FillWindow (void); // edit
+
+  void OnContent (uint32_t contentId); // edit
+
+  /**
+   * Start fetching an object with the Interest for its first segment, which
+   * tells how many segments the object has
+   */
+  void StartObject (uint32_t objectId); // edit
+  void FillSegments (uint32_t objectId); // edit
+  void SendSegment (uint32_t objectId, uint32_t segment); // edit
+  void OnSegment (uint32_t objectId, const SegmentHeader &segmentHeader, uint32_t payloadSize); // edit
+  void OnSegmentTimeout (uint32_t objectId, uint32_t segment); // edit
+  void CancelObject (uint32_t objectId); // edit
+  void OnTimeout (uint32_t contentId); // edit
+
+  /**
+   * Update the smoothed RTT and the RTO with a sample (RFC 6298)
+   */
+  void RttSample (Time rtt); // edit
+
+  /**
+   * Record the latency of a content against the first Interest sent for it
+   */
+  void TrackContent (uint32_t contentId); // edit
+
+  /**
+   * Count as timed out the Interests older than LatencyTimeout
+   */
+  void ExpireOutstanding (void); // edit
+
+  /**
+   * Write the latency summary and, with RawLatencySamples, the samples
+   */
+  void DumpLatency (void); // edit
+
+  void IncreaseWindow (void); // edit
+  void DecreaseWindow (void); // edit
+  void SetWindow (double cwnd); // edit
+
   uint32_t m_count;
   Time m_interval;
   uint32_t m_size;
@@ -160,6 +258,110 @@ private:
   ostringstream ueFileTx; // edit
   ostringstream ueFileRx; // edit
 
+  RequestMode_t m_requestMode; // edit
+  uint32_t m_catalogSize; // edit
+  double m_zipfExponent; // edit
+  double m_zipfPlateau; // edit
+  double m_temporalLocality; // edit
+  uint32_t m_recentWindow; // edit
+  Time m_driftInterval; // edit
+  uint32_t m_driftStep; // edit
+  Ptr<ZipfAliasTable> m_popularity; // edit
+  Ptr<UniformRandomVariable> m_rankRng; // edit
+  Ptr<UniformRandomVariable> m_localityRng; // edit
+
+  /**
+   * contents recently drawn from the catalog, re-requested with the
+   * probability TemporalLocality
+   */
+  std::deque<uint32_t> m_recent; // edit
+
+  struct PendingInterest // edit
+  {
+    Time m_sendTime;    ///< of the last transmission
+    uint32_t m_retx;    ///< number of retransmissions
+    EventId m_timeout;
+  };
+
+  /**
+   * Interests in flight in CONSUMER_WINDOW, by content number
+   */
+  std::map<uint32_t, PendingInterest> m_pending; // edit
+
+  ConsumerMode_t m_consumerMode; // edit
+  CongestionControl_t m_congestionControl; // edit
+  double m_initialWindow; // edit
+  double m_maxWindow; // edit
+  double m_aimdDecrease; // edit
+  double m_cubicBeta; // edit
+  double m_cubicC; // edit
+  uint32_t m_maxRetx; // edit
+  Time m_initialRto; // edit
+  Time m_minRto; // edit
+  Time m_maxRto; // edit
+
+  double m_cwnd; // edit
+  double m_ssthresh; // edit
+  double m_cubicWmax; // edit
+  Time m_cubicEpoch; // edit
+  Time m_lastDecrease; // edit
+  Time m_srtt; // edit
+  Time m_rttvar; // edit
+  Time m_rto; // edit
+
+  /**
+   * An object being fetched in SegmentedObjects mode
+   */
+  struct ObjectFetch // edit
+  {
+    Time m_start;
+    bool m_finalKnown;          ///< the first segment received told the final segment
+    uint32_t m_finalSegment;
+    uint32_t m_nextSegment;     ///< next segment never requested
+    uint32_t m_segmentsReceived;
+    uint32_t m_bytes;           ///< payload received, segment headers excluded
+    std::vector<bool> m_received;
+    std::map<uint32_t, PendingInterest> m_inFlight; ///< by segment
+  };
+
+  struct ObjectRecord // edit
+  {
+    uint32_t m_objectId;
+    Time m_start;
+    Time m_completion;
+    uint32_t m_bytes;
+  };
+
+  bool m_segmented; // edit
+  uint32_t m_segmentWindow; // edit
+  std::map<uint32_t, ObjectFetch> m_objects; // edit, by object
+  std::vector<ObjectRecord> m_objectRecords; // edit
+  LatencyHistogram m_objectLatency; // edit, microseconds
+  uint32_t m_objectsFailed; // edit
+
+  bool m_packetFiles; // edit
+  bool m_rawLatency; // edit
+  Time m_latencyTimeout; // edit
+
+  /**
+   * time the first Interest for each outstanding content was sent, and the
+   * same in send order for the expiry
+   */
+  std::map<uint32_t, Time> m_outstanding; // edit
+  std::deque<std::pair<uint32_t, Time> > m_outstandingOrder; // edit
+
+  LatencyHistogram m_latency; // edit, microseconds
+  std::vector<uint32_t> m_latencySamples; // edit, microseconds
+  uint32_t m_timeouts; // edit
+  uint32_t m_duplicates; // edit
+
+  //             window
+  TracedCallback<double> m_cwndTrace; // edit
+  //             content   retransmissions
+  TracedCallback<uint32_t, uint32_t> m_timeoutTrace; // edit
+  //             object    bytes     completion time
+  TracedCallback<uint32_t, uint32_t, Time> m_objectTrace; // edit
+
 };
 
 } // namespace ns3
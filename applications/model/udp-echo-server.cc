@@ -33,6 +33,10 @@
 #include "ns3/names.h"  // edit
 #include "ns3/ndn-interest.h" // edit
 #include "ns3/nstime.h" // edit
+#include "ns3/abort.h" // edit
+#include "segment-header.h" // edit
+#include <stdlib.h> // edit
+#include <algorithm> // edit
 
 #include "udp-echo-server.h"
 
@@ -51,6 +55,29 @@ UdpEchoServer::GetTypeId (void)
                    UintegerValue (9),
                    MakeUintegerAccessor (&UdpEchoServer::m_port),
                    MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("PayloadSize", "Size of the payload of the content objects sent back",
+                   UintegerValue (1316), // 7 PES @188Bytes
+                   MakeUintegerAccessor (&UdpEchoServer::m_payloadSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("ObjectSize",
+                   "Size in bytes of the objects served as segments /<prefix>/<object>/<segment>, "
+                   "0 to answer every Interest with a single PayloadSize content",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&UdpEchoServer::m_objectSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SegmentSize", "Largest payload of a segment of an object",
+                   UintegerValue (1316),
+                   MakeUintegerAccessor (&UdpEchoServer::m_segmentSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Mtu",
+                   "IP MTU the segments, with their content, UDP and IP headers, have to fit in",
+                   UintegerValue (1500),
+                   MakeUintegerAccessor (&UdpEchoServer::m_mtu),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("Freshness", "Freshness of the content objects sent back",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&UdpEchoServer::m_freshness),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
@@ -71,6 +98,8 @@ void
 UdpEchoServer::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_contentTemplate = 0; // edit
+  m_payloads.clear ();
   Application::DoDispose ();
 }
 
@@ -123,6 +152,60 @@ UdpEchoServer::StartApplication (void)
 
   m_socket->SetRecvCallback (MakeCallback (&UdpEchoServer::HandleRead, this));
   m_socket6->SetRecvCallback (MakeCallback (&UdpEchoServer::HandleRead, this));
+
+  // edit: everything but the name is the same for all the content objects
+  m_contentTemplate = Create<ns3::ndn::ContentObject> ();
+  m_contentTemplate->SetFreshness (m_freshness);
+  GetPayload (m_payloadSize);
+}
+
+uint32_t
+UdpEchoServer::GetSegmentSize (const ns3::ndn::Name &name) // edit
+{
+  const std::list<std::string> &components = name.GetComponents ();
+  std::list<std::string>::const_iterator last = components.end ();
+  --last;
+  std::string prefix;
+  for (std::list<std::string>::const_iterator it = components.begin (); it != last; ++it)
+    {
+      prefix += "/" + *it;
+    }
+  std::map<std::string, uint32_t>::iterator sizeIt = m_segmentSizes.find (prefix);
+  if (sizeIt != m_segmentSizes.end ())
+    {
+      return sizeIt->second;
+    }
+
+  // the header of the largest segment number bounds the header of all the
+  // segments, whose size must not depend on the segment
+  Ptr<ns3::ndn::Name> bound = Create<ns3::ndn::Name> ();
+  for (std::list<std::string>::const_iterator it = components.begin (); it != last; ++it)
+    {
+      (*bound) (*it);
+    }
+  (*bound) (m_objectSize);
+  ns3::ndn::ContentObject contentHeader = *m_contentTemplate;
+  contentHeader.SetName (bound);
+
+  SegmentHeader segmentHeader;
+  uint32_t overhead = 20 + 8 + contentHeader.GetSerializedSize () + segmentHeader.GetSerializedSize ();
+  NS_ABORT_MSG_IF (overhead >= m_mtu, "Mtu " << m_mtu << " too small for the headers of " << name);
+  uint32_t segmentSize = std::min (m_segmentSize, m_mtu - overhead);
+  NS_LOG_LOGIC ("Segments of " << prefix << ": " << segmentSize << " bytes");
+  m_segmentSizes[prefix] = segmentSize;
+  return segmentSize;
+}
+
+Ptr<const Packet>
+UdpEchoServer::GetPayload (uint32_t size) // edit
+{
+  Ptr<Packet> &payload = m_payloads[size];
+  if (payload == 0)
+    {
+      NS_LOG_LOGIC ("Building the payload template of " << size << " bytes");
+      payload = Create<Packet> (size);
+    }
+  return payload;
 }
 
 void
@@ -171,34 +254,48 @@ UdpEchoServer::HandleRead (Ptr<Socket> socket)
       ns3::ndn::Interest interestHeader;
       packet->RemoveHeader (interestHeader);
 
-      NS_LOG_INFO ("Receiving Interest ");
-      std::list<std::string> myList = interestHeader.GetName().GetComponents();
-      std::list<std::string>::iterator iter;
-      int i = 0;
-      for (iter=myList.begin(); iter!=myList.end(); iter++)
+      if (g_log.IsEnabled (LOG_INFO)) // edit: the components are walked for the log only
         {
-           i++;
-           NS_LOG_INFO ("Interest Component Name " << i << " = " << *iter);
+          NS_LOG_INFO ("Receiving Interest ");
+          const std::list<std::string> &myList = interestHeader.GetName ().GetComponents ();
+          int i = 0;
+          for (std::list<std::string>::const_iterator iter = myList.begin (); iter != myList.end (); iter++)
+            {
+              i++;
+              NS_LOG_INFO ("Interest Component Name " << i << " = " << *iter);
+            }
         }
 
-      Ptr<ns3::ndn::ContentObject> header = Create<ns3::ndn::ContentObject> ();
-      header->SetName (Create<ns3::ndn::Name> (interestHeader.GetName ()));
-      header->SetFreshness (Seconds (0));
-
-      NS_LOG_INFO ("Sending Content Object ");
-      myList = header->GetName().GetComponents();
-      i = 0;
-      for (iter=myList.begin(); iter!=myList.end(); iter++)
+      Ptr<Packet> p;
+      const std::list<std::string> &components = interestHeader.GetName ().GetComponents ();
+      if (m_objectSize > 0 && components.size () >= 3) // edit
+        {
+          uint32_t segmentSize = GetSegmentSize (interestHeader.GetName ());
+          SegmentHeader segmentHeader;
+          segmentHeader.SetSegment ((uint32_t) strtoul (components.back ().c_str (), 0, 10));
+          segmentHeader.SetFinalSegment ((m_objectSize - 1) / segmentSize);
+          segmentHeader.SetObjectSize (m_objectSize);
+          if (segmentHeader.GetSegment () > segmentHeader.GetFinalSegment ())
+            {
+              NS_LOG_WARN ("No segment " << segmentHeader.GetSegment () << " in an object of "
+                           << m_objectSize << " bytes, Interest " << interestHeader.GetName () << " dropped");
+              continue;
+            }
+          uint32_t offset = segmentHeader.GetSegment () * segmentSize;
+          p = GetPayload (std::min (segmentSize, m_objectSize - offset))->Copy ();
+          p->AddHeader (segmentHeader);
+        }
+      else
         {
-           i++;
-           NS_LOG_INFO ("Object Component Name " << i << " = " << *iter);
+          p = GetPayload (m_payloadSize)->Copy (); // edit
         }
 
-      Ptr<Packet> p = Create<Packet> (1316); // 7 PES @188Bytes
-
-      p->AddHeader (*header);
+      m_contentTemplate->SetName (Create<ns3::ndn::Name> (interestHeader.GetName ())); // edit
+      m_contentTemplate->SetTimestamp (Simulator::Now ());
+      p->AddHeader (*m_contentTemplate);
       // editan akhir
-      NS_LOG_INFO ("FRESHNESS " << header->GetFreshness().GetSeconds());
+      NS_LOG_INFO ("Sending Content Object " << m_contentTemplate->GetName ()
+                   << ", FRESHNESS " << m_contentTemplate->GetFreshness ().GetSeconds ());
       NS_LOG_LOGIC ("Echoing packet");
       socket->SendTo (p, 0, from); // packet diganti p
 
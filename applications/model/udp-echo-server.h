@@ -23,12 +23,20 @@
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
 #include "ns3/address.h"
+#include "ns3/nstime.h" // edit
+#include <map> // edit
+#include <string> // edit
 
 namespace ns3 {
 
 class Socket;
 class Packet;
 
+namespace ndn {
+class ContentObject;
+class Name;
+}
+
 /**
  * \ingroup applications 
  * \defgroup udpecho UdpEcho
@@ -38,7 +46,13 @@ class Packet;
  * \ingroup udpecho
  * \brief A Udp Echo server
  *
- * Every packet received is sent back.
+ * Every Interest received is answered with a content object of the same
+ * name. The content header and the payloads are built once and reused:
+ * answering an Interest only sets the name and copies a payload.
+ *
+ * With an ObjectSize, the Interest /<prefix>/<object>/<segment> is
+ * answered with that segment of the object, led by a SegmentHeader
+ * carrying the final segment number.
  */
 class UdpEchoServer : public Application 
 {
@@ -57,7 +71,30 @@ private:
 
   void HandleRead (Ptr<Socket> socket);
 
+  /**
+   * \param size the payload size
+   * \return the payload template of that size, shared copy-on-write by
+   * the content objects sent
+   */
+  Ptr<const Packet> GetPayload (uint32_t size); // edit
+
+  /**
+   * \param name the name of a segment of an object
+   * \return the payload size of the segments of the object: SegmentSize,
+   * or less if the segment would not fit in the Mtu, computed once per
+   * object prefix
+   */
+  uint32_t GetSegmentSize (const ns3::ndn::Name &name); // edit
+
   uint16_t m_port;
+  uint32_t m_payloadSize; // edit
+  uint32_t m_objectSize; // edit
+  uint32_t m_segmentSize; // edit
+  uint16_t m_mtu; // edit
+  Time m_freshness; // edit
+  Ptr<ns3::ndn::ContentObject> m_contentTemplate; // edit
+  std::map<uint32_t, Ptr<Packet> > m_payloads; // edit, by size
+  std::map<std::string, uint32_t> m_segmentSizes; // edit, by object prefix
   Ptr<Socket> m_socket;
   Ptr<Socket> m_socket6;
   Address m_local;
@@ -31,6 +31,12 @@
 #include "ns3/uinteger.h"
 #include "ns3/ipv4-header.h" // edit
 #include "ns3/x2-header.h" // new
+#include "ns3/string.h" // edit
+#include "ns3/ipv4-address.h" // edit
+#include "ns3/trace-source-accessor.h" // edit
+#include "ns3/abort.h" // edit
+#include <fstream> // edit
+#include <algorithm> // edit
 
 
 #include "udp-echo-server2.h"
@@ -55,6 +61,20 @@ UdpEchoServer2::GetTypeId (void)
                    UintegerValue (0), // 0: no VM migration;
                    MakeUintegerAccessor (&UdpEchoServer2::m_vmMigration),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("EnbPort",
+                   "Port of the X2-C sockets of the eNBs",
+                   UintegerValue (4444),
+                   MakeUintegerAccessor (&UdpEchoServer2::m_enbPort),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("OutputFilename",
+                   "File the sessions and their processing latency are written to "
+                   "when the application stops, none if empty",
+                   StringValue ("ControllerSessions.txt"),
+                   MakeStringAccessor (&UdpEchoServer2::m_outputFilename),
+                   MakeStringChecker ())
+    .AddTraceSource ("SessionComplete",
+                     "The controller sent the last message of a handover session",
+                     MakeTraceSourceAccessor (&UdpEchoServer2::m_sessionTrace))
   ;
   return tid;
 }
@@ -63,7 +83,7 @@ UdpEchoServer2::UdpEchoServer2 ()
 {
   NS_LOG_FUNCTION (this);
 
-  m_msgCounter = 0;
+  m_maxSessions = 0; // edit
 }
 
 UdpEchoServer2::~UdpEchoServer2()
@@ -146,6 +166,53 @@ UdpEchoServer2::StopApplication ()
       m_socket6->Close ();
       m_socket6->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
     }
+
+  WriteSessions (); // edit
+}
+
+void
+UdpEchoServer2::AddCell (uint16_t cellId, Ipv4Address address) // edit
+{
+  NS_LOG_FUNCTION (this << cellId << address);
+  m_cellAddresses[cellId] = address;
+}
+
+uint64_t
+UdpEchoServer2::GetSessionKey (uint16_t sourceCellId, uint16_t targetCellId, uint16_t ueId) // edit
+{
+  return ((uint64_t) sourceCellId << 32) | ((uint64_t) targetCellId << 16) | ueId;
+}
+
+Address
+UdpEchoServer2::GetCellAddress (uint16_t cellId) const // edit
+{
+  std::map<uint16_t, Ipv4Address>::const_iterator it = m_cellAddresses.find (cellId);
+  NS_ABORT_MSG_IF (it == m_cellAddresses.end (), "Address of cell " << cellId << " unknown to the controller");
+  return InetSocketAddress (it->second, m_enbPort);
+}
+
+Ptr<Packet>
+UdpEchoServer2::CreateIcnPayload (uint16_t handovers, uint16_t sourceCellId, const std::vector<uint16_t> &ueIds) // new
+{
+  // 0 stands for a single UE, as in the notifications of a per-UE handover
+  std::vector<uint8_t> buf (std::max<uint32_t> (14, 4 + 2 * ueIds.size ()), 0);
+  if (handovers > 1)
+    {
+      buf[0] = handovers >> 8;
+      buf[1] = handovers & 0xff;
+    }
+  // the target eNB matches the UEs by source cell and X2AP id
+  if (ueIds.size () == handovers)
+    {
+      buf[2] = sourceCellId >> 8;
+      buf[3] = sourceCellId & 0xff;
+      for (uint32_t n = 0; n < ueIds.size (); n++)
+        {
+          buf[4 + 2 * n] = ueIds[n] >> 8;
+          buf[5 + 2 * n] = ueIds[n] & 0xff;
+        }
+    }
+  return Create<Packet> (&buf[0], buf.size ());
 }
 
 void
@@ -173,113 +240,215 @@ UdpEchoServer2::HandleRead (Ptr<Socket> socket)
       packet->RemoveAllPacketTags ();
       packet->RemoveAllByteTags ();
 
-      NS_LOG_LOGIC ("Echoing packet");
+      // a target eNB accepting the handovers of a group of UEs at once
+      // notifies them in a single message, the number of UEs in its first
+      // two bytes; the reports of the VM migration steps have a header of
+      // their own, and the notification of a single UE none
+      uint16_t handovers = 1; // new
+      X2Header x2Header;
+      uint8_t messageType = X2Header::InitiatingMessage;
+      if (packet->GetSize () > x2Header.GetSerializedSize ())
+        {
+          packet->PeekHeader (x2Header);
+          messageType = x2Header.GetMessageType ();
+        }
+      if (messageType == X2Header::VmReport) // edit
+        {
+          packet->RemoveHeader (x2Header);
+          RecvVmReport (socket, packet, from);
+          continue;
+        }
+      if (messageType == X2Header::X2Bundle)
+        {
+          packet->RemoveHeader (x2Header);
+          uint8_t buf[2];
+          packet->CopyData (buf, 2);
+          handovers = ((uint16_t) buf[0] << 8) | buf[1];
+          NS_LOG_INFO ("Group handover of " << handovers << " UEs");
+        }
+      RecvNotification (socket, packet, from, handovers);
+    }
+}
 
-      if (m_vmMigration == 0) // no VM migration
-      {
-          // create a packet
-        X2Header x2Header;
-        x2Header.SetMessageType (X2Header::IcnMessageSource);
-        x2Header.SetProcedureCode (X2Header::HandoverPreparation);
-        x2Header.SetLengthOfIes (1);
-        x2Header.SetNumberOfIes (1);
+void
+UdpEchoServer2::RecvNotification (Ptr<Socket> socket, Ptr<Packet> packet, const Address &from, uint16_t handovers) // edit
+{
+  NS_LOG_FUNCTION (this << packet << handovers);
 
-        Ptr<Packet> packetPitToSource = Create<Packet> (14);
-        packetPitToSource->AddHeader (x2Header);
+  if (packet->GetSize () < 10 + 2 * (uint32_t) handovers)
+    {
+      NS_LOG_WARN ("Notification of " << packet->GetSize () << " bytes too short for "
+                   << handovers << " UEs, dropped");
+      return;
+    }
+  std::vector<uint8_t> buf (10 + 2 * handovers);
+  packet->CopyData (&buf[0], buf.size ());
+  uint16_t sourceCellId = ((uint16_t) buf[2] << 8) | buf[3];
+  uint16_t targetCellId = ((uint16_t) buf[4] << 8) | buf[5];
+  std::vector<uint16_t> ueIds;
+  for (uint16_t n = 0; n < handovers; n++)
+    {
+      ueIds.push_back (((uint16_t) buf[10 + 2 * n] << 8) | buf[11 + 2 * n]);
+    }
 
-        Ptr<Packet> packetPitToTarget = Create<Packet> (14);
-        x2Header.SetMessageType (X2Header::IcnMessage);
-        packetPitToTarget->AddHeader (x2Header);
+  // the eNBs are reached on the X2 link between them: the target at the
+  // sender address, the source at the address the target gives; the
+  // addresses set with AddCell are kept
+  m_cellAddresses.insert (std::make_pair (sourceCellId, Ipv4Address::Deserialize (&buf[6])));
+  if (InetSocketAddress::IsMatchingType (from))
+    {
+      m_cellAddresses.insert (std::make_pair (targetCellId, InetSocketAddress::ConvertFrom (from).GetIpv4 ()));
+    }
 
-        NS_LOG_INFO ("PIT Packet Size to Target eNB: " << packetPitToTarget->GetSize());
-        NS_LOG_INFO ("PIT Packet Size to Source eNB: " << packetPitToSource->GetSize());
+  X2Header x2Header;
+  x2Header.SetMessageType (X2Header::IcnMessageSource);
+  x2Header.SetProcedureCode (X2Header::HandoverPreparation);
+  x2Header.SetLengthOfIes (1);
+  x2Header.SetNumberOfIes (1);
 
-        uint16_t source_port = 4444;
-        socket->SendTo (packetPitToSource, 0, InetSocketAddress (Ipv4Address ("11.0.0.1"), source_port));
-        socket->SendTo (packetPitToTarget, 0, from);
+  Ptr<Packet> packetPitToSource = CreateIcnPayload (handovers, sourceCellId, ueIds);
+  packetPitToSource->AddHeader (x2Header);
+  socket->SendTo (packetPitToSource, 0, GetCellAddress (sourceCellId));
+  NS_LOG_INFO ("PIT Packet Size to Source eNB " << sourceCellId << ": " << packetPitToSource->GetSize ());
 
-        if (InetSocketAddress::IsMatchingType (from))
-        {
-          NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds () << "s server sent " << packet->GetSize () << " bytes to " <<
-                       InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-                       InetSocketAddress::ConvertFrom (from).GetPort ());
-        }
-        else if (Inet6SocketAddress::IsMatchingType (from))
+  if (m_vmMigration == 0) // no VM migration
+    {
+      Ptr<Packet> packetPitToTarget = CreateIcnPayload (handovers, sourceCellId, ueIds);
+      x2Header.SetMessageType (X2Header::IcnMessage);
+      packetPitToTarget->AddHeader (x2Header);
+      socket->SendTo (packetPitToTarget, 0, from);
+      NS_LOG_INFO ("PIT Packet Size to Target eNB " << targetCellId << ": " << packetPitToTarget->GetSize ());
+
+      // answered at once, no session is opened
+      return;
+    }
+
+  // each VM is migrated on its own
+  for (uint16_t n = 0; n < handovers; n++)
+    {
+      Session session;
+      session.m_sourceCellId = sourceCellId;
+      session.m_targetCellId = targetCellId;
+      session.m_ueId = ueIds[n];
+      session.m_state = SESSION_WAIT_VM_RECEIVED;
+      session.m_start = Simulator::Now ();
+      socket->SendTo (CreateVmCommand (X2Header::MigrationRequest, session, 11), 0, from);
+
+      uint64_t key = GetSessionKey (sourceCellId, targetCellId, ueIds[n]);
+      if (m_sessions.find (key) != m_sessions.end ())
         {
-          NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds () << "s server sent " << packet->GetSize () << " bytes to " <<
-                       Inet6SocketAddress::ConvertFrom (from).GetIpv6 () << " port " <<
-                       Inet6SocketAddress::ConvertFrom (from).GetPort ());
+          NS_LOG_WARN ("Session of UE " << ueIds[n] << " from cell " << sourceCellId
+                       << " to cell " << targetCellId << " restarted");
         }
-      }
-      else
-      {
-          if (m_msgCounter == 0)
-          {
-                // create a packet
-            X2Header x2Header;
-            x2Header.SetMessageType (X2Header::IcnMessageSource);
-            x2Header.SetProcedureCode (X2Header::HandoverPreparation);
-            x2Header.SetLengthOfIes (1);
-            x2Header.SetNumberOfIes (1);
-
-            Ptr<Packet> packetPitToSource = Create<Packet> (14);
-            packetPitToSource->AddHeader (x2Header);
-
-            Ptr<Packet> migReqToTarget = Create<Packet> (2); // 9 bytes - 7 (header size)
-            x2Header.SetMessageType (X2Header::MigrationRequest);
-            migReqToTarget->AddHeader (x2Header);
-
-            uint16_t source_port = 4444;
-            socket->SendTo (packetPitToSource, 0, InetSocketAddress (Ipv4Address ("11.0.0.1"), source_port));
-            socket->SendTo (migReqToTarget, 0, from);
-          }
-          else if (m_msgCounter == 1)
-          {
-            X2Header x2Header;
-            x2Header.SetMessageType (X2Header::StartVmCmd);
-            x2Header.SetProcedureCode (X2Header::HandoverPreparation);
-            x2Header.SetLengthOfIes (1);
-            x2Header.SetNumberOfIes (1);
-
-            Ptr<Packet> startVm = Create<Packet> (6); // 13 Bytes - 7(header)
-            startVm->AddHeader (x2Header);
-
-            //uint16_t source_port = 4444;
-            socket->SendTo (startVm, 0, from);
-          }
-          else if (m_msgCounter == 2)
-          {
-            X2Header x2Header;
-            x2Header.SetMessageType (X2Header::IcnMessage);
-            x2Header.SetProcedureCode (X2Header::HandoverPreparation);
-            x2Header.SetLengthOfIes (1);
-            x2Header.SetNumberOfIes (1);
-
-            Ptr<Packet> packetPitToTarget = Create<Packet> (14);
-            packetPitToTarget->AddHeader (x2Header);
-
-            //uint16_t source_port = 4444;
-            socket->SendTo (packetPitToTarget, 0, from);
-          }
-
-          m_msgCounter++;
-
-          if (InetSocketAddress::IsMatchingType (from))
-            {
-                NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds () << "s server sent " << packet->GetSize () << " bytes to " <<
-                       InetSocketAddress::ConvertFrom (from).GetIpv4 () << " port " <<
-                       InetSocketAddress::ConvertFrom (from).GetPort ());
-            }
-            else if (Inet6SocketAddress::IsMatchingType (from))
-            {
-                NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds () << "s server sent " << packet->GetSize () << " bytes to " <<
-                       Inet6SocketAddress::ConvertFrom (from).GetIpv6 () << " port " <<
-                       Inet6SocketAddress::ConvertFrom (from).GetPort ());
-            }
+      m_sessions[key] = session;
+    }
+  m_maxSessions = std::max<uint32_t> (m_maxSessions, m_sessions.size ());
+  NS_LOG_INFO (m_sessions.size () << " sessions open");
+}
+
+void
+UdpEchoServer2::RecvVmReport (Ptr<Socket> socket, Ptr<Packet> packet, const Address &from) // edit
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  uint8_t buf[6];
+  packet->CopyData (buf, 6);
+  uint16_t sourceCellId = ((uint16_t) buf[0] << 8) | buf[1];
+  uint16_t targetCellId = ((uint16_t) buf[2] << 8) | buf[3];
+  uint16_t ueId = ((uint16_t) buf[4] << 8) | buf[5];
 
-      }
+  std::map<uint64_t, Session>::iterator it = m_sessions.find (GetSessionKey (sourceCellId, targetCellId, ueId));
+  if (it == m_sessions.end ())
+    {
+      NS_LOG_WARN ("VM report of cell " << targetCellId << " for UE " << ueId
+                   << " from cell " << sourceCellId << " without a session, ignoring");
+      return;
+    }
+
+  if (it->second.m_state == SESSION_WAIT_VM_RECEIVED)
+    {
+      NS_LOG_INFO ("VM of UE " << ueId << " received by cell " << targetCellId << ", starting it");
+      socket->SendTo (CreateVmCommand (X2Header::StartVmCmd, it->second, 13), 0, from);
+      it->second.m_state = SESSION_WAIT_VM_STARTED;
+      return;
+    }
+
+  NS_LOG_INFO ("VM of UE " << ueId << " started by cell " << targetCellId);
+  X2Header x2Header;
+  x2Header.SetMessageType (X2Header::IcnMessage);
+  x2Header.SetProcedureCode (X2Header::HandoverPreparation);
+  x2Header.SetLengthOfIes (1);
+  x2Header.SetNumberOfIes (1);
+
+  Ptr<Packet> packetPitToTarget = CreateIcnPayload (1, it->second.m_sourceCellId,
+                                                    std::vector<uint16_t> (1, it->second.m_ueId));
+  packetPitToTarget->AddHeader (x2Header);
+  socket->SendTo (packetPitToTarget, 0, GetCellAddress (it->second.m_targetCellId));
+  CloseSession (it);
+}
+
+Ptr<Packet>
+UdpEchoServer2::CreateVmCommand (uint8_t messageType, const Session &session, uint32_t size) // edit
+{
+  X2Header x2Header;
+  x2Header.SetMessageType (messageType);
+  x2Header.SetProcedureCode (X2Header::HandoverPreparation);
+  x2Header.SetLengthOfIes (1);
+  x2Header.SetNumberOfIes (1);
+
+  // the target eNB looks the migration up by source cell and migration id
+  NS_ASSERT (size >= x2Header.GetSerializedSize () + 4);
+  std::vector<uint8_t> buf (size - x2Header.GetSerializedSize (), 0);
+  buf[0] = session.m_sourceCellId >> 8;
+  buf[1] = session.m_sourceCellId & 0xff;
+  buf[2] = session.m_ueId >> 8;
+  buf[3] = session.m_ueId & 0xff;
+  Ptr<Packet> packet = Create<Packet> (&buf[0], buf.size ());
+  packet->AddHeader (x2Header);
+  return packet;
+}
 
+void
+UdpEchoServer2::CloseSession (std::map<uint64_t, Session>::iterator it) // edit
+{
+  SessionRecord record;
+  record.m_sourceCellId = it->second.m_sourceCellId;
+  record.m_targetCellId = it->second.m_targetCellId;
+  record.m_ueId = it->second.m_ueId;
+  record.m_start = it->second.m_start;
+  record.m_latency = Simulator::Now () - it->second.m_start;
+  NS_LOG_INFO ("Session of UE " << record.m_ueId << " from cell " << record.m_sourceCellId << " to cell "
+               << record.m_targetCellId << " done in " << record.m_latency.GetSeconds () << "s");
+  m_sessions.erase (it);
+  m_records.push_back (record);
+  m_sessionLatency.Record (record.m_latency.GetMicroSeconds ());
+  m_sessionTrace (record.m_sourceCellId, record.m_targetCellId, record.m_ueId, record.m_latency);
+}
 
+void
+UdpEchoServer2::WriteSessions (void) // edit
+{
+  if (m_outputFilename.empty ())
+    {
+      return;
+    }
+  std::ofstream out (m_outputFilename.c_str ());
+  if (!out.is_open ())
+    {
+      NS_LOG_ERROR ("Can't open file " << m_outputFilename);
+      return;
+    }
+  out << "% sessions\topen\tmaxOpen\tp50(ms)\tp90(ms)\tp99(ms)\tmax(ms)\n";
+  out << "% " << m_records.size () << "\t" << m_sessions.size () << "\t" << m_maxSessions
+      << "\t" << m_sessionLatency.GetValueAtPercentile (50) / 1000.0
+      << "\t" << m_sessionLatency.GetValueAtPercentile (90) / 1000.0
+      << "\t" << m_sessionLatency.GetValueAtPercentile (99) / 1000.0
+      << "\t" << m_sessionLatency.GetMax () / 1000.0 << "\n";
+  out << "% source\ttarget\tue\tstart(s)\tlatency(ms)\n";
+  for (std::vector<SessionRecord>::const_iterator it = m_records.begin (); it != m_records.end (); ++it)
+    {
+      out << it->m_sourceCellId << "\t" << it->m_targetCellId << "\t" << it->m_ueId << "\t"
+          << it->m_start.GetSeconds () << "\t" << it->m_latency.GetSeconds () * 1000.0 << "\n";
     }
 }
 
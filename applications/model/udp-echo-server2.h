@@ -23,6 +23,12 @@
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
 #include "ns3/address.h"
+#include "ns3/ipv4-address.h" // edit
+#include "ns3/nstime.h" // edit
+#include "ns3/traced-callback.h" // edit
+#include "latency-histogram.h" // edit
+#include <map> // edit
+#include <vector> // edit
 
 namespace ns3 {
 
@@ -36,9 +42,16 @@ class Packet;
 
 /**
  * \ingroup udpecho
- * \brief A Udp Echo server
+ * \brief The ICN mobility controller
  *
- * Every packet received is sent back.
+ * The target eNB of a handover notifies the controller, which tells the
+ * source and target eNBs to reconfigure their PITs and, with VmMigration,
+ * drives the migration of the VM of the UE: migration request, VM received,
+ * start VM command, VM started. Each VM migration is a session keyed by
+ * the source cell, target cell and the X2AP id of the UE at the target, so
+ * that any number of handovers can be coordinated at once. Without
+ * VmMigration the notifications are answered at once and no session is
+ * recorded.
  */
 class UdpEchoServer2 : public Application
 {
@@ -47,6 +60,13 @@ public:
   UdpEchoServer2 ();
   virtual ~UdpEchoServer2 ();
 
+  /**
+   * Set the address the controller reaches the X2-C socket of an eNB at.
+   * Otherwise the addresses are learnt from the notifications, which carry
+   * the address of the source eNB; a cell never heard of is an error.
+   */
+  void AddCell (uint16_t cellId, Ipv4Address address); // edit
+
 protected:
   virtual void DoDispose (void);
 
@@ -57,13 +77,81 @@ private:
 
   void HandleRead (Ptr<Socket> socket);
 
+  /**
+   * \param handovers the number of UEs the message is about
+   * \param sourceCellId the source cell of the handovers, 0 if unknown
+   * \param ueIds the X2AP ids of the UEs at the target, empty if unknown
+   * \return the payload of an ICN message for the eNBs
+   */
+  Ptr<Packet> CreateIcnPayload (uint16_t handovers, uint16_t sourceCellId, const std::vector<uint16_t> &ueIds); // new
+
+  enum SessionState_t // edit
+  {
+    SESSION_WAIT_VM_RECEIVED, ///< migration requested to the target
+    SESSION_WAIT_VM_STARTED   ///< start VM command sent to the target
+  };
+
+  struct Session // edit
+  {
+    uint16_t m_sourceCellId;
+    uint16_t m_targetCellId;
+    uint16_t m_ueId;          ///< X2AP id of the UE at the target, id of its VM migration
+    SessionState_t m_state;
+    Time m_start;
+  };
+
+  static uint64_t GetSessionKey (uint16_t sourceCellId, uint16_t targetCellId, uint16_t ueId); // edit
+
+  /**
+   * Handle the notification of the handovers accepted by a target eNB
+   */
+  void RecvNotification (Ptr<Socket> socket, Ptr<Packet> packet, const Address &from, uint16_t handovers); // edit
+
+  /**
+   * Handle the report of a target eNB, or of the neighbor the target placed
+   * the VM on, that the VM of a session was received, or started. The ICN
+   * message closing the session goes to the target eNB.
+   */
+  void RecvVmReport (Ptr<Socket> socket, Ptr<Packet> packet, const Address &from); // edit
+
+  void CloseSession (std::map<uint64_t, Session>::iterator it); // edit
+
+  Address GetCellAddress (uint16_t cellId) const; // edit
+
+  /**
+   * \return the command of the given type, naming the VM migration of the
+   * session, of the given size once the X2 header added
+   */
+  Ptr<Packet> CreateVmCommand (uint8_t messageType, const Session &session, uint32_t size); // edit
+
+  void WriteSessions (void); // edit
+
   uint16_t m_port;
   Ptr<Socket> m_socket;
   Ptr<Socket> m_socket6;
   Address m_local;
 
   uint32_t m_vmMigration; // edit
-  uint32_t m_msgCounter;
+  uint16_t m_enbPort; // edit
+  std::string m_outputFilename; // edit
+
+  std::map<uint16_t, Ipv4Address> m_cellAddresses; // edit
+  std::map<uint64_t, Session> m_sessions; // edit, by GetSessionKey
+  uint32_t m_maxSessions; // edit, most sessions open at once
+
+  struct SessionRecord // edit
+  {
+    uint16_t m_sourceCellId;
+    uint16_t m_targetCellId;
+    uint16_t m_ueId;
+    Time m_start;
+    Time m_latency;
+  };
+  std::vector<SessionRecord> m_records; // edit
+  LatencyHistogram m_sessionLatency; // edit, microseconds
+
+  //             source    target    UE        latency
+  TracedCallback<uint16_t, uint16_t, uint16_t, Time> m_sessionTrace; // edit
 };
 
 } // namespace ns3
@@ -47,7 +47,10 @@ public:
     IcnMessage              = 3,   // new
     IcnMessageSource        = 4,   // new
     MigrationRequest        = 5, // new
-    StartVmCmd              = 6
+    StartVmCmd              = 6,
+    X2Bundle                = 12, // new
+    PitTransfer             = 13, // new
+    VmReport                = 15 // new
   };
 
 private:
@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "zipf-alias-table.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include <cmath>
+#include <map>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ZipfAliasTable");
+
+ZipfAliasTable::ZipfAliasTable (uint32_t n, double alpha, double q)
+  : m_prob (n),
+    m_alias (n)
+{
+  NS_LOG_FUNCTION (this << n << alpha << q);
+  NS_ASSERT_MSG (n > 0, "empty catalog");
+
+  std::vector<double> scaled (n);
+  double sum = 0;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      scaled[i] = 1.0 / std::pow (i + 1 + q, alpha);
+      sum += scaled[i];
+    }
+
+  // each column holds an average of 1: split the columns below and above it
+  std::vector<uint32_t> small;
+  std::vector<uint32_t> large;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      scaled[i] *= n / sum;
+      if (scaled[i] < 1.0)
+        {
+          small.push_back (i);
+        }
+      else
+        {
+          large.push_back (i);
+        }
+    }
+
+  // fill each small column up to 1 with a part of a large one
+  while (!small.empty () && !large.empty ())
+    {
+      uint32_t s = small.back ();
+      small.pop_back ();
+      uint32_t l = large.back ();
+      large.pop_back ();
+      m_prob[s] = scaled[s];
+      m_alias[s] = l;
+      scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+      if (scaled[l] < 1.0)
+        {
+          small.push_back (l);
+        }
+      else
+        {
+          large.push_back (l);
+        }
+    }
+  // what is left is 1 up to the rounding errors
+  for (uint32_t i = 0; i < large.size (); ++i)
+    {
+      m_prob[large[i]] = 1.0;
+      m_alias[large[i]] = large[i];
+    }
+  for (uint32_t i = 0; i < small.size (); ++i)
+    {
+      m_prob[small[i]] = 1.0;
+      m_alias[small[i]] = small[i];
+    }
+}
+
+Ptr<ZipfAliasTable>
+ZipfAliasTable::Get (uint32_t n, double alpha, double q)
+{
+  static std::map<std::pair<uint32_t, std::pair<double, double> >, Ptr<ZipfAliasTable> > tables;
+  std::pair<uint32_t, std::pair<double, double> > key (n, std::make_pair (alpha, q));
+  Ptr<ZipfAliasTable> &table = tables[key];
+  if (table == 0)
+    {
+      table = Create<ZipfAliasTable> (n, alpha, q);
+    }
+  return table;
+}
+
+uint32_t
+ZipfAliasTable::GetN (void) const
+{
+  return m_prob.size ();
+}
+
+uint32_t
+ZipfAliasTable::Sample (double u1, double u2) const
+{
+  uint32_t column = (uint32_t) (u1 * m_prob.size ());
+  if (column >= m_prob.size ())
+    {
+      column = m_prob.size () - 1;
+    }
+  return (u2 < m_prob[column]) ? column : m_alias[column];
+}
+
+} // namespace ns3
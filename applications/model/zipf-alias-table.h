@@ -0,0 +1,71 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ZIPF_ALIAS_TABLE_H
+#define ZIPF_ALIAS_TABLE_H
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/ptr.h"
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup udpecho
+ * \brief Mandelbrot-Zipf popularity of a content catalog, sampled in O(1)
+ *
+ * The item of rank i (0 the most popular) is requested with a probability
+ * proportional to 1 / (i + 1 + q)^alpha; q = 0 gives a pure Zipf law. The
+ * distribution is turned into an alias table (Vose) when the table is
+ * built, so that drawing a rank costs two uniform numbers and a lookup
+ * whatever the size of the catalog.
+ */
+class ZipfAliasTable : public SimpleRefCount<ZipfAliasTable>
+{
+public:
+  /**
+   * \param n the number of items of the catalog
+   * \param alpha the exponent of the law
+   * \param q the plateau, flattening the most popular ranks
+   */
+  ZipfAliasTable (uint32_t n, double alpha, double q);
+
+  /**
+   * Tables are built in O(n) and are read-only afterwards: the applications
+   * using the same catalog share a single one.
+   *
+   * \return the table of the given parameters
+   */
+  static Ptr<ZipfAliasTable> Get (uint32_t n, double alpha, double q);
+
+  uint32_t GetN (void) const;
+
+  /**
+   * \param u1 a uniform number in [0, 1), picking the column
+   * \param u2 a uniform number in [0, 1), picking the column or its alias
+   * \return a rank in [0, n)
+   */
+  uint32_t Sample (double u1, double u2) const;
+
+private:
+  std::vector<double> m_prob;    ///< probability of keeping each column
+  std::vector<uint32_t> m_alias; ///< rank drawn instead of the column otherwise
+};
+
+} // namespace ns3
+
+#endif /* ZIPF_ALIAS_TABLE_H */
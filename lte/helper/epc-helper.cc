@@ -39,6 +39,10 @@
 #include <ns3/lte-ue-net-device.h>
 #include <ns3/epc-mme.h>
 #include <ns3/epc-ue-nas.h>
+#include <ns3/boolean.h>
+#include <ns3/simulator.h>
+
+#include <algorithm>
 
 namespace ns3 {
 
@@ -48,7 +52,8 @@ NS_OBJECT_ENSURE_REGISTERED (EpcHelper);
 
 
 EpcHelper::EpcHelper ()
-  : m_gtpuUdpPort (2152)  // fixed by the standard
+  : m_gtpuUdpPort (2152),  // fixed by the standard
+    m_x2Anr (false)
 {
   NS_LOG_FUNCTION (this);
 
@@ -104,7 +109,8 @@ EpcHelper::EpcHelper ()
 
 
 EpcHelper::EpcHelper (Ptr<Node> pgw)
-  : m_gtpuUdpPort (2152)  // fixed by the standard
+  : m_gtpuUdpPort (2152),  // fixed by the standard
+    m_x2Anr (false)
 {
   NS_LOG_FUNCTION (this);
 
@@ -200,6 +206,19 @@ EpcHelper::GetTypeId (void)
                    UintegerValue (3000),
                    MakeUintegerAccessor (&EpcHelper::m_x2LinkMtu),
                    MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("X2Anr",
+                   "If true, the X2 interface between two eNBs is set up on the first "
+                   "handover or measurement report involving both, instead of when "
+                   "LteHelper::AddX2Interface is called. Must be set before the eNBs are added.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&EpcHelper::m_x2Anr),
+                   MakeBooleanChecker ())
+    .AddAttribute ("X2AnrIdleTimeout",
+                   "The X2 interfaces set up on demand are removed after being unused "
+                   "for this time. Zero means they are never removed.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&EpcHelper::m_x2AnrIdleTimeout),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
@@ -208,6 +227,9 @@ void
 EpcHelper::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
+  m_x2AnrAgingEvent.Cancel ();
+  m_enbNodeByCellId.clear ();
+  m_x2AnrRelations.clear ();
   m_tunDevice->SetSendCallback (MakeNullCallback<bool, Ptr<Packet>, const Address&, const Address&, uint16_t> ());
   m_tunDevice = 0;
   m_sgwPgwApp = 0;
@@ -284,6 +306,17 @@ EpcHelper::AddEnb (Ptr<Node> enb, Ptr<NetDevice> lteEnbNetDevice, uint16_t cellI
   Ptr<EpcX2> x2 = CreateObject<EpcX2> ();
   enb->AggregateObject (x2);
 
+  // the VM placement engine predicts the next cell of the UEs from their reports
+  Ptr<LteEnbRrc> rrc = lteEnbNetDevice->GetObject<LteEnbNetDevice> ()->GetRrc ();
+  rrc->TraceConnectWithoutContext ("RecvMeasurementReport", MakeCallback (&EpcX2::RecvMeasurementReport, x2));
+
+  if (m_x2Anr)
+    {
+      m_enbNodeByCellId[cellId] = enb;
+      x2->SetX2InterfaceRequestCallback (MakeCallback (&EpcHelper::AddX2InterfaceOnDemand, this));
+      rrc->TraceConnectWithoutContext ("RecvMeasurementReport", MakeCallback (&EpcHelper::RecvMeasurementReport, this));
+    }
+
   NS_LOG_INFO ("connect S1-AP interface");
   m_mme->AddEnb (cellId, enbAddress, enbApp->GetS1apSapEnb ());
   m_sgwPgwApp->AddEnb (cellId, enbAddress, sgwAddress);
@@ -336,6 +369,89 @@ EpcHelper::AddX2Interface (Ptr<Node> enb1, Ptr<Node> enb2)
   enb2X2->AddX2Interface (enb2CellId, enb2X2Address, enb1CellId, enb1X2Address);
 }
 
+bool
+EpcHelper::IsX2AnrEnabled () const
+{
+  return m_x2Anr;
+}
+
+void
+EpcHelper::AddX2InterfaceOnDemand (uint16_t localCellId, uint16_t remoteCellId)
+{
+  NS_LOG_FUNCTION (this << localCellId << remoteCellId);
+
+  std::map<uint16_t, Ptr<Node> >::iterator localIt = m_enbNodeByCellId.find (localCellId);
+  std::map<uint16_t, Ptr<Node> >::iterator remoteIt = m_enbNodeByCellId.find (remoteCellId);
+  if (localCellId == remoteCellId || localIt == m_enbNodeByCellId.end () || remoteIt == m_enbNodeByCellId.end ())
+    {
+      NS_LOG_LOGIC ("no eNB of the EPC for cell " << remoteCellId);
+      return;
+    }
+  if (localIt->second->GetObject<EpcX2> ()->HasX2Interface (remoteCellId))
+    {
+      return;
+    }
+
+  NS_LOG_INFO ("setting up the X2 interface between cells " << localCellId << " and " << remoteCellId);
+  AddX2Interface (localIt->second, remoteIt->second);
+  m_x2AnrRelations.insert (std::make_pair (std::min (localCellId, remoteCellId),
+                                           std::max (localCellId, remoteCellId)));
+
+  if (m_x2AnrIdleTimeout > Seconds (0) && !m_x2AnrAgingEvent.IsRunning ())
+    {
+      m_x2AnrAgingEvent = Simulator::Schedule (m_x2AnrIdleTimeout, &EpcHelper::AgeX2Interfaces, this);
+    }
+}
+
+void
+EpcHelper::RecvMeasurementReport (uint64_t imsi, uint16_t cellId, uint16_t rnti, LteRrcSap::MeasurementReport report)
+{
+  NS_LOG_FUNCTION (this << imsi << cellId << rnti);
+
+  if (!report.measResults.haveMeasResultNeighCells)
+    {
+      return;
+    }
+  // the physical cell id of the neighbors is their cell id
+  for (std::list<LteRrcSap::MeasResultEutra>::iterator it = report.measResults.measResultListEutra.begin ();
+       it != report.measResults.measResultListEutra.end ();
+       ++it)
+    {
+      AddX2InterfaceOnDemand (cellId, it->physCellId);
+    }
+}
+
+void
+EpcHelper::AgeX2Interfaces ()
+{
+  NS_LOG_FUNCTION (this);
+
+  std::set<std::pair<uint16_t, uint16_t> >::iterator it = m_x2AnrRelations.begin ();
+  while (it != m_x2AnrRelations.end ())
+    {
+      Ptr<EpcX2> x2First = m_enbNodeByCellId[it->first]->GetObject<EpcX2> ();
+      Ptr<EpcX2> x2Second = m_enbNodeByCellId[it->second]->GetObject<EpcX2> ();
+      Time lastUse = std::max (x2First->GetX2InterfaceLastUse (it->second),
+                               x2Second->GetX2InterfaceLastUse (it->first));
+      if (Simulator::Now () - lastUse >= m_x2AnrIdleTimeout)
+        {
+          NS_LOG_INFO ("removing the X2 interface between cells " << it->first << " and " << it->second);
+          x2First->RemoveX2Interface (it->second);
+          x2Second->RemoveX2Interface (it->first);
+          m_x2AnrRelations.erase (it++);
+        }
+      else
+        {
+          ++it;
+        }
+    }
+
+  if (!m_x2AnrRelations.empty ())
+    {
+      m_x2AnrAgingEvent = Simulator::Schedule (m_x2AnrIdleTimeout, &EpcHelper::AgeX2Interfaces, this);
+    }
+}
+
 
 void
 EpcHelper::AddUe (Ptr<NetDevice> ueDevice, uint64_t imsi)
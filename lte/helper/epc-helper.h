@@ -29,6 +29,12 @@
 #include <ns3/epc-tft.h>
 #include <ns3/eps-bearer.h>
 #include <ns3/node-container.h>
+#include <ns3/nstime.h>
+#include <ns3/event-id.h>
+#include <ns3/lte-rrc-sap.h>
+
+#include <map>
+#include <set>
 
 namespace ns3 {
 
@@ -94,6 +100,12 @@ public:
    */
   void AddX2Interface (Ptr<Node> enbNode1, Ptr<Node> enbNode2);
 
+  /**
+   * \return true if the X2 interfaces are set up on demand by the automatic
+   * neighbour relation function, see the X2Anr attribute
+   */
+  bool IsX2AnrEnabled () const;
+
   /**
    * Activate an EPS bearer, setting up the corresponding S1-U tunnel.
    *
@@ -185,6 +197,39 @@ private:
   Time     m_x2LinkDelay;
   uint16_t m_x2LinkMtu;
 
+  /**
+   * Automatic neighbour relation: set up the X2 interface between the two
+   * given cells if it does not exist yet
+   */
+  void AddX2InterfaceOnDemand (uint16_t localCellId, uint16_t remoteCellId);
+
+  /**
+   * Sink of the RecvMeasurementReport trace of the eNB RRCs, setting up the
+   * X2 interfaces towards the reported neighbors
+   */
+  void RecvMeasurementReport (uint64_t imsi, uint16_t cellId, uint16_t rnti, LteRrcSap::MeasurementReport report);
+
+  /**
+   * Remove the X2 interfaces set up on demand which have not been used for
+   * m_x2AnrIdleTimeout
+   */
+  void AgeX2Interfaces ();
+
+  bool m_x2Anr;
+  Time m_x2AnrIdleTimeout;
+
+  /**
+   * eNB nodes by cell id, the candidates of the X2 interfaces set up on demand
+   */
+  std::map<uint16_t, Ptr<Node> > m_enbNodeByCellId;
+
+  /**
+   * X2 interfaces set up on demand, as (lower cell id, higher cell id)
+   */
+  std::set<std::pair<uint16_t, uint16_t> > m_x2AnrRelations;
+
+  EventId m_x2AnrAgingEvent;
+
 };
 
 
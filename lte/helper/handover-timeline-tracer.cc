@@ -0,0 +1,268 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "handover-timeline-tracer.h"
+#include <ns3/log.h>
+#include <ns3/string.h>
+#include <ns3/simulator.h>
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("HandoverTimelineTracer");
+
+NS_OBJECT_ENSURE_REGISTERED (HandoverTimelineTracer);
+
+static const char * const g_handoverPhaseNames[LteEnbRrc::HO_N_PHASES] =
+{
+  "prep", "ack", "snStatus", "detach", "rach", "pathSwitch", "controller", "firstData", "release"
+};
+
+HandoverTimelineTracer::HandoverTimelineTracer ()
+  : m_outputFilename ("HandoverTimeline.txt")
+{
+  NS_LOG_FUNCTION (this);
+}
+
+HandoverTimelineTracer::~HandoverTimelineTracer ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+HandoverTimelineTracer::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::HandoverTimelineTracer")
+    .SetParent<Object> ()
+    .AddConstructor<HandoverTimelineTracer> ()
+    .AddAttribute ("OutputFilename",
+                   "Name of the file where the handover timelines will be saved.",
+                   StringValue ("HandoverTimeline.txt"),
+                   MakeStringAccessor (&HandoverTimelineTracer::SetOutputFilename),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+void
+HandoverTimelineTracer::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_outFile.is_open ())
+    {
+      m_outFile.close ();
+    }
+  m_open.clear ();
+  Object::DoDispose ();
+}
+
+void
+HandoverTimelineTracer::SetOutputFilename (std::string outputFilename)
+{
+  m_outputFilename = outputFilename;
+}
+
+std::string
+HandoverTimelineTracer::GetOutputFilename (void) const
+{
+  return m_outputFilename;
+}
+
+void
+HandoverTimelineTracer::RecordPhase (uint64_t imsi, uint16_t cellId, uint8_t phase)
+{
+  NS_LOG_FUNCTION (this << imsi << cellId << (uint32_t) phase);
+  NS_ASSERT (phase < LteEnbRrc::HO_N_PHASES);
+
+  std::map<uint64_t, Timeline>::iterator it = m_open.find (imsi);
+  if (phase == LteEnbRrc::HO_PREPARATION)
+    {
+      if (it != m_open.end ())
+        {
+          // the previous handover of the UE did not go through all the phases
+          Complete (imsi, it->second);
+          m_open.erase (it);
+        }
+      Timeline &timeline = m_open[imsi];
+      timeline.m_sourceCellId = cellId;
+      timeline.m_targetCellId = 0;
+      for (uint8_t p = 0; p < LteEnbRrc::HO_N_PHASES; ++p)
+        {
+          timeline.m_seen[p] = false;
+        }
+      timeline.m_time[phase] = Simulator::Now ();
+      timeline.m_seen[phase] = true;
+      timeline.m_nSeen = 1;
+      return;
+    }
+
+  if (it == m_open.end () || it->second.m_seen[phase])
+    {
+      return;
+    }
+  Timeline &timeline = it->second;
+  if (phase == LteEnbRrc::HO_RACH && !timeline.m_seen[LteEnbRrc::HO_DETACH])
+    {
+      // a random access of the UE which is not part of the handover
+      return;
+    }
+  switch (phase)
+    {
+    case LteEnbRrc::HO_SN_STATUS_TRANSFER:
+    case LteEnbRrc::HO_RACH:
+    case LteEnbRrc::HO_PATH_SWITCH:
+    case LteEnbRrc::HO_FIRST_DATA:
+      timeline.m_targetCellId = cellId;
+      break;
+    default:
+      break;
+    }
+  timeline.m_time[phase] = Simulator::Now ();
+  timeline.m_seen[phase] = true;
+  if (++timeline.m_nSeen == LteEnbRrc::HO_N_PHASES)
+    {
+      Complete (imsi, timeline);
+      m_open.erase (it);
+    }
+}
+
+void
+HandoverTimelineTracer::Complete (uint64_t imsi, const Timeline &timeline)
+{
+  NS_LOG_FUNCTION (this << imsi);
+
+  if (!m_outFile.is_open ())
+    {
+      m_outFile.open (m_outputFilename.c_str ());
+      if (!m_outFile.is_open ())
+        {
+          NS_LOG_ERROR ("Can't open file " << m_outputFilename.c_str ());
+          return;
+        }
+      m_outFile << "% imsi\tsource\ttarget\tstart(s)";
+      for (uint8_t p = 1; p < LteEnbRrc::HO_N_PHASES; ++p)
+        {
+          m_outFile << "\t" << g_handoverPhaseNames[p] << "(ms)";
+        }
+      m_outFile << "\tinterruption(ms)" << std::endl;
+    }
+
+  // times relative to the preparation, - for the phases not seen
+  Time start = timeline.m_time[LteEnbRrc::HO_PREPARATION];
+  m_outFile << imsi << "\t" << timeline.m_sourceCellId << "\t" << timeline.m_targetCellId
+            << "\t" << start.GetSeconds ();
+  for (uint8_t p = 1; p < LteEnbRrc::HO_N_PHASES; ++p)
+    {
+      if (timeline.m_seen[p])
+        {
+          double delay = (timeline.m_time[p] - start).GetSeconds () * 1000.0;
+          m_phaseDelays[p].push_back (delay);
+          m_outFile << "\t" << delay;
+        }
+      else
+        {
+          m_outFile << "\t-";
+        }
+    }
+  if (timeline.m_seen[LteEnbRrc::HO_DETACH] && timeline.m_seen[LteEnbRrc::HO_FIRST_DATA])
+    {
+      double interruption = (timeline.m_time[LteEnbRrc::HO_FIRST_DATA]
+                             - timeline.m_time[LteEnbRrc::HO_DETACH]).GetSeconds () * 1000.0;
+      m_interruptions.push_back (interruption);
+      m_outFile << "\t" << interruption;
+    }
+  else
+    {
+      m_outFile << "\t-";
+    }
+  m_outFile << std::endl;
+}
+
+double
+HandoverTimelineTracer::Percentile (std::vector<double> &values, double p)
+{
+  NS_ASSERT (!values.empty ());
+  std::sort (values.begin (), values.end ());
+  uint32_t rank = (uint32_t) std::ceil (p / 100.0 * values.size ());
+  return values[(rank > 0) ? rank - 1 : 0];
+}
+
+void
+HandoverTimelineTracer::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  for (std::map<uint64_t, Timeline>::iterator it = m_open.begin (); it != m_open.end (); ++it)
+    {
+      Complete (it->first, it->second);
+    }
+  m_open.clear ();
+
+  if (!m_outFile.is_open ())
+    {
+      return;
+    }
+  m_outFile << "% phase\tcount\tp50(ms)\tp90(ms)\tp99(ms)\tmax(ms)" << std::endl;
+  for (uint8_t p = 1; p <= LteEnbRrc::HO_N_PHASES; ++p)
+    {
+      // the interruption time comes after the phases
+      std::vector<double> &values = (p < LteEnbRrc::HO_N_PHASES) ? m_phaseDelays[p] : m_interruptions;
+      m_outFile << "% " << ((p < LteEnbRrc::HO_N_PHASES) ? g_handoverPhaseNames[p] : "interruption")
+                << "\t" << values.size ();
+      if (!values.empty ())
+        {
+          m_outFile << "\t" << Percentile (values, 50) << "\t" << Percentile (values, 90)
+                    << "\t" << Percentile (values, 99) << "\t" << values.back ();
+        }
+      m_outFile << std::endl;
+    }
+  m_outFile.close ();
+}
+
+void
+HandoverTimelineTracer::HandoverPhaseCallback (Ptr<HandoverTimelineTracer> tracer, std::string path,
+                                               uint64_t imsi, uint16_t cellId, uint16_t rnti, uint8_t phase)
+{
+  NS_LOG_FUNCTION (tracer << path << imsi << cellId << rnti << (uint32_t) phase);
+  tracer->RecordPhase (imsi, cellId, phase);
+}
+
+void
+HandoverTimelineTracer::UeHandoverStartCallback (Ptr<HandoverTimelineTracer> tracer, std::string path,
+                                                 uint64_t imsi, uint16_t cellId, uint16_t rnti, uint16_t targetCellId)
+{
+  NS_LOG_FUNCTION (tracer << path << imsi << cellId << rnti << targetCellId);
+  tracer->RecordPhase (imsi, cellId, LteEnbRrc::HO_DETACH);
+}
+
+void
+HandoverTimelineTracer::UeRandomAccessCallback (Ptr<HandoverTimelineTracer> tracer, std::string path,
+                                                uint64_t imsi, uint16_t cellId, uint16_t rnti)
+{
+  NS_LOG_FUNCTION (tracer << path << imsi << cellId << rnti);
+  tracer->RecordPhase (imsi, cellId, LteEnbRrc::HO_RACH);
+}
+
+void
+HandoverTimelineTracer::IcnMessageCallback (Ptr<HandoverTimelineTracer> tracer, std::string path, uint64_t imsi)
+{
+  NS_LOG_FUNCTION (tracer << path << imsi);
+  // the target cell is known from the other phases
+  tracer->RecordPhase (imsi, 0, LteEnbRrc::HO_CONTROLLER);
+}
+
+} // namespace ns3
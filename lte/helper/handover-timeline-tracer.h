@@ -0,0 +1,120 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef HANDOVER_TIMELINE_TRACER_H
+#define HANDOVER_TIMELINE_TRACER_H
+
+#include <ns3/object.h>
+#include <ns3/nstime.h>
+#include <ns3/lte-enb-rrc.h>
+#include <string>
+#include <fstream>
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup lte
+ *
+ * Records, per IMSI, when each phase of a handover happens (see
+ * LteEnbRrc::HandoverPhase_t) and writes a single file holding one line
+ * per handover, with the time of every phase relative to the preparation
+ * and the interruption time (from the detach to the first packet sent to
+ * the UE by the target eNB once it has joined), followed by the
+ * percentiles of each of them.
+ *
+ * A handover is written out when all its phases have been seen, when the
+ * UE starts another handover, or when the simulation is destroyed.
+ */
+class HandoverTimelineTracer : public Object
+{
+public:
+  HandoverTimelineTracer ();
+  virtual ~HandoverTimelineTracer ();
+
+  static TypeId GetTypeId (void);
+  virtual void DoDispose (void);
+
+  void SetOutputFilename (std::string outputFilename);
+  std::string GetOutputFilename (void) const;
+
+  /**
+   * Record that the handover of a UE reached a phase. HO_PREPARATION opens
+   * a new timeline for the UE; the other phases are ignored when the UE is
+   * not being handed over, and only their first occurrence counts.
+   *
+   * \param imsi the IMSI of the UE
+   * \param cellId the cell which saw the phase
+   * \param phase the phase, a LteEnbRrc::HandoverPhase_t
+   */
+  void RecordPhase (uint64_t imsi, uint16_t cellId, uint8_t phase);
+
+  /**
+   * Write out the handovers still open and the percentile summary
+   */
+  void Flush (void);
+
+  // trace sinks, to be connected with MakeBoundCallback
+  static void HandoverPhaseCallback (Ptr<HandoverTimelineTracer> tracer, std::string path,
+                                     uint64_t imsi, uint16_t cellId, uint16_t rnti, uint8_t phase);
+  static void UeHandoverStartCallback (Ptr<HandoverTimelineTracer> tracer, std::string path,
+                                       uint64_t imsi, uint16_t cellId, uint16_t rnti, uint16_t targetCellId);
+  static void UeRandomAccessCallback (Ptr<HandoverTimelineTracer> tracer, std::string path,
+                                      uint64_t imsi, uint16_t cellId, uint16_t rnti);
+  static void IcnMessageCallback (Ptr<HandoverTimelineTracer> tracer, std::string path, uint64_t imsi);
+
+private:
+  struct Timeline
+  {
+    uint16_t m_sourceCellId;
+    uint16_t m_targetCellId;
+    Time m_time[LteEnbRrc::HO_N_PHASES];
+    bool m_seen[LteEnbRrc::HO_N_PHASES];
+    uint32_t m_nSeen;
+  };
+
+  /**
+   * Write the line of a handover and account for it in the summary
+   */
+  void Complete (uint64_t imsi, const Timeline &timeline);
+
+  /**
+   * \param values the samples, sorted in place
+   * \param p the percentile, in [0, 100]
+   * \return the nearest-rank percentile of the samples
+   */
+  static double Percentile (std::vector<double> &values, double p);
+
+  std::string m_outputFilename;
+  std::ofstream m_outFile;
+
+  /**
+   * handovers in progress, by IMSI
+   */
+  std::map<uint64_t, Timeline> m_open;
+
+  /**
+   * samples of the completed handovers, in ms: time of each phase since the
+   * preparation, and interruption time
+   */
+  std::vector<double> m_phaseDelays[LteEnbRrc::HO_N_PHASES];
+  std::vector<double> m_interruptions;
+};
+
+} // namespace ns3
+
+#endif // HANDOVER_TIMELINE_TRACER_H
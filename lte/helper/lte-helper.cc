@@ -54,6 +54,10 @@
 #include <ns3/buildings-propagation-loss-model.h>
 #include <ns3/lte-spectrum-value-helper.h>
 #include <ns3/epc-x2.h>
+#include <ns3/trace-source-accessor.h>
+#include <ns3/node-list.h>
+#include <sstream>
+#include <stdlib.h>
 
 NS_LOG_COMPONENT_DEFINE ("LteHelper");
 
@@ -63,7 +67,9 @@ NS_OBJECT_ENSURE_REGISTERED (LteHelper);
 
 LteHelper::LteHelper (void)
   :   m_imsiCounter (0),
-      m_cellIdCounter (0)
+      m_cellIdCounter (0),
+      m_groupHandoverCounter (0),
+      m_groupHandoverAggregation (true)
 {
   NS_LOG_FUNCTION (this);
   m_enbNetDeviceFactory.SetTypeId (LteEnbNetDevice::GetTypeId ());
@@ -158,6 +164,19 @@ TypeId LteHelper::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&LteHelper::m_useIdealRrc),
                    MakeBooleanChecker ())
+    .AddAttribute ("GroupHandoverAggregation",
+                   "If true, the signaling of the UEs handed over by GroupHandoverRequest "
+                   "is aggregated. If false, the UEs are handed over one by one, which "
+                   "gives the reference to compare the signaling load and the "
+                   "completion time with.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&LteHelper::m_groupHandoverAggregation),
+                   MakeBooleanChecker ())
+    .AddTraceSource ("GroupHandoverCompleted",
+                     "The last UE of a group handover is connected to the target eNB: "
+                     "group id, number of UEs and time elapsed since the handover was "
+                     "initiated",
+                     MakeTraceSourceAccessor (&LteHelper::m_groupHandoverTrace))
   ;
   return tid;
 }
@@ -168,6 +187,8 @@ LteHelper::DoDispose ()
   NS_LOG_FUNCTION (this);
   m_downlinkChannel = 0;
   m_uplinkChannel = 0;
+  m_enbStatsContexts.clear ();
+  m_ueStatsContexts.clear ();
   Object::DoDispose ();
 }
 
@@ -730,6 +751,13 @@ LteHelper::AddX2Interface (NodeContainer enbNodes)
 {
   NS_LOG_FUNCTION (this);
 
+  if (m_epcHelper->IsX2AnrEnabled ())
+    {
+      // the X2 interfaces are set up on demand by the EpcHelper
+      NS_LOG_INFO ("X2 ANR enabled, no X2 interface set up");
+      return;
+    }
+
   for (NodeContainer::Iterator i = enbNodes.Begin (); i != enbNodes.End (); ++i)
     {
       for (NodeContainer::Iterator j = i + 1; j != enbNodes.End (); ++j)
@@ -767,6 +795,101 @@ LteHelper::DoHandoverRequest (Ptr<NetDevice> ueDev, Ptr<NetDevice> sourceEnbDev,
   sourceRrc->SendHandoverRequest (rnti, targetCellId);
 }
 
+void
+LteHelper::GroupHandoverRequest (Time hoTime, NetDeviceContainer ueDevices, Ptr<NetDevice> sourceEnbDev, Ptr<NetDevice> targetEnbDev)
+{
+  NS_LOG_FUNCTION (this << ueDevices.GetN () << sourceEnbDev << targetEnbDev);
+  NS_ASSERT_MSG (m_epcHelper, "Handover requires the use of the EPC - did you forget to call LteHelper::SetEpcHelper () ?");
+  Simulator::Schedule (hoTime, &LteHelper::DoGroupHandoverRequest, this, ++m_groupHandoverCounter, ueDevices, sourceEnbDev, targetEnbDev);
+}
+
+void
+LteHelper::DoGroupHandoverRequest (uint32_t groupId, NetDeviceContainer ueDevices, Ptr<NetDevice> sourceEnbDev, Ptr<NetDevice> targetEnbDev)
+{
+  NS_LOG_FUNCTION (this << groupId << ueDevices.GetN () << sourceEnbDev << targetEnbDev);
+
+  if (ueDevices.GetN () == 0)
+    {
+      return;
+    }
+
+  uint16_t targetCellId = targetEnbDev->GetObject<LteEnbNetDevice> ()->GetCellId ();
+  Ptr<LteEnbRrc> sourceRrc = sourceEnbDev->GetObject<LteEnbNetDevice> ()->GetRrc ();
+  Ptr<LteEnbRrc> targetRrc = targetEnbDev->GetObject<LteEnbNetDevice> ()->GetRrc ();
+
+  GroupHandoverInfo &group = m_groupHandovers[groupId];
+  group.m_startTime = Simulator::Now ();
+  group.m_size = ueDevices.GetN ();
+  group.m_targetCellId = targetCellId;
+  group.m_pending = 0;
+  for (NetDeviceContainer::Iterator i = ueDevices.Begin (); i != ueDevices.End (); ++i)
+    {
+      uint64_t imsi = (*i)->GetObject<LteUeNetDevice> ()->GetImsi ();
+      std::map<uint64_t, uint32_t>::iterator imsiIt = m_groupHandoverImsis.find (imsi);
+      if (imsiIt != m_groupHandoverImsis.end ())
+        {
+          // the UE leaves a group which has not completed yet
+          NS_LOG_WARN ("UE " << imsi << " moved from group handover " << imsiIt->second << " to " << groupId);
+          std::map<uint32_t, GroupHandoverInfo>::iterator oldIt = m_groupHandovers.find (imsiIt->second);
+          if (oldIt != m_groupHandovers.end () && --oldIt->second.m_pending == 0)
+            {
+              m_groupHandovers.erase (oldIt);
+            }
+        }
+      m_groupHandoverImsis[imsi] = groupId;
+      ++group.m_pending;
+    }
+  // a single sink per target eNB, whatever the number of groups
+  if (m_groupHandoverTargets.insert (targetCellId).second)
+    {
+      targetRrc->TraceConnectWithoutContext ("HandoverEndOk", MakeCallback (&LteHelper::GroupHandoverEndOk, this));
+    }
+
+  // the X2 messages sent to the target eNB while the bundle is open leave
+  // in a single X2 message, and the target eNB answers in the same way
+  Ptr<EpcX2> sourceX2 = sourceEnbDev->GetNode ()->GetObject<EpcX2> ();
+  NS_ASSERT_MSG (sourceX2 != 0, "no X2 entity on the source eNB");
+  if (m_groupHandoverAggregation)
+    {
+      sourceX2->BeginX2Bundle (targetCellId);
+    }
+  for (NetDeviceContainer::Iterator i = ueDevices.Begin (); i != ueDevices.End (); ++i)
+    {
+      uint16_t rnti = (*i)->GetObject<LteUeNetDevice> ()->GetRrc ()->GetRnti ();
+      sourceRrc->SendHandoverRequest (rnti, targetCellId);
+    }
+  if (m_groupHandoverAggregation)
+    {
+      sourceX2->EndX2Bundle (targetCellId);
+    }
+}
+
+void
+LteHelper::GroupHandoverEndOk (uint64_t imsi, uint16_t cellId, uint16_t rnti)
+{
+  NS_LOG_FUNCTION (this << imsi << cellId << rnti);
+
+  std::map<uint64_t, uint32_t>::iterator imsiIt = m_groupHandoverImsis.find (imsi);
+  if (imsiIt == m_groupHandoverImsis.end ())
+    {
+      return;
+    }
+  uint32_t groupId = imsiIt->second;
+  std::map<uint32_t, GroupHandoverInfo>::iterator it = m_groupHandovers.find (groupId);
+  if (it == m_groupHandovers.end () || it->second.m_targetCellId != cellId)
+    {
+      return;
+    }
+  m_groupHandoverImsis.erase (imsiIt);
+  if (--it->second.m_pending == 0)
+    {
+      Time elapsed = Simulator::Now () - it->second.m_startTime;
+      NS_LOG_INFO ("group handover " << groupId << " of " << it->second.m_size << " UEs completed in " << elapsed);
+      m_groupHandoverTrace (groupId, it->second.m_size, elapsed);
+      m_groupHandovers.erase (it);
+    }
+}
+
 
 
 
@@ -865,264 +988,99 @@ LteHelper::AssignStreams (NetDeviceContainer c, int64_t stream)
   return (currentStream - stream);
 }
 
-uint64_t
-FindImsiFromEnbRlcPath (std::string path)
+std::vector<Ptr<EnbStatsContext> >
+LteHelper::GetEnbStatsContexts (void)
 {
-  NS_LOG_FUNCTION (path);
-  // Sample path input:
-  // /NodeList/#NodeId/DeviceList/#DeviceId/LteEnbRrc/UeMap/#C-RNTI/DataRadioBearerMap/#LCID/LteRlc/RxPDU
-
-  // We retrieve the UeManager associated to the C-RNTI and perform the IMSI lookup
-  std::string ueMapPath = path.substr (0, path.find ("/DataRadioBearerMap"));
-  Config::MatchContainer match = Config::LookupMatches (ueMapPath);
-
-  if (match.GetN () != 0)
-    {
-      Ptr<Object> ueInfo = match.Get (0);
-      NS_LOG_LOGIC ("FindImsiFromEnbRlcPath: " << path << ", " << ueInfo->GetObject<UeManager> ()->GetImsi ());
-      return ueInfo->GetObject<UeManager> ()->GetImsi ();
-    }
-  else
-    {
-      NS_FATAL_ERROR ("Lookup " << ueMapPath << " got no matches");
-    }
-}
-
-uint64_t
-FindImsiFromUePhy (std::string path)
-{
-  NS_LOG_FUNCTION (path);
-  // Sample path input:
-  // /NodeList/#NodeId/DeviceList/#DeviceId/LteUePhy
-
-  // We retrieve the UeInfo associated to the C-RNTI and perform the IMSI lookup
-  std::string ueRlcPath = path.substr (0, path.find ("/LteUePhy"));
-  ueRlcPath += "/LteUeRrc";
-  Config::MatchContainer match = Config::LookupMatches (ueRlcPath);
-
-  if (match.GetN () != 0)
-    {
-      Ptr<Object> ueRrc = match.Get (0);
-      return ueRrc->GetObject<LteUeRrc> ()->GetImsi ();
-    }
-  else
-    {
-      NS_FATAL_ERROR ("Lookup " << ueRlcPath << " got no matches");
-    }
-  return 0;
-}
-
-
-uint64_t
-FindImsiFromLteNetDevice (std::string path)
-{
-  NS_LOG_FUNCTION (path);
-  // Sample path input:
-  // /NodeList/#NodeId/DeviceList/#DeviceId/
-
-  // We retrieve the Imsi associated to the LteUeNetDevice
-  Config::MatchContainer match = Config::LookupMatches (path);
-
-  if (match.GetN () != 0)
-    {
-      Ptr<Object> ueNetDevice = match.Get (0);
-      NS_LOG_LOGIC ("FindImsiFromLteNetDevice: " << path << ", " << ueNetDevice->GetObject<LteUeNetDevice> ()->GetImsi ());
-      return ueNetDevice->GetObject<LteUeNetDevice> ()->GetImsi ();
-    }
-  else
-    {
-      NS_FATAL_ERROR ("Lookup " << path << " got no matches");
-    }
-}
-
-uint16_t
-FindCellIdFromEnbRlcPath (std::string path)
-{
-  NS_LOG_FUNCTION (path);
-  // Sample path input:
-  // /NodeList/#NodeId/DeviceList/#DeviceId/LteEnbRrc/UeMap/#C-RNTI/DataRadioBearerMap/#LCID/LteRlc/RxPDU
-
-  // We retrieve the CellId associated to the Enb
-  std::string enbNetDevicePath = path.substr (0, path.find ("/LteEnbRrc"));
-  Config::MatchContainer match = Config::LookupMatches (enbNetDevicePath);
-  if (match.GetN () != 0)
-    {
-      Ptr<Object> enbNetDevice = match.Get (0);
-      NS_LOG_LOGIC ("FindCellIdFromEnbRlcPath: " << path << ", " << enbNetDevice->GetObject<LteEnbNetDevice> ()->GetCellId ());
-      return enbNetDevice->GetObject<LteEnbNetDevice> ()->GetCellId ();
-    }
-  else
-    {
-      NS_FATAL_ERROR ("Lookup " << enbNetDevicePath << " got no matches");
-    }
-}
-
-uint64_t
-FindImsiFromEnbMac (std::string path, uint16_t rnti)
-{
-  NS_LOG_FUNCTION (path << rnti);
-
-  // /NodeList/#NodeId/DeviceList/#DeviceId/LteEnbMac/DlScheduling
-  std::ostringstream oss;
-  std::string p = path.substr (0, path.find ("/LteEnbMac"));
-  oss << rnti;
-  p += "/LteEnbRrc/UeMap/" + oss.str ();
-  uint64_t imsi = FindImsiFromEnbRlcPath (p);
-  NS_LOG_LOGIC ("FindImsiFromEnbMac: " << path << ", " << rnti << ", " << imsi);
-  return imsi;
-}
-
-uint16_t
-FindCellIdFromEnbMac (std::string path, uint16_t rnti)
-{
-  NS_LOG_FUNCTION (path << rnti);
-  // /NodeList/#NodeId/DeviceList/#DeviceId/LteEnbMac/DlScheduling
-  std::ostringstream oss;
-  std::string p = path.substr (0, path.find ("/LteEnbMac"));
-  oss << rnti;
-  p += "/LteEnbRrc/UeMap/" + oss.str ();
-  uint16_t cellId = FindCellIdFromEnbRlcPath (p);
-  NS_LOG_LOGIC ("FindCellIdFromEnbMac: " << path << ", "<< rnti << ", " << cellId);
-  return cellId;
-}
-
-
-uint64_t
-FindImsiForEnb (std::string path, uint16_t rnti)
-{
-  NS_LOG_FUNCTION (path << rnti);
-  uint64_t imsi = 0;
-  if (path.find ("/DlPhyTransmission"))
-    {
-      // /NodeList/0/DeviceList/0/LteEnbPhy/DlPhyTransmission/LteEnbRrc/UeMap/1
-      std::ostringstream oss;
-      std::string p = path.substr (0, path.find ("/LteEnbPhy"));
-      oss << rnti;
-      p += "/LteEnbRrc/UeMap/" + oss.str ();
-      imsi = FindImsiFromEnbRlcPath (p);
-      NS_LOG_LOGIC ("FindImsiForEnb[Tx]: " << path << ", " << rnti << ", " << imsi);
-    }
-  else if (path.find ("/UlPhyReception"))
+  NS_LOG_FUNCTION (this);
+  std::vector<Ptr<EnbStatsContext> > contexts;
+  for (NodeList::Iterator nodeIt = NodeList::Begin (); nodeIt != NodeList::End (); ++nodeIt)
     {
-      std::string p = path.substr (0, path.find ("/LteUePhy"));
-      imsi = FindImsiFromLteNetDevice (p);
-      NS_LOG_LOGIC ("FindImsiForEnb[Rx]: " << path << ", " << rnti << ", " << imsi);
+      for (uint32_t i = 0; i < (*nodeIt)->GetNDevices (); ++i)
+        {
+          Ptr<NetDevice> device = (*nodeIt)->GetDevice (i);
+          Ptr<LteEnbNetDevice> enbDevice = DynamicCast<LteEnbNetDevice> (device);
+          if (enbDevice == 0)
+            {
+              continue;
+            }
+          std::map<Ptr<NetDevice>, Ptr<EnbStatsContext> >::iterator it = m_enbStatsContexts.find (device);
+          if (it == m_enbStatsContexts.end ())
+            {
+              Ptr<EnbStatsContext> context = Create<EnbStatsContext> (enbDevice);
+              context->m_phyStats = m_phyStats;
+              context->m_phyTxStats = m_phyTxStats;
+              context->m_phyRxStats = m_phyRxStats;
+              context->m_macStats = m_macStats;
+              context->ConnectRrcTraces ();
+              it = m_enbStatsContexts.insert (std::make_pair (device, context)).first;
+            }
+          contexts.push_back (it->second);
+        }
     }
-  return imsi;
+  return contexts;
 }
 
-
-uint64_t
-FindImsiForUe (std::string path, uint16_t rnti)
+std::vector<Ptr<UeStatsContext> >
+LteHelper::GetUeStatsContexts (void)
 {
-  NS_LOG_FUNCTION (path << rnti);
-  uint64_t imsi = 0;
-  if (path.find ("/UlPhyTransmission"))
-    {
-      std::string p = path.substr (0, path.find ("/LteUePhy"));
-      imsi = FindImsiFromLteNetDevice (p);
-      NS_LOG_LOGIC ("FindImsiForUe[Tx]: " << path << ", " << rnti << ", " << imsi);
-    }
-  else if (path.find ("/DlPhyReception"))
+  NS_LOG_FUNCTION (this);
+  std::vector<Ptr<UeStatsContext> > contexts;
+  for (NodeList::Iterator nodeIt = NodeList::Begin (); nodeIt != NodeList::End (); ++nodeIt)
     {
-      // /NodeList/0/DeviceList/0/LteEnbPhy/LteSpectrumPhy
-      std::ostringstream oss;
-      std::string p = path.substr (0, path.find ("/LteEnbPhy"));
-      oss << rnti;
-      p += "/LteEnbRrc/UeMap/" + oss.str ();
-      imsi = FindImsiFromEnbRlcPath (p);
-      NS_LOG_LOGIC ("FindImsiForUe[Rx]: " << path << ", " << rnti << ", " << imsi);
+      for (uint32_t i = 0; i < (*nodeIt)->GetNDevices (); ++i)
+        {
+          Ptr<NetDevice> device = (*nodeIt)->GetDevice (i);
+          Ptr<LteUeNetDevice> ueDevice = DynamicCast<LteUeNetDevice> (device);
+          if (ueDevice == 0)
+            {
+              continue;
+            }
+          std::map<Ptr<NetDevice>, Ptr<UeStatsContext> >::iterator it = m_ueStatsContexts.find (device);
+          if (it == m_ueStatsContexts.end ())
+            {
+              Ptr<UeStatsContext> context = Create<UeStatsContext> (ueDevice);
+              context->m_phyStats = m_phyStats;
+              context->m_phyTxStats = m_phyTxStats;
+              context->m_phyRxStats = m_phyRxStats;
+              it = m_ueStatsContexts.insert (std::make_pair (device, context)).first;
+            }
+          contexts.push_back (it->second);
+        }
     }
-  return imsi;
+  return contexts;
 }
 
 void
-DlPhyTransmissionCallback (Ptr<PhyTxStatsCalculator> phyTxStats,
-                      std::string path, PhyTransmissionStatParameters params)
-{
-  NS_LOG_FUNCTION (phyTxStats << path);
-  uint64_t imsi = 0;
-  std::ostringstream pathAndRnti;
-  pathAndRnti << path << "/" << params.m_rnti;
-  if (phyTxStats->ExistsImsiPath (pathAndRnti.str ()) == true)
-    {
-      imsi = phyTxStats->GetImsiPath (pathAndRnti.str ());
-    }
-  else
-    {
-      imsi = FindImsiForEnb (path, params.m_rnti);
-      phyTxStats->SetImsiPath (pathAndRnti.str (), imsi);
-    }
-
-  params.m_imsi = imsi;
-  phyTxStats->DlPhyTransmission (params);
+DlPhyTransmissionCallback (Ptr<EnbStatsContext> context, PhyTransmissionStatParameters params)
+{
+  NS_LOG_FUNCTION (context->GetCellId () << params.m_rnti);
+  params.m_imsi = context->GetImsi (params.m_rnti);
+  context->m_phyTxStats->DlPhyTransmission (params);
 }
 
 void
-UlPhyTransmissionCallback (Ptr<PhyTxStatsCalculator> phyTxStats,
-                      std::string path, PhyTransmissionStatParameters params)
-{
-  NS_LOG_FUNCTION (phyTxStats << path);
-  uint64_t imsi = 0;
-  std::ostringstream pathAndRnti;
-  pathAndRnti << path << "/" << params.m_rnti;
-  if (phyTxStats->ExistsImsiPath (pathAndRnti.str ()) == true)
-    {
-      imsi = phyTxStats->GetImsiPath (pathAndRnti.str ());
-    }
-  else
-    {
-      imsi = FindImsiForUe (path, params.m_rnti);
-      phyTxStats->SetImsiPath (pathAndRnti.str (), imsi);
-    }
-
-  params.m_imsi = imsi;
-  phyTxStats->UlPhyTransmission (params);
+UlPhyTransmissionCallback (Ptr<UeStatsContext> context, PhyTransmissionStatParameters params)
+{
+  NS_LOG_FUNCTION (context->GetImsi () << params.m_rnti);
+  params.m_imsi = context->GetImsi ();
+  context->m_phyTxStats->UlPhyTransmission (params);
 }
 
 
 void
-DlPhyReceptionCallback (Ptr<PhyRxStatsCalculator> phyRxStats,
-                      std::string path, PhyReceptionStatParameters params)
-{
-  NS_LOG_FUNCTION (phyRxStats << path);
-  uint64_t imsi = 0;
-  std::ostringstream pathAndRnti;
-  pathAndRnti << path << "/" << params.m_rnti;
-  if (phyRxStats->ExistsImsiPath (pathAndRnti.str ()) == true)
-    {
-      imsi = phyRxStats->GetImsiPath (pathAndRnti.str ());
-    }
-  else
-    {
-      imsi = FindImsiForUe (path, params.m_rnti);
-      phyRxStats->SetImsiPath (pathAndRnti.str (), imsi);
-    }
-
-  params.m_imsi = imsi;
-  phyRxStats->DlPhyReception (params);
+DlPhyReceptionCallback (Ptr<UeStatsContext> context, PhyReceptionStatParameters params)
+{
+  NS_LOG_FUNCTION (context->GetImsi () << params.m_rnti);
+  params.m_imsi = context->GetImsi ();
+  context->m_phyRxStats->DlPhyReception (params);
 }
 
 void
-UlPhyReceptionCallback (Ptr<PhyRxStatsCalculator> phyRxStats,
-                      std::string path, PhyReceptionStatParameters params)
-{
-  NS_LOG_FUNCTION (phyRxStats << path);
-  uint64_t imsi = 0;
-  std::ostringstream pathAndRnti;
-  pathAndRnti << path << "/" << params.m_rnti;
-  if (phyRxStats->ExistsImsiPath (pathAndRnti.str ()) == true)
-    {
-      imsi = phyRxStats->GetImsiPath (pathAndRnti.str ());
-    }
-  else
-    {
-      imsi = FindImsiForEnb (path, params.m_rnti);
-      phyRxStats->SetImsiPath (pathAndRnti.str (), imsi);
-    }
-
-  params.m_imsi = imsi;
-  phyRxStats->UlPhyReception (params);
+UlPhyReceptionCallback (Ptr<EnbStatsContext> context, PhyReceptionStatParameters params)
+{
+  NS_LOG_FUNCTION (context->GetCellId () << params.m_rnti);
+  params.m_imsi = context->GetImsi (params.m_rnti);
+  context->m_phyRxStats->UlPhyReception (params);
 }
 
 void
@@ -1139,65 +1097,58 @@ LteHelper::EnablePhyTraces (void)
 void
 LteHelper::EnableDlTxPhyTraces (void)
 {
-  Config::Connect ("/NodeList/*/DeviceList/*/LteEnbPhy/DlPhyTransmission",
-                   MakeBoundCallback (&DlPhyTransmissionCallback, m_phyTxStats));
+  std::vector<Ptr<EnbStatsContext> > contexts = GetEnbStatsContexts ();
+  for (std::vector<Ptr<EnbStatsContext> >::iterator it = contexts.begin (); it != contexts.end (); ++it)
+    {
+      (*it)->GetDevice ()->GetPhy ()->TraceConnectWithoutContext ("DlPhyTransmission",
+                                                                 MakeBoundCallback (&DlPhyTransmissionCallback, *it));
+    }
 }
 
 void
 LteHelper::EnableUlTxPhyTraces (void)
 {
-  Config::Connect ("/NodeList/*/DeviceList/*/LteUePhy/UlPhyTransmission",
-                   MakeBoundCallback (&UlPhyTransmissionCallback, m_phyTxStats));
+  std::vector<Ptr<UeStatsContext> > contexts = GetUeStatsContexts ();
+  for (std::vector<Ptr<UeStatsContext> >::iterator it = contexts.begin (); it != contexts.end (); ++it)
+    {
+      (*it)->GetDevice ()->GetPhy ()->TraceConnectWithoutContext ("UlPhyTransmission",
+                                                                 MakeBoundCallback (&UlPhyTransmissionCallback, *it));
+    }
 }
 
 void
 LteHelper::EnableDlRxPhyTraces (void)
 {
-  Config::Connect ("/NodeList/*/DeviceList/*/LteUePhy/DlSpectrumPhy/DlPhyReception",
-                   MakeBoundCallback (&DlPhyReceptionCallback, m_phyRxStats));
+  std::vector<Ptr<UeStatsContext> > contexts = GetUeStatsContexts ();
+  for (std::vector<Ptr<UeStatsContext> >::iterator it = contexts.begin (); it != contexts.end (); ++it)
+    {
+      (*it)->GetDevice ()->GetPhy ()->GetDownlinkSpectrumPhy ()->TraceConnectWithoutContext ("DlPhyReception",
+                                                                                             MakeBoundCallback (&DlPhyReceptionCallback, *it));
+    }
 }
 
 void
 LteHelper::EnableUlRxPhyTraces (void)
 {
-  Config::Connect ("/NodeList/*/DeviceList/*/LteEnbPhy/UlSpectrumPhy/UlPhyReception",
-                   MakeBoundCallback (&UlPhyReceptionCallback, m_phyRxStats));
+  std::vector<Ptr<EnbStatsContext> > contexts = GetEnbStatsContexts ();
+  for (std::vector<Ptr<EnbStatsContext> >::iterator it = contexts.begin (); it != contexts.end (); ++it)
+    {
+      (*it)->GetDevice ()->GetPhy ()->GetUplinkSpectrumPhy ()->TraceConnectWithoutContext ("UlPhyReception",
+                                                                                           MakeBoundCallback (&UlPhyReceptionCallback, *it));
+    }
 }
 
 
 
 void
-DlSchedulingCallback (Ptr<MacStatsCalculator> macStats,
-                      std::string path, uint32_t frameNo, uint32_t subframeNo,
+DlSchedulingCallback (Ptr<EnbStatsContext> context,
+                      uint32_t frameNo, uint32_t subframeNo,
                       uint16_t rnti, uint8_t mcsTb1, uint16_t sizeTb1,
                       uint8_t mcsTb2, uint16_t sizeTb2)
 {
-  NS_LOG_FUNCTION (macStats << path);
-  uint64_t imsi = 0;
-  std::ostringstream pathAndRnti;
-  pathAndRnti << path << "/" << rnti;
-  if (macStats->ExistsImsiPath (pathAndRnti.str ()) == true)
-    {
-      imsi = macStats->GetImsiPath (pathAndRnti.str ());
-    }
-  else
-    {
-      imsi = FindImsiFromEnbMac (path, rnti);
-      macStats->SetImsiPath (pathAndRnti.str (), imsi);
-    }
-
-  uint16_t cellId = 0;
-  if (macStats->ExistsCellIdPath (pathAndRnti.str ()) == true)
-    {
-      cellId = macStats->GetCellIdPath (pathAndRnti.str ());
-    }
-  else
-    {
-      cellId = FindCellIdFromEnbMac (path, rnti);
-      macStats->SetCellIdPath (pathAndRnti.str (), cellId);
-    }
-
-  macStats->DlScheduling (cellId, imsi, frameNo, subframeNo, rnti, mcsTb1, sizeTb1, mcsTb2, sizeTb2);
+  NS_LOG_FUNCTION (context->GetCellId () << rnti);
+  context->m_macStats->DlScheduling (context->GetCellId (), context->GetImsi (rnti), frameNo, subframeNo,
+                                     rnti, mcsTb1, sizeTb1, mcsTb2, sizeTb2);
 }
 
 
@@ -1214,121 +1165,82 @@ void
 LteHelper::EnableDlMacTraces (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  Config::Connect ("/NodeList/*/DeviceList/*/LteEnbMac/DlScheduling",
-                   MakeBoundCallback (&DlSchedulingCallback, m_macStats));
+  std::vector<Ptr<EnbStatsContext> > contexts = GetEnbStatsContexts ();
+  for (std::vector<Ptr<EnbStatsContext> >::iterator it = contexts.begin (); it != contexts.end (); ++it)
+    {
+      (*it)->GetDevice ()->GetMac ()->TraceConnectWithoutContext ("DlScheduling",
+                                                                 MakeBoundCallback (&DlSchedulingCallback, *it));
+    }
 }
 
 void
-UlSchedulingCallback (Ptr<MacStatsCalculator> macStats, std::string path,
+UlSchedulingCallback (Ptr<EnbStatsContext> context,
                       uint32_t frameNo, uint32_t subframeNo, uint16_t rnti,
                       uint8_t mcs, uint16_t size)
 {
-  NS_LOG_FUNCTION (macStats << path);
-
-  uint64_t imsi = 0;
-  std::ostringstream pathAndRnti;
-  pathAndRnti << path << "/" << rnti;
-  if (macStats->ExistsImsiPath (pathAndRnti.str ()) == true)
-    {
-      imsi = macStats->GetImsiPath (pathAndRnti.str ());
-    }
-  else
-    {
-      imsi = FindImsiFromEnbMac (path, rnti);
-      macStats->SetImsiPath (pathAndRnti.str (), imsi);
-    }
-  uint16_t cellId = 0;
-  if (macStats->ExistsCellIdPath (pathAndRnti.str ()) == true)
-    {
-      cellId = macStats->GetCellIdPath (pathAndRnti.str ());
-    }
-  else
-    {
-      cellId = FindCellIdFromEnbMac (path, rnti);
-      macStats->SetCellIdPath (pathAndRnti.str (), cellId);
-    }
-
-  macStats->UlScheduling (cellId, imsi, frameNo, subframeNo, rnti, mcs, size);
+  NS_LOG_FUNCTION (context->GetCellId () << rnti);
+  context->m_macStats->UlScheduling (context->GetCellId (), context->GetImsi (rnti), frameNo, subframeNo,
+                                     rnti, mcs, size);
 }
 
 void
 LteHelper::EnableUlMacTraces (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  Config::Connect ("/NodeList/*/DeviceList/*/LteEnbMac/UlScheduling",
-                   MakeBoundCallback (&UlSchedulingCallback, m_macStats));
-}
-
-void
-ReportCurrentCellRsrpSinrCallback (Ptr<PhyStatsCalculator> phyStats,
-                      std::string path, uint16_t cellId, uint16_t rnti,
-                      double rsrp, double sinr)
-{
-  NS_LOG_FUNCTION (phyStats << path);
-  uint64_t imsi = 0;
-  std::string pathUePhy  = path.substr (0, path.find ("/ReportCurrentCellRsrpSinr"));
-  if (phyStats->ExistsImsiPath (pathUePhy) == true)
-    {
-      imsi = phyStats->GetImsiPath (pathUePhy);
-    }
-  else
+  std::vector<Ptr<EnbStatsContext> > contexts = GetEnbStatsContexts ();
+  for (std::vector<Ptr<EnbStatsContext> >::iterator it = contexts.begin (); it != contexts.end (); ++it)
     {
-      imsi = FindImsiFromUePhy (pathUePhy);
-      phyStats->SetImsiPath (pathUePhy, imsi);
+      (*it)->GetDevice ()->GetMac ()->TraceConnectWithoutContext ("UlScheduling",
+                                                                 MakeBoundCallback (&UlSchedulingCallback, *it));
     }
-
-  phyStats->ReportCurrentCellRsrpSinr (cellId, imsi, rnti, rsrp,sinr);
 }
 
 void
-LteHelper::EnableDlPhyTraces (void)
+ReportCurrentCellRsrpSinrCallback (Ptr<UeStatsContext> context,
+                                   uint16_t cellId, uint16_t rnti,
+                                   double rsrp, double sinr)
 {
-  NS_LOG_FUNCTION_NOARGS ();
-  Config::Connect ("/NodeList/*/DeviceList/*/LteUePhy/ReportCurrentCellRsrpSinr",
-                   MakeBoundCallback (&ReportCurrentCellRsrpSinrCallback, m_phyStats));
+  NS_LOG_FUNCTION (context->GetImsi () << cellId << rnti);
+  context->m_phyStats->ReportCurrentCellRsrpSinr (cellId, context->GetImsi (), rnti, rsrp, sinr);
 }
 
 void
-ReportUeSinr (Ptr<PhyStatsCalculator> phyStats, std::string path,
-              uint16_t cellId, uint16_t rnti, double sinrLinear)
+LteHelper::EnableDlPhyTraces (void)
 {
-  NS_LOG_FUNCTION (phyStats << path);
-
-  uint64_t imsi = 0;
-  std::ostringstream pathAndRnti;
-  pathAndRnti << path << "/" << rnti;
-  std::string pathEnbMac  = path.substr (0, path.find ("LteEnbPhy/ReportUeSinr"));
-  pathEnbMac += "LteEnbMac/DlScheduling";
-  if (phyStats->ExistsImsiPath (pathAndRnti.str ()) == true)
-    {
-      imsi = phyStats->GetImsiPath (pathAndRnti.str ());
-    }
-  else
+  NS_LOG_FUNCTION_NOARGS ();
+  std::vector<Ptr<UeStatsContext> > contexts = GetUeStatsContexts ();
+  for (std::vector<Ptr<UeStatsContext> >::iterator it = contexts.begin (); it != contexts.end (); ++it)
     {
-      imsi = FindImsiFromEnbMac (pathEnbMac, rnti);
-      phyStats->SetImsiPath (pathAndRnti.str (), imsi);
+      (*it)->GetDevice ()->GetPhy ()->TraceConnectWithoutContext ("ReportCurrentCellRsrpSinr",
+                                                                 MakeBoundCallback (&ReportCurrentCellRsrpSinrCallback, *it));
     }
+}
 
-  phyStats->ReportUeSinr (cellId, imsi, rnti, sinrLinear);
+void
+ReportUeSinr (Ptr<EnbStatsContext> context, uint16_t cellId, uint16_t rnti, double sinrLinear)
+{
+  NS_LOG_FUNCTION (cellId << rnti);
+  context->m_phyStats->ReportUeSinr (cellId, context->GetImsi (rnti), rnti, sinrLinear);
 }
 
 void
-ReportInterference (Ptr<PhyStatsCalculator> phyStats, std::string path,
-                    uint16_t cellId, Ptr<SpectrumValue> interference)
+ReportInterference (Ptr<EnbStatsContext> context, uint16_t cellId, Ptr<SpectrumValue> interference)
 {
-  NS_LOG_FUNCTION (phyStats << path);
-  phyStats->ReportInterference (cellId, interference);
+  NS_LOG_FUNCTION (cellId);
+  context->m_phyStats->ReportInterference (cellId, interference);
 }
 
 void
 LteHelper::EnableUlPhyTraces (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  Config::Connect ("/NodeList/*/DeviceList/*/LteEnbPhy/ReportUeSinr",
-                   MakeBoundCallback (&ReportUeSinr, m_phyStats));
-  Config::Connect ("/NodeList/*/DeviceList/*/LteEnbPhy/ReportInterference",
-                   MakeBoundCallback (&ReportInterference, m_phyStats));
-
+  std::vector<Ptr<EnbStatsContext> > contexts = GetEnbStatsContexts ();
+  for (std::vector<Ptr<EnbStatsContext> >::iterator it = contexts.begin (); it != contexts.end (); ++it)
+    {
+      Ptr<LteEnbPhy> enbPhy = (*it)->GetDevice ()->GetPhy ();
+      enbPhy->TraceConnectWithoutContext ("ReportUeSinr", MakeBoundCallback (&ReportUeSinr, *it));
+      enbPhy->TraceConnectWithoutContext ("ReportInterference", MakeBoundCallback (&ReportInterference, *it));
+    }
 }
 
 Ptr<RadioBearerStatsCalculator>
@@ -1351,4 +1263,27 @@ LteHelper::GetPdcpStats (void)
   return m_pdcpStats;
 }
 
+void
+LteHelper::EnableHandoverTimelineTraces (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  NS_ASSERT_MSG (m_handoverTimelineTracer == 0, "please make sure that LteHelper::EnableHandoverTimelineTraces is called at most once");
+  m_handoverTimelineTracer = CreateObject<HandoverTimelineTracer> ();
+  Config::Connect ("/NodeList/*/DeviceList/*/LteEnbRrc/HandoverPhase",
+                   MakeBoundCallback (&HandoverTimelineTracer::HandoverPhaseCallback, m_handoverTimelineTracer));
+  Config::Connect ("/NodeList/*/DeviceList/*/LteUeRrc/HandoverStart",
+                   MakeBoundCallback (&HandoverTimelineTracer::UeHandoverStartCallback, m_handoverTimelineTracer));
+  Config::Connect ("/NodeList/*/DeviceList/*/LteUeRrc/RandomAccessSuccessful",
+                   MakeBoundCallback (&HandoverTimelineTracer::UeRandomAccessCallback, m_handoverTimelineTracer));
+  Config::Connect ("/NodeList/*/$ns3::EpcX2/IcnMessageReceived",
+                   MakeBoundCallback (&HandoverTimelineTracer::IcnMessageCallback, m_handoverTimelineTracer));
+  Simulator::ScheduleDestroy (&HandoverTimelineTracer::Flush, m_handoverTimelineTracer);
+}
+
+Ptr<HandoverTimelineTracer>
+LteHelper::GetHandoverTimelineTracer (void)
+{
+  return m_handoverTimelineTracer;
+}
+
 } // namespace ns3
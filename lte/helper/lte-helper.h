@@ -35,8 +35,13 @@
 #include <ns3/mac-stats-calculator.h>
 #include <ns3/radio-bearer-stats-calculator.h>
 #include <ns3/radio-bearer-stats-connector.h>
+#include <ns3/handover-timeline-tracer.h>
+#include <ns3/lte-stats-context.h>
 #include <ns3/epc-tft.h>
 #include <ns3/mobility-model.h>
+#include <ns3/traced-callback.h>
+#include <map>
+#include <set>
 
 namespace ns3 {
 
@@ -255,6 +260,22 @@ public:
    */
   void HandoverRequest (Time hoTime, Ptr<NetDevice> ueDev, Ptr<NetDevice> sourceEnbDev, Ptr<NetDevice> targetEnbDev);
 
+  /**
+   * Trigger the X2-based handover of a group of UEs moving together between
+   * two eNBs, e.g. the passengers of a train. If GroupHandoverAggregation is
+   * true, the X2 messages of the group and the notification of the
+   * controller are aggregated, while the path switch requests stay one per
+   * UE; otherwise each UE is handed over on its own, at the same time. In
+   * both cases GroupHandoverCompleted fires once the last UE of the group is
+   * connected to the target eNB.
+   *
+   * \param hoTime when the Handover is initiated
+   * \param ueDevices the UEs that hand off
+   * \param sourceEnbDev source eNB, originally the UEs are attached to this eNB
+   * \param targetEnbDev target eNB, the UEs are finally connected to this eNB
+   */
+  void GroupHandoverRequest (Time hoTime, NetDeviceContainer ueDevices, Ptr<NetDevice> sourceEnbDev, Ptr<NetDevice> targetEnbDev);
+
 
   /** 
    * Call ActivateDataRadioBearer (ueDevice, bearer) for each UE
@@ -375,6 +396,19 @@ public:
    */
   Ptr<RadioBearerStatsCalculator> GetPdcpStats (void);
 
+  /**
+   * Enable the handover timeline tracer, which records the phases of
+   * every X2-based handover per IMSI. The file is written when the
+   * simulation is destroyed.
+   */
+  void EnableHandoverTimelineTraces (void);
+
+  /**
+   *
+   * \return the handover timeline tracer
+   */
+  Ptr<HandoverTimelineTracer> GetHandoverTimelineTracer (void);
+
   enum LteEpsBearerToRlcMapping_t {RLC_SM_ALWAYS = 1,
                                    RLC_UM_ALWAYS = 2,
                                    RLC_AM_ALWAYS = 3,
@@ -403,6 +437,21 @@ private:
 
   void DoHandoverRequest (Ptr<NetDevice> ueDev, Ptr<NetDevice> sourceEnbDev, Ptr<NetDevice> targetEnbDev);
 
+  void DoGroupHandoverRequest (uint32_t groupId, NetDeviceContainer ueDevices, Ptr<NetDevice> sourceEnbDev, Ptr<NetDevice> targetEnbDev);
+
+  /**
+   * HandoverEndOk sink of the target eNBs of the group handovers, connected
+   * once per eNB, the group of the UE being found from its IMSI
+   */
+  void GroupHandoverEndOk (uint64_t imsi, uint16_t cellId, uint16_t rnti);
+
+  /**
+   * \return the stats context of every LTE eNB (UE) device installed so far,
+   * created the first time a device is seen, to be bound to its trace sinks
+   */
+  std::vector<Ptr<EnbStatsContext> > GetEnbStatsContexts (void);
+  std::vector<Ptr<UeStatsContext> > GetUeStatsContexts (void);
+
   Ptr<SpectrumChannel> m_downlinkChannel;
   Ptr<SpectrumChannel> m_uplinkChannel;
 
@@ -430,6 +479,9 @@ private:
   Ptr<RadioBearerStatsCalculator> m_rlcStats;
   Ptr<RadioBearerStatsCalculator> m_pdcpStats;
   RadioBearerStatsConnector m_radioBearerStatsConnector;
+  Ptr<HandoverTimelineTracer> m_handoverTimelineTracer;
+  std::map<Ptr<NetDevice>, Ptr<EnbStatsContext> > m_enbStatsContexts;
+  std::map<Ptr<NetDevice>, Ptr<UeStatsContext> > m_ueStatsContexts;
 
   Ptr<EpcHelper> m_epcHelper;
 
@@ -437,6 +489,23 @@ private:
   uint16_t m_cellIdCounter;
 
   bool m_useIdealRrc;
+
+  struct GroupHandoverInfo
+  {
+    Time m_startTime;
+    uint32_t m_size;
+    uint16_t m_targetCellId;
+    uint32_t m_pending; ///< number of UEs still handing over
+  };
+
+  std::map<uint32_t, GroupHandoverInfo> m_groupHandovers;
+  std::map<uint64_t, uint32_t> m_groupHandoverImsis; ///< group of each UE handing over
+  std::set<uint16_t> m_groupHandoverTargets; ///< cells whose HandoverEndOk is connected
+  uint32_t m_groupHandoverCounter;
+  bool m_groupHandoverAggregation;
+
+  //             group id  UEs       completion time
+  TracedCallback<uint32_t, uint32_t, Time> m_groupHandoverTrace;
 };
 
 
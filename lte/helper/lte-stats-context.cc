@@ -0,0 +1,129 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "lte-stats-context.h"
+#include <ns3/log.h>
+#include <ns3/callback.h>
+#include <ns3/lte-enb-net-device.h>
+#include <ns3/lte-ue-net-device.h>
+#include <ns3/lte-enb-rrc.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LteStatsContext");
+
+EnbStatsContext::EnbStatsContext (Ptr<LteEnbNetDevice> enbDevice)
+  : m_device (PeekPointer (enbDevice)),
+    m_cellId (enbDevice->GetCellId ())
+{
+  NS_LOG_FUNCTION (this << m_cellId);
+}
+
+Ptr<LteEnbNetDevice>
+EnbStatsContext::GetDevice (void) const
+{
+  return m_device;
+}
+
+uint16_t
+EnbStatsContext::GetCellId (void) const
+{
+  return m_cellId;
+}
+
+uint64_t
+EnbStatsContext::GetImsi (uint16_t rnti)
+{
+  if (rnti < m_imsis.size () && m_imsis[rnti] != 0)
+    {
+      return m_imsis[rnti];
+    }
+
+  Ptr<LteEnbRrc> rrc = m_device->GetRrc ();
+  if (!rrc->HasUeManager (rnti))
+    {
+      NS_LOG_LOGIC ("cell " << m_cellId << " has no context for RNTI " << rnti);
+      return 0;
+    }
+  uint64_t imsi = rrc->GetUeManager (rnti)->GetImsi ();
+  if (imsi != 0)
+    {
+      if (rnti >= m_imsis.size ())
+        {
+          m_imsis.resize (rnti + 1, 0);
+        }
+      m_imsis[rnti] = imsi;
+    }
+  NS_LOG_LOGIC ("cell " << m_cellId << ", RNTI " << rnti << ": IMSI " << imsi);
+  return imsi;
+}
+
+void
+EnbStatsContext::ConnectRrcTraces (void)
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<LteEnbRrc> rrc = m_device->GetRrc ();
+  rrc->TraceConnectWithoutContext ("NewUeContext",
+                                   MakeBoundCallback (&EnbStatsContext::NewUeContextCallback, Ptr<EnbStatsContext> (this)));
+  rrc->TraceConnectWithoutContext ("ConnectionEstablished",
+                                   MakeBoundCallback (&EnbStatsContext::ConnectionCallback, Ptr<EnbStatsContext> (this)));
+  rrc->TraceConnectWithoutContext ("HandoverEndOk",
+                                   MakeBoundCallback (&EnbStatsContext::ConnectionCallback, Ptr<EnbStatsContext> (this)));
+}
+
+void
+EnbStatsContext::NewUeContextCallback (Ptr<EnbStatsContext> context, uint16_t cellId, uint16_t rnti)
+{
+  NS_LOG_FUNCTION (context << cellId << rnti);
+  // the RNTI may have belonged to another UE
+  if (rnti < context->m_imsis.size ())
+    {
+      context->m_imsis[rnti] = 0;
+    }
+}
+
+void
+EnbStatsContext::ConnectionCallback (Ptr<EnbStatsContext> context, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+{
+  NS_LOG_FUNCTION (context << imsi << cellId << rnti);
+  if (rnti >= context->m_imsis.size ())
+    {
+      context->m_imsis.resize (rnti + 1, 0);
+    }
+  context->m_imsis[rnti] = imsi;
+}
+
+
+UeStatsContext::UeStatsContext (Ptr<LteUeNetDevice> ueDevice)
+  : m_device (PeekPointer (ueDevice)),
+    m_imsi (ueDevice->GetImsi ())
+{
+  NS_LOG_FUNCTION (this << m_imsi);
+}
+
+Ptr<LteUeNetDevice>
+UeStatsContext::GetDevice (void) const
+{
+  return m_device;
+}
+
+uint64_t
+UeStatsContext::GetImsi (void) const
+{
+  return m_imsi;
+}
+
+} // namespace ns3
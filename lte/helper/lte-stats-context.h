@@ -0,0 +1,108 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LTE_STATS_CONTEXT_H
+#define LTE_STATS_CONTEXT_H
+
+#include <ns3/simple-ref-count.h>
+#include <ns3/ptr.h>
+#include <ns3/phy-stats-calculator.h>
+#include <ns3/phy-tx-stats-calculator.h>
+#include <ns3/phy-rx-stats-calculator.h>
+#include <ns3/mac-stats-calculator.h>
+#include <vector>
+
+namespace ns3 {
+
+class LteEnbNetDevice;
+class LteUeNetDevice;
+
+/**
+ * \ingroup lte
+ *
+ * Context bound to the PHY and MAC trace sinks of an eNB when they are
+ * connected: the cell id, the stats calculators, and the IMSI of each RNTI
+ * of the cell. An IMSI is taken from the RRC the first time the RNTI is
+ * traced, then kept up to date by the RRC traces, so that no path needs to
+ * be built or looked up per traced event.
+ *
+ * The trace sinks of the device hold the context, so the context does not
+ * hold the device: it is only valid as long as the device is.
+ */
+class EnbStatsContext : public SimpleRefCount<EnbStatsContext>
+{
+public:
+  EnbStatsContext (Ptr<LteEnbNetDevice> enbDevice);
+
+  Ptr<LteEnbNetDevice> GetDevice (void) const;
+  uint16_t GetCellId (void) const;
+
+  /**
+   * \param rnti the RNTI of a UE of the cell
+   * \return the IMSI of the UE, 0 if the eNB does not know it (yet)
+   */
+  uint64_t GetImsi (uint16_t rnti);
+
+  /**
+   * Connect the RRC trace sources keeping the IMSI cache up to date
+   */
+  void ConnectRrcTraces (void);
+
+  // RRC trace sinks, to be connected with MakeBoundCallback
+  static void NewUeContextCallback (Ptr<EnbStatsContext> context, uint16_t cellId, uint16_t rnti);
+  static void ConnectionCallback (Ptr<EnbStatsContext> context, uint64_t imsi, uint16_t cellId, uint16_t rnti);
+
+  Ptr<PhyStatsCalculator> m_phyStats;
+  Ptr<PhyTxStatsCalculator> m_phyTxStats;
+  Ptr<PhyRxStatsCalculator> m_phyRxStats;
+  Ptr<MacStatsCalculator> m_macStats;
+
+private:
+  LteEnbNetDevice *m_device;
+  uint16_t m_cellId;
+
+  /**
+   * IMSI of each RNTI, indexed by RNTI, 0 if not known
+   */
+  std::vector<uint64_t> m_imsis;
+};
+
+/**
+ * \ingroup lte
+ *
+ * Context bound to the PHY trace sinks of a UE when they are connected,
+ * valid as long as the device is
+ */
+class UeStatsContext : public SimpleRefCount<UeStatsContext>
+{
+public:
+  UeStatsContext (Ptr<LteUeNetDevice> ueDevice);
+
+  Ptr<LteUeNetDevice> GetDevice (void) const;
+  uint64_t GetImsi (void) const;
+
+  Ptr<PhyStatsCalculator> m_phyStats;
+  Ptr<PhyTxStatsCalculator> m_phyTxStats;
+  Ptr<PhyRxStatsCalculator> m_phyRxStats;
+
+private:
+  LteUeNetDevice *m_device;
+  uint64_t m_imsi;
+};
+
+} // namespace ns3
+
+#endif // LTE_STATS_CONTEXT_H
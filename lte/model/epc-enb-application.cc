@@ -29,6 +29,10 @@
 #include "ns3/ndn-interest.h" // edit
 #include "ns3/ndn-content-object.h" // edit
 #include "ns3/udp-header.h" // edit
+#include "ns3/boolean.h" // new
+#include "ns3/trace-source-accessor.h" // new
+#include <stdlib.h> // new
+#include <algorithm> // new
 
 #include "epc-gtpu-header.h"
 #include "eps-bearer-tag.h"
@@ -66,7 +70,41 @@ TypeId
 EpcEnbApplication::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::EpcEnbApplication")
-    .SetParent<Object> ();
+    .SetParent<Object> ()
+    .AddAttribute ("CsMigration",
+                   "If true, the CS entries of a UE are migrated to the target eNB "
+                   "when its handover is prepared",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&EpcEnbApplication::m_csMigration),
+                   MakeBooleanChecker ())
+    .AddAttribute ("CsMigrationHistory",
+                   "The number of names recently requested by a UE which are kept "
+                   "and migrated to the target eNB",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&EpcEnbApplication::m_csMigrationHistory),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("CsMigrationWindow",
+                   "The number of names following the last one requested by a UE "
+                   "which are prefetched for the target eNB",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&EpcEnbApplication::m_csMigrationWindow),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("PitTransfer",
+                   "If true, the PIT entries of a UE are transferred to the target eNB "
+                   "with its handover request, so that the target requests the pending "
+                   "content before the UE arrives",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&EpcEnbApplication::m_pitTransfer),
+                   MakeBooleanChecker ())
+    .AddTraceSource ("PathSwitchRequest",
+                     "An S1-AP path switch request sent to the MME, one per UE, "
+                     "with the RNTI of the UE it switches",
+                     MakeTraceSourceAccessor (&EpcEnbApplication::m_pathSwitchTrace))
+    .AddTraceSource ("PitTransfer",
+                     "PIT entries of an incoming UE received from the source eNB, with "
+                     "the number of names and how many of them were cached or pending here",
+                     MakeTraceSourceAccessor (&EpcEnbApplication::m_pitTransferTrace))
+    ;
   return tid;
 }
 
@@ -89,7 +127,11 @@ EpcEnbApplication::EpcEnbApplication (Ptr<Socket> lteSocket, Ptr<Socket> s1uSock
     m_gtpuUdpPort (2152), // fixed by the standard
     m_s1SapUser (0),
     m_s1apSapMme (0),
-    m_cellId (cellId)
+    m_cellId (cellId),
+    m_csMigration (false), // new
+    m_csMigrationHistory (8), // new
+    m_csMigrationWindow (8), // new
+    m_pitTransfer (false) // new
 {
   NS_LOG_FUNCTION (this << lteSocket << s1uSocket << sgwS1uAddress);
   m_s1uSocket->SetRecvCallback (MakeCallback (&EpcEnbApplication::RecvFromS1uSocket, this));
@@ -102,6 +144,25 @@ EpcEnbApplication::Buff_t::Buff_t()  // new
 {
 }
 
+EpcEnbApplication::UeNameHistory_t::UeNameHistory_t()  // new
+  : m_bid (0),
+    m_csMigrationCellId (0)
+{
+}
+
+EpcEnbApplication::PitTransfer_t::PitTransfer_t()  // new
+  : m_bid (0)
+{
+}
+
+EpcEnbApplication::UeBearers_t::UeBearers_t ()
+{
+  for (uint8_t bid = 0; bid < 16; ++bid)
+    {
+      m_teid[bid] = 0;
+    }
+}
+
 EpcEnbApplication::~EpcEnbApplication (void)
 {
   NS_LOG_FUNCTION (this);
@@ -161,11 +222,214 @@ void EpcEnbApplication::SetNameContentMap (CsEps_t cs, ns3::ndn::Name name)  //
 void EpcEnbApplication::SetNameFaceMap (EnbPitFace_t pitFace, ns3::ndn::Name name) // new
 {
     m_nameFaceMap[name].push_back(pitFace);
+    IndexPitFace (name, pitFace);
 }
 
 void EpcEnbApplication::ErasePitEntry (ns3::ndn::Name name) // new
 {
-    m_nameFaceMap.erase (name);
+    std::map<ns3::ndn::Name, std::vector<EnbPitFace_t> >::iterator interestNameIt = m_nameFaceMap.find (name);
+    if (interestNameIt != m_nameFaceMap.end ())
+    {
+        UnindexPitEntry (name, interestNameIt->second);
+        m_nameFaceMap.erase (interestNameIt);
+    }
+}
+
+void
+EpcEnbApplication::SetCsMigrationCallback (CsMigrationCallback cb) // new
+{
+  m_csMigrationCallback = cb;
+}
+
+std::vector<ns3::ndn::Name>
+EpcEnbApplication::GetCsMigrationNames (uint16_t rnti) // new
+{
+  std::vector<ns3::ndn::Name> names;
+  UeNameHistory_t *history = m_ueNameHistoryMap.Find (rnti);
+  if (history == 0 || history->m_names.empty ())
+    {
+      return names;
+    }
+  names.assign (history->m_names.begin (), history->m_names.end ());
+
+  // names are of the form /<prefix>/<seq>: predict the next sequence numbers
+  std::list<std::string> components = history->m_names.back ().GetComponents ();
+  if (components.empty ())
+    {
+      return names;
+    }
+  const std::string &last = components.back ();
+  char *end = 0;
+  unsigned long seq = strtoul (last.c_str (), &end, 10);
+  if (last.empty () || *end != '\0')
+    {
+      NS_LOG_LOGIC ("last component " << last << " is not a sequence number, no prediction");
+      return names;
+    }
+  components.pop_back ();
+
+  for (uint32_t i = 1; i <= m_csMigrationWindow; i++)
+    {
+      ns3::ndn::Name predicted;
+      for (std::list<std::string>::iterator it = components.begin (); it != components.end (); ++it)
+        {
+          predicted (*it);
+        }
+      predicted (seq + i);
+      if (std::find (names.begin (), names.end (), predicted) == names.end ())
+        {
+          names.push_back (predicted);
+        }
+    }
+  return names;
+}
+
+void
+EpcEnbApplication::PrepareCsMigration (uint16_t rnti, uint16_t targetCellId) // new
+{
+  NS_LOG_FUNCTION (this << rnti << targetCellId);
+  if (!m_csMigration || m_csMigrationCallback.IsNull ())
+    {
+      return;
+    }
+
+  UeNameHistory_t *history = m_ueNameHistoryMap.Find (rnti);
+  if (history == 0)
+    {
+      NS_LOG_LOGIC ("no request history for RNTI " << rnti);
+      return;
+    }
+  std::vector<ns3::ndn::Name> names = GetCsMigrationNames (rnti);
+  // the names of a former attempt are no longer awaited by its target
+  CancelCsMigration (rnti);
+  history->m_csMigrationCellId = targetCellId;
+
+  uint32_t sent = 0;
+  uint32_t requested = 0;
+  for (std::vector<ns3::ndn::Name>::iterator nameIt = names.begin (); nameIt != names.end (); ++nameIt)
+    {
+      std::map<ns3::ndn::Name, CsEps_t>::iterator contentNameIt = m_nameContentMap.find (*nameIt);
+      if (contentNameIt != m_nameContentMap.end ())
+        {
+          m_csMigrationCallback (targetCellId, contentNameIt->second);
+          ++sent;
+          continue;
+        }
+
+      m_csMigrationPendingMap[*nameIt].push_back (targetCellId);
+      history->m_csMigrationPending.push_back (*nameIt);
+
+      if (m_nameFaceMap.find (*nameIt) != m_nameFaceMap.end ())
+        {
+          // already requested, forwarded when the content arrives
+          continue;
+        }
+
+      UeBearers_t *bearers = m_rbidTeidMap.Find (rnti);
+      if (bearers == 0 || bearers->m_teid[history->m_bid] == 0)
+        {
+          continue;
+        }
+
+      // PIT entry without faces: the content is only cached and forwarded
+      m_nameFaceMap[*nameIt];
+
+      ns3::ndn::Interest interestHeader;
+      interestHeader.SetName (Create<ns3::ndn::Name> (*nameIt));
+      Ptr<Packet> packet = Create<Packet> ();
+      packet->AddHeader (interestHeader);
+      packet->AddHeader (history->m_udpHeader);
+      Ipv4Header ipv4Header = history->m_ipHeader;
+      ipv4Header.SetPayloadSize (packet->GetSize ());
+      packet->AddHeader (ipv4Header);
+      SendToS1uSocket (packet, bearers->m_teid[history->m_bid]);
+      ++requested;
+    }
+  NS_LOG_INFO ("CS migration of RNTI " << rnti << " to cell " << targetCellId << ": "
+               << sent << " entries sent, " << requested << " names requested");
+}
+
+void
+EpcEnbApplication::CancelCsMigration (uint16_t rnti) // new
+{
+  NS_LOG_FUNCTION (this << rnti);
+  UeNameHistory_t *history = m_ueNameHistoryMap.Find (rnti);
+  if (history == 0 || history->m_csMigrationPending.empty ())
+    {
+      return;
+    }
+  uint16_t targetCellId = history->m_csMigrationCellId;
+  for (std::vector<ns3::ndn::Name>::iterator nameIt = history->m_csMigrationPending.begin ();
+       nameIt != history->m_csMigrationPending.end (); ++nameIt)
+    {
+      std::map<ns3::ndn::Name, std::vector<uint16_t> >::iterator pendingIt = m_csMigrationPendingMap.find (*nameIt);
+      if (pendingIt == m_csMigrationPendingMap.end ())
+        {
+          // already arrived and forwarded
+          continue;
+        }
+      std::vector<uint16_t>::iterator cellIt = std::find (pendingIt->second.begin (), pendingIt->second.end (), targetCellId);
+      if (cellIt != pendingIt->second.end ())
+        {
+          pendingIt->second.erase (cellIt);
+        }
+      if (pendingIt->second.empty ())
+        {
+          m_csMigrationPendingMap.erase (pendingIt);
+          // a PIT entry without faces was only opened for the target
+          std::map<ns3::ndn::Name, std::vector<EnbPitFace_t> >::iterator interestNameIt = m_nameFaceMap.find (*nameIt);
+          if (interestNameIt != m_nameFaceMap.end () && interestNameIt->second.empty ())
+            {
+              m_nameFaceMap.erase (interestNameIt);
+            }
+        }
+    }
+  NS_LOG_INFO ("CS migration of RNTI " << rnti << " to cell " << targetCellId << " cancelled, "
+               << history->m_csMigrationPending.size () << " names dropped");
+  history->m_csMigrationPending.clear ();
+}
+
+void
+EpcEnbApplication::RecvMigratedContent (CsEps_t cs) // new
+{
+  NS_LOG_FUNCTION (this);
+  ns3::ndn::Name name = cs.m_contentHeader->GetName ();
+  if (m_nameContentMap.find (name) != m_nameContentMap.end ())
+    {
+      NS_LOG_LOGIC ("migrated content " << name << " is already cached");
+      return;
+    }
+  NS_LOG_INFO ("Caching migrated content " << name);
+  m_nameContentMap[name] = cs;
+
+  std::map<ns3::ndn::Name, std::vector<EnbPitFace_t> >::iterator interestNameIt = m_nameFaceMap.find (name);
+  if (interestNameIt != m_nameFaceMap.end ())
+    {
+      Ptr<Packet> packet = cs.m_content->Copy ();
+      packet->AddHeader (*(cs.m_contentHeader));
+      SendToPitFaces (packet, cs.m_ipHeader, cs.m_udpHeader, interestNameIt->second);
+      UnindexPitEntry (name, interestNameIt->second);
+      m_nameFaceMap.erase (interestNameIt);
+    }
+}
+
+bool
+EpcEnbApplication::HasContent (ns3::ndn::Name name) const // new
+{
+  return m_nameContentMap.find (name) != m_nameContentMap.end ();
+}
+
+void
+EpcEnbApplication::SetVmChunkCallback (VmChunkCallback cb) // new
+{
+  m_vmChunkCallback = cb;
+}
+
+void
+EpcEnbApplication::SendVmChunkToGateway (uint32_t teid, Ptr<Packet> packet) // new
+{
+  NS_LOG_FUNCTION (this << teid << packet);
+  SendToS1uSocket (packet, teid);
 }
 
 void
@@ -191,8 +455,9 @@ EpcEnbApplication::DoPathSwitchRequest (EpcEnbS1SapProvider::PathSwitchRequestPa
 
       EpsFlowId_t rbid (params.rnti, bit->epsBearerId);
       // side effect: create entries if not exist
-      m_rbidTeidMap[params.rnti][bit->epsBearerId] = teid;
-      m_teidRbidMap[teid] = rbid;
+      NS_ASSERT (bit->epsBearerId < 16);
+      m_rbidTeidMap.Get (params.rnti).m_teid[bit->epsBearerId] = teid;
+      m_teidRbidMap.Set (teid, rbid);
 
       EpcS1apSapMme::ErabSwitchedInDownlinkItem erab;
       erab.erabId = bit->epsBearerId;
@@ -202,24 +467,174 @@ EpcEnbApplication::DoPathSwitchRequest (EpcEnbS1SapProvider::PathSwitchRequestPa
       erabToBeSwitchedInDownlinkList.push_back (erab);
     }
   m_s1apSapMme->PathSwitchRequest (enbUeS1Id, mmeUeS1Id, gci, erabToBeSwitchedInDownlinkList);
+  m_pathSwitchTrace (params.rnti); // new
+  ActivatePitTransfer (params.rnti); // new
+}
+
+Ptr<Packet>
+EpcEnbApplication::GetPitTransfer (uint16_t rnti) // new
+{
+  NS_LOG_FUNCTION (this << rnti);
+  UeNameHistory_t *history = m_ueNameHistoryMap.Find (rnti);
+  if (!m_pitTransfer || history == 0 || history->m_names.empty ())
+    {
+      // no Interest of the UE seen here, no headers to send the names with
+      return 0;
+    }
+
+  uint32_t generation = m_rbidTeidMap.GetGeneration (rnti);
+  Ptr<Packet> names = Create<Packet> ();
+  uint16_t count = 0;
+  std::set<ns3::ndn::Name>::iterator nameIt = history->m_pitNames.begin ();
+  while (nameIt != history->m_pitNames.end () && count < 0xffff)
+    {
+      // the index is checked against the PIT, whose entries the UE may have
+      // left without the index being told
+      bool pending = false;
+      std::map<ns3::ndn::Name, std::vector<EnbPitFace_t> >::iterator interestNameIt = m_nameFaceMap.find (*nameIt);
+      if (interestNameIt != m_nameFaceMap.end ())
+        {
+          std::vector<EnbPitFace_t> &pitFaces = interestNameIt->second;
+          for (uint32_t i = 0; i < pitFaces.size () && !pending; i++)
+            {
+              pending = pitFaces[i].m_rnti == rnti
+                && (pitFaces[i].m_generation == 0 || pitFaces[i].m_generation == generation);
+            }
+        }
+      if (!pending)
+        {
+          history->m_pitNames.erase (nameIt++);
+          continue;
+        }
+      ns3::ndn::Interest interestHeader;
+      interestHeader.SetName (Create<ns3::ndn::Name> (*nameIt));
+      Ptr<Packet> interest = Create<Packet> ();
+      interest->AddHeader (interestHeader);
+      names->AddAtEnd (interest);
+      ++count;
+      ++nameIt;
+    }
+  if (count == 0)
+    {
+      return 0;
+    }
+  NS_LOG_INFO ("Transferring " << count << " PIT entries of RNTI " << rnti);
+
+  // bearer and number of names, followed by the names
+  uint8_t buf[3];
+  buf[0] = history->m_bid;
+  buf[1] = count >> 8;
+  buf[2] = count & 0xff;
+  Ptr<Packet> packet = Create<Packet> (buf, 3);
+  packet->AddAtEnd (names);
+  packet->AddHeader (history->m_udpHeader);
+  packet->AddHeader (history->m_ipHeader);
+  return packet;
+}
+
+void
+EpcEnbApplication::RecvPitTransfer (uint16_t rnti, Ptr<Packet> packet) // new
+{
+  NS_LOG_FUNCTION (this << rnti);
+
+  // a transfer left by a handover of the same RNTI which did not complete
+  m_pitTransferMap.Erase (rnti);
+  PitTransfer_t &transfer = m_pitTransferMap.Get (rnti);
+  packet->RemoveHeader (transfer.m_ipHeader);
+  packet->RemoveHeader (transfer.m_udpHeader);
+  uint8_t buf[3];
+  packet->CopyData (buf, 3);
+  packet->RemoveAtStart (3);
+  transfer.m_bid = buf[0];
+  uint16_t count = ((uint16_t) buf[1] << 8) | buf[2];
+
+  uint32_t local = 0;
+  for (uint16_t n = 0; n < count; n++)
+    {
+      ns3::ndn::Interest interestHeader;
+      packet->RemoveHeader (interestHeader);
+      ns3::ndn::Name name = interestHeader.GetName ();
+      transfer.m_names.push_back (name);
+
+      if (m_nameContentMap.find (name) != m_nameContentMap.end ()
+          || m_nameFaceMap.find (name) != m_nameFaceMap.end ())
+        {
+          ++local;
+          continue;
+        }
+
+      // PIT entry without faces until the UE arrives: the content is cached
+      m_nameFaceMap[name];
+
+      Ptr<Packet> interest = Create<Packet> ();
+      interest->AddHeader (interestHeader);
+      interest->AddHeader (transfer.m_udpHeader);
+      Ipv4Header ipv4Header = transfer.m_ipHeader;
+      ipv4Header.SetPayloadSize (interest->GetSize ());
+      interest->AddHeader (ipv4Header);
+      SendToS1uSocket (interest, PIT_TRANSFER_INTEREST_TEID);
+    }
+  NS_LOG_INFO ("PIT transfer for RNTI " << rnti << ": " << count << " names, "
+               << local << " already cached or pending");
+  m_pitTransferTrace (rnti, count, local);
+}
+
+void
+EpcEnbApplication::ActivatePitTransfer (uint16_t rnti) // new
+{
+  PitTransfer_t *transfer = m_pitTransferMap.Find (rnti);
+  if (transfer == 0)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this << rnti << transfer->m_names.size ());
+
+  EnbPitFace_t pitFace (rnti, transfer->m_bid, transfer->m_udpHeader.GetSourcePort (), transfer->m_ipHeader.GetSource ());
+  pitFace.m_generation = m_rbidTeidMap.GetGeneration (rnti);
+  std::vector<EnbPitFace_t> pitFaces (1, pitFace);
+
+  for (std::vector<ns3::ndn::Name>::iterator nameIt = transfer->m_names.begin ();
+       nameIt != transfer->m_names.end (); ++nameIt)
+    {
+      std::map<ns3::ndn::Name, CsEps_t>::iterator contentNameIt = m_nameContentMap.find (*nameIt);
+      if (contentNameIt != m_nameContentMap.end ())
+        {
+          NS_LOG_INFO ("Transferred PIT entry " << *nameIt << " satisfied from CS");
+          CsEps_t cs = contentNameIt->second;
+          Ptr<Packet> packet = cs.m_content->Copy ();
+          packet->AddHeader (*(cs.m_contentHeader));
+          SendToPitFaces (packet, cs.m_ipHeader, cs.m_udpHeader, pitFaces);
+          continue;
+        }
+      std::map<ns3::ndn::Name, std::vector<EnbPitFace_t> >::iterator interestNameIt = m_nameFaceMap.find (*nameIt);
+      if (interestNameIt != m_nameFaceMap.end ())
+        {
+          interestNameIt->second.push_back (pitFace);
+          IndexPitFace (*nameIt, pitFace);
+        }
+    }
+  m_pitTransferMap.Erase (rnti);
 }
 
 void
 EpcEnbApplication::DoUeContextRelease (uint16_t rnti)
 {
   NS_LOG_FUNCTION (this << rnti);
-  std::map<uint16_t, std::map<uint8_t, uint32_t> >::iterator rntiIt = m_rbidTeidMap.find (rnti);
-  if (rntiIt != m_rbidTeidMap.end ())
+  UeBearers_t *bearers = m_rbidTeidMap.Find (rnti);
+  if (bearers != 0)
     {
-      for (std::map<uint8_t, uint32_t>::iterator bidIt = rntiIt->second.begin ();
-           bidIt != rntiIt->second.end ();
-           ++bidIt)
+      for (uint8_t bid = 0; bid < 16; ++bid)
         {
-          uint32_t teid = bidIt->second;
-          m_teidRbidMap.erase (teid);
+          if (bearers->m_teid[bid] != 0)
+            {
+              m_teidRbidMap.Erase (bearers->m_teid[bid]);
+            }
         }
-      m_rbidTeidMap.erase (rntiIt);
+      m_rbidTeidMap.Erase (rnti);
     }
+  m_ueNameHistoryMap.Erase (rnti); // new
+  m_buffMap.Erase (rnti); // new
+  m_pitTransferMap.Erase (rnti); // new
 }
 
 void
@@ -247,8 +662,9 @@ EpcEnbApplication::DoInitialContextSetupRequest (uint64_t mmeUeS1Id, uint16_t en
 
       EpsFlowId_t rbid (rnti, erabIt->erabId);
       // side effect: create entries if not exist
-      m_rbidTeidMap[rnti][erabIt->erabId] = params.gtpTeid;
-      m_teidRbidMap[params.gtpTeid] = rbid;
+      NS_ASSERT (erabIt->erabId < 16);
+      m_rbidTeidMap.Get (rnti).m_teid[erabIt->erabId] = params.gtpTeid;
+      m_teidRbidMap.Set (params.gtpTeid, rbid);
 
     }
 }
@@ -285,8 +701,8 @@ EpcEnbApplication::RecvFromLteSocket (Ptr<Socket> socket)
   uint8_t bid = tag.GetBid ();
   NS_LOG_LOGIC ("received packet with RNTI=" << (uint32_t) rnti << ", BID=" << (uint32_t)  bid);
 
-  std::map<uint16_t, std::map<uint8_t, uint32_t> >::iterator rntiIt = m_rbidTeidMap.find (rnti);
-  if (rntiIt == m_rbidTeidMap.end ())
+  UeBearers_t *bearers = m_rbidTeidMap.Find (rnti);
+  if (bearers == 0)
     {
       NS_LOG_WARN ("UE context not found, discarding packet");
       //SendToLteSocket (packet, rnti, bid);
@@ -310,6 +726,19 @@ EpcEnbApplication::RecvFromLteSocket (Ptr<Socket> socket)
       ns3::ndn::Interest interestHeader;
       pCopy->RemoveHeader(interestHeader);
 
+      if (m_csMigration || m_pitTransfer) // new
+      {
+        UeNameHistory_t &history = m_ueNameHistoryMap.Get (rnti);
+        history.m_names.push_back (interestHeader.GetName());
+        while (history.m_names.size () > m_csMigrationHistory)
+        {
+          history.m_names.pop_front ();
+        }
+        history.m_ipHeader  = ipv4Header;
+        history.m_udpHeader = udpHeader;
+        history.m_bid       = bid;
+      }
+
       // checking CS
       std::map<ns3::ndn::Name, CsEps_t>::iterator contentNameIt = m_nameContentMap.find (interestHeader.GetName());
 
@@ -324,16 +753,17 @@ EpcEnbApplication::RecvFromLteSocket (Ptr<Socket> socket)
         = m_nameFaceMap.find (interestHeader.GetName());
 
         EnbPitFace_t pitFace (rnti, bid, udpHeader.GetSourcePort(), ipv4Header.GetSource());
+        pitFace.m_generation = m_rbidTeidMap.GetGeneration (rnti);
 
         if (interestNameIt == m_nameFaceMap.end ())  // no match is found in PIT
         {
           NS_LOG_INFO ("No match is found in PIT. Adding a new PIT entry and sending the Interest to SGW/PGW");
           // inserting new entry to the PIT map
           m_nameFaceMap[interestHeader.GetName()].push_back(pitFace);
+          IndexPitFace (interestHeader.GetName(), pitFace);
 
-          std::map<uint8_t, uint32_t>::iterator bidIt = rntiIt->second.find (bid);
-          NS_ASSERT (bidIt != rntiIt->second.end ());
-          uint32_t teid = bidIt->second;
+          NS_ASSERT (bid < 16 && bearers->m_teid[bid] != 0);
+          uint32_t teid = bearers->m_teid[bid];
           SendToS1uSocket (packet, teid);
         }
         else  // a match is found in PIT
@@ -341,6 +771,7 @@ EpcEnbApplication::RecvFromLteSocket (Ptr<Socket> socket)
           NS_LOG_INFO ("A match is founf in PIT. Adding a new face into face list");
           // inserting new face into face list
           m_nameFaceMap[interestHeader.GetName()].push_back(pitFace);
+          IndexPitFace (interestHeader.GetName(), pitFace);
         }
       }
       else
@@ -348,7 +779,7 @@ EpcEnbApplication::RecvFromLteSocket (Ptr<Socket> socket)
         NS_LOG_INFO ("A match is found in CS. Sending content to UE");
         // getting the packet to be forwarded from CS
         CsEps_t cs = contentNameIt->second;
-        Ptr<Packet> packetForUe = Create<Packet> (1316); // 7 PES @188Bytes
+        Ptr<Packet> packetForUe = cs.m_content->Copy (); // edit: the cached payload, whatever its size
         packetForUe->AddHeader(*(cs.m_contentHeader));
         cs.m_udpHeader.SetDestinationPort(udpHeader.GetSourcePort());
         packetForUe->AddHeader(cs.m_udpHeader);
@@ -369,17 +800,7 @@ EpcEnbApplication::RecvFromLteSocket (Ptr<Socket> socket)
         packetBuffer.m_packet = packetForUe->Copy ();
         packetBuffer.m_bid = bid;
 
-        std::map<uint16_t, Buff_t>::iterator buffIt = m_buffMap.find (rnti);
-
-        if (buffIt == m_buffMap.end ())
-        {
-          m_buffMap[rnti] = packetBuffer;
-        }
-        else
-        {
-          m_buffMap.erase (buffIt);
-          m_buffMap[rnti] = packetBuffer;
-        }
+        m_buffMap.Get (rnti) = packetBuffer;
 
         // sending packet
         SendToLteSocket (packetForUe, rnti, bid);
@@ -398,11 +819,21 @@ EpcEnbApplication::RecvFromS1uSocket (Ptr<Socket> socket)
   GtpuHeader gtpu;
   packet->RemoveHeader (gtpu);
   uint32_t teid = gtpu.GetTeid ();
-  std::map<uint32_t, EpsFlowId_t>::iterator it = m_teidRbidMap.find (teid);
+  EpsFlowId_t *flow = m_teidRbidMap.Find (teid);
 
-  if (it == m_teidRbidMap.end ())
+  if (teid == VM_CHUNK_CONTENT_TEID || teid == VM_CHUNK_NACK_TEID) // new
+  {
+      SocketAddressTag tag;
+      packet->RemovePacketTag (tag);
+      NS_LOG_INFO ("VM chunk received from the SGW/PGW cache");
+      if (!m_vmChunkCallback.IsNull ())
+      {
+          m_vmChunkCallback (teid, packet);
+      }
+  }
+  else if (flow == 0 && teid != PIT_TRANSFER_CONTENT_TEID) // edit
   {
-      //NS_ASSERT (it != m_teidRbidMap.end ());
+      //NS_ASSERT (flow != 0);
       NS_LOG_INFO ("PACKET SIZE: " << tmp->GetSize());
       Ipv4Header ipv4Header;
       tmp->RemoveHeader (ipv4Header);
@@ -453,39 +884,27 @@ EpcEnbApplication::RecvFromS1uSocket (Ptr<Socket> socket)
 
         m_nameContentMap[contentHeader->GetName()] = cs;
         // composing packet
-        std::vector<EnbPitFace_t> tmp_pitFace = interestNameIt->second;
+        SendToPitFaces (packet, ipv4Header, udpHeader, interestNameIt->second);
 
-        for (uint32_t i = 0; i < tmp_pitFace.size(); i++)
-        {
-            Ptr<Packet> p = packet->Copy ();
-            NS_LOG_INFO ("Generating packet");
-            NS_LOG_INFO ("Destination of Packet: " << tmp_pitFace[i].m_ipv4address << " BID: " << (uint32_t) (tmp_pitFace[i].m_bid));
-            ipv4Header.SetDestination(tmp_pitFace[i].m_ipv4address);
-            udpHeader.SetDestinationPort(tmp_pitFace[i].m_port);
-            p->AddHeader(udpHeader);
-            p->AddHeader(ipv4Header);
-
-            Buff_t packetBuffer;
-            packetBuffer.m_packet = p->Copy ();
-            packetBuffer.m_bid = tmp_pitFace[i].m_bid;
-
-            std::map<uint16_t, Buff_t>::iterator buffIt = m_buffMap.find (tmp_pitFace[i].m_rnti);
+        UnindexPitEntry (contentHeader->GetName(), interestNameIt->second);
+        m_nameFaceMap.erase (interestNameIt);
+        NS_LOG_INFO ("PIT entry is deleted");
 
-            if (buffIt == m_buffMap.end ())
-            {
-               m_buffMap[tmp_pitFace[i].m_rnti] = packetBuffer;
-            }
-            else
+        // forwarding content requested on behalf of a handover target
+        std::map<ns3::ndn::Name, std::vector<uint16_t> >::iterator pendingIt
+        = m_csMigrationPendingMap.find (contentHeader->GetName());
+        if (pendingIt != m_csMigrationPendingMap.end ())
+        {
+            // several UEs may be handed over to the same cell
+            std::sort (pendingIt->second.begin (), pendingIt->second.end ());
+            std::vector<uint16_t>::iterator end = std::unique (pendingIt->second.begin (), pendingIt->second.end ());
+            for (std::vector<uint16_t>::iterator cellIt = pendingIt->second.begin (); cellIt != end; ++cellIt)
             {
-               m_buffMap.erase (buffIt);
-               m_buffMap[tmp_pitFace[i].m_rnti] = packetBuffer;
+                NS_LOG_INFO ("Forwarding prefetched content to cell " << *cellIt);
+                m_csMigrationCallback (*cellIt, cs);
             }
-
-            SendToLteSocket (p, tmp_pitFace[i].m_rnti, tmp_pitFace[i].m_bid);
+            m_csMigrationPendingMap.erase (pendingIt);
         }
-
-        m_nameFaceMap.erase (interestNameIt);
-        NS_LOG_INFO ("PIT entry is deleted");
     }
   }
   else // if a match is found in CS
@@ -496,6 +915,58 @@ EpcEnbApplication::RecvFromS1uSocket (Ptr<Socket> socket)
 }
 
 
+void
+EpcEnbApplication::IndexPitFace (const ns3::ndn::Name &name, const EnbPitFace_t &pitFace) // new
+{
+  if (m_pitTransfer)
+    {
+      m_ueNameHistoryMap.Get (pitFace.m_rnti).m_pitNames.insert (name);
+    }
+}
+
+void
+EpcEnbApplication::UnindexPitEntry (const ns3::ndn::Name &name, const std::vector<EnbPitFace_t> &pitFaces) // new
+{
+  for (std::vector<EnbPitFace_t>::const_iterator faceIt = pitFaces.begin (); faceIt != pitFaces.end (); ++faceIt)
+    {
+      UeNameHistory_t *history = m_ueNameHistoryMap.Find (faceIt->m_rnti);
+      if (history != 0)
+        {
+          history->m_pitNames.erase (name);
+        }
+    }
+}
+
+void
+EpcEnbApplication::SendToPitFaces (Ptr<Packet> packet, Ipv4Header ipv4Header, UdpHeader udpHeader, std::vector<EnbPitFace_t> pitFaces)
+{
+  NS_LOG_FUNCTION (this << packet << pitFaces.size ());
+  for (uint32_t i = 0; i < pitFaces.size(); i++)
+  {
+      if (pitFaces[i].m_generation != 0 && !m_rbidTeidMap.IsValid (pitFaces[i].m_rnti, pitFaces[i].m_generation))
+      {
+          // the UE left and its RNTI may have been given to another UE
+          NS_LOG_LOGIC ("stale PIT face of RNTI " << pitFaces[i].m_rnti << ", skipping");
+          continue;
+      }
+      Ptr<Packet> p = packet->Copy ();
+      NS_LOG_INFO ("Generating packet");
+      NS_LOG_INFO ("Destination of Packet: " << pitFaces[i].m_ipv4address << " BID: " << (uint32_t) (pitFaces[i].m_bid));
+      ipv4Header.SetDestination(pitFaces[i].m_ipv4address);
+      udpHeader.SetDestinationPort(pitFaces[i].m_port);
+      p->AddHeader(udpHeader);
+      p->AddHeader(ipv4Header);
+
+      Buff_t packetBuffer;
+      packetBuffer.m_packet = p->Copy ();
+      packetBuffer.m_bid = pitFaces[i].m_bid;
+
+      m_buffMap.Get (pitFaces[i].m_rnti) = packetBuffer;
+
+      SendToLteSocket (p, pitFaces[i].m_rnti, pitFaces[i].m_bid);
+  }
+}
+
 void
 EpcEnbApplication::SendToLteSocket (Ptr<Packet> packet, uint16_t rnti, uint8_t bid)
 {
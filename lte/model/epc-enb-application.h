@@ -23,6 +23,7 @@
 #define EPC_ENB_APPLICATION_H
 
 #include <ns3/lte-ccn-common.h> // edited
+#include <ns3/rnti-slot-table.h> // new
 #include <ns3/names.h>  // edit
 #include "ns3/ipv4-address.h" // edit
 #include <ns3/address.h>
@@ -39,6 +40,8 @@
 #include <ns3/epc-s1ap-sap.h>
 #include <map>
 #include <vector>
+#include <deque> // new
+#include <set> // new
 
 namespace ns3 {
 class EpcEnbS1SapUser;
@@ -140,6 +143,92 @@ public:
 
   void SendToCloudComponent (Ptr<Packet> packet);
 
+  /**
+   * Callback invoked to ship a CS entry to the X2 peer identified by the
+   * cell id, used to migrate the content of a UE during handover
+   */
+  typedef Callback<void, uint16_t, CsEps_t> CsMigrationCallback; // new
+
+  /**
+   * \param cb the callback used to send CS entries to a target eNB
+   */
+  void SetCsMigrationCallback (CsMigrationCallback cb); // new
+
+  /**
+   * Called by the RRC when the target eNB has accepted the handover of a UE. The CS
+   * entries matching the names recently requested by the UE, plus the names
+   * predicted from its request history, are sent to the target eNB. The
+   * predicted names which are not cached yet are requested to the SGW/PGW
+   * and forwarded to the target eNB as soon as they arrive.
+   *
+   * \param rnti the RNTI of the UE being handed over
+   * \param targetCellId the cell id of the target eNB
+   */
+  void PrepareCsMigration (uint16_t rnti, uint16_t targetCellId); // new
+
+  /**
+   * Called by the RRC when the handover of a UE is aborted after the target
+   * eNB accepted it: the names requested for the target eNB on behalf of
+   * the UE are no longer forwarded to it, and the PIT entries opened only
+   * for them are dropped.
+   *
+   * \param rnti the RNTI of the UE
+   */
+  void CancelCsMigration (uint16_t rnti); // new
+
+  /**
+   * Install a CS entry received from the source eNB of a handover. Any
+   * pending PIT entry for the same name is satisfied immediately.
+   *
+   * \param cs the migrated CS entry
+   */
+  void RecvMigratedContent (CsEps_t cs); // new
+
+  /**
+   * \param name the content name
+   * \return true if the content is in the CS
+   */
+  bool HasContent (ns3::ndn::Name name) const; // new
+
+  /**
+   * Callback invoked with the VM chunk TEID and the packet when a named VM
+   * chunk (content or NACK) is received from the SGW/PGW cache
+   */
+  typedef Callback<void, uint32_t, Ptr<Packet> > VmChunkCallback; // new
+
+  void SetVmChunkCallback (VmChunkCallback cb); // new
+
+  /**
+   * Send a named VM chunk Interest, or publish a VM chunk, to the SGW/PGW cache
+   *
+   * \param teid VM_CHUNK_INTEREST_TEID or VM_CHUNK_CONTENT_TEID
+   * \param packet the Interest, or the content header and content
+   */
+  void SendVmChunkToGateway (uint32_t teid, Ptr<Packet> packet); // new
+
+  /**
+   * Called by the X2 entity when the handover request of a UE is sent. The
+   * names of the PIT entries the UE is waiting for are returned, so that the
+   * target eNB can request them before the UE arrives. The entries are kept
+   * here as well and still served over X2 until the UE has left.
+   *
+   * \param rnti the RNTI of the UE being handed over
+   * \return the headers of the last Interest of the UE, its bearer, and the
+   * pending names, or 0 if PitTransfer is disabled or nothing is pending
+   */
+  Ptr<Packet> GetPitTransfer (uint16_t rnti); // new
+
+  /**
+   * Install the PIT entries transferred by the source eNB of a handover.
+   * The names neither cached nor pending here are requested to the SGW/PGW
+   * at once; the UE is added to the PIT entries, and given the cached
+   * content, when its path is switched to this eNB.
+   *
+   * \param rnti the RNTI of the UE in this cell
+   * \param packet the transfer built by GetPitTransfer at the source eNB
+   */
+  void RecvPitTransfer (uint16_t rnti, Ptr<Packet> packet); // new
+
   struct EpsFlowId_t
   {
     uint16_t  m_rnti;
@@ -161,7 +250,33 @@ public:
     Buff_t ();
   };
 
-  std::map<uint16_t, Buff_t> m_buffMap;  // new
+  /**
+   * last packet sent to each UE, indexed by RNTI
+   */
+  RntiSlotTable<Buff_t> m_buffMap;  // new
+
+  struct UeNameHistory_t  // new
+  {
+    std::deque<ns3::ndn::Name> m_names;
+    Ipv4Header m_ipHeader;
+    UdpHeader m_udpHeader;
+    uint8_t m_bid;
+    std::vector<ns3::ndn::Name> m_csMigrationPending; ///< names pending for the target of the UE
+    uint16_t m_csMigrationCellId; ///< the target the names are pending for
+    std::set<ns3::ndn::Name> m_pitNames; ///< names of the PIT entries with a face of the UE
+    public:
+    UeNameHistory_t ();
+  };
+
+  struct PitTransfer_t  // new
+  {
+    std::vector<ns3::ndn::Name> m_names;
+    Ipv4Header m_ipHeader;
+    UdpHeader m_udpHeader;
+    uint8_t m_bid;
+    public:
+    PitTransfer_t ();
+  };
 
 
 private:
@@ -171,6 +286,12 @@ private:
   void DoPathSwitchRequest (EpcEnbS1SapProvider::PathSwitchRequestParameters params);
   void DoUeContextRelease (uint16_t rnti);
 
+  /**
+   * Add a UE whose path has just been switched here to the PIT entries
+   * transferred for it, and send it the content already received
+   */
+  void ActivatePitTransfer (uint16_t rnti); // new
+
   // S1-AP SAP ENB methods
   void DoInitialContextSetupRequest (uint64_t mmeUeS1Id, uint16_t enbUeS1Id, std::list<EpcS1apSapEnb::ErabToBeSetupItem> erabToBeSetupList);
   void DoPathSwitchRequestAcknowledge (uint64_t enbUeS1Id, uint64_t mmeUeS1Id, uint16_t cgi, std::list<EpcS1apSapEnb::ErabSwitchedInUplinkItem> erabToBeSwitchedInUplinkList);
@@ -192,6 +313,39 @@ private:
    */
   void SendToS1uSocket (Ptr<Packet> packet, uint32_t teid);
 
+  /**
+   * Send a content packet to every face of a PIT entry
+   *
+   * \param packet content header and content
+   * \param ipv4Header the IP header of the content
+   * \param udpHeader the UDP header of the content
+   * \param pitFaces the faces the content is to be sent to
+   */
+  void SendToPitFaces (Ptr<Packet> packet, Ipv4Header ipv4Header, UdpHeader udpHeader, std::vector<EnbPitFace_t> pitFaces); // new
+
+  /**
+   * Record a face added to a PIT entry in the pending names of its UE
+   *
+   * \param name the name of the PIT entry
+   * \param pitFace the face added
+   */
+  void IndexPitFace (const ns3::ndn::Name &name, const EnbPitFace_t &pitFace); // new
+
+  /**
+   * Drop a PIT entry about to be erased from the pending names of its UEs
+   *
+   * \param name the name of the PIT entry
+   * \param pitFaces the faces of the entry
+   */
+  void UnindexPitEntry (const ns3::ndn::Name &name, const std::vector<EnbPitFace_t> &pitFaces); // new
+
+  /**
+   * \param rnti the RNTI of the UE
+   * \return the names recently requested by the UE followed by the names
+   * predicted to be requested next
+   */
+  std::vector<ns3::ndn::Name> GetCsMigrationNames (uint16_t rnti); // new
+
 
 
   /**
@@ -224,16 +378,28 @@ private:
   Ipv4Address m_sgwS1uAddress;
 
   /**
-   * map of maps telling for each RNTI and BID the corresponding  S1-U TEID
-   *
+   * S1-U TEID of each EPS bearer of a UE, indexed by BID, 0 if the bearer
+   * is not set up
    */
-  std::map<uint16_t, std::map<uint8_t, uint32_t> > m_rbidTeidMap;
+  struct UeBearers_t
+  {
+    uint32_t m_teid[16];
+
+  public:
+    UeBearers_t ();
+  };
 
   /**
-   * map telling for each S1-U TEID the corresponding RNTI,BID
+   * bearers of each UE, indexed by RNTI. The generation of a slot tells
+   * apart the successive UEs given the same RNTI.
+   */
+  RntiSlotTable<UeBearers_t> m_rbidTeidMap;
+
+  /**
+   * table telling for each S1-U TEID the corresponding RNTI,BID
    *
    */
-  std::map<uint32_t, EpsFlowId_t> m_teidRbidMap;
+  TeidTable<EpsFlowId_t> m_teidRbidMap;
 
   std::map<ns3::ndn::Name, CsEps_t> m_nameContentMap;  // new
 
@@ -274,6 +440,41 @@ private:
 
   uint16_t m_cellId;
 
+  /**
+   * names recently requested by each UE, along with the headers of its last
+   * Interest which are reused to request the predicted names, and the names
+   * of the PIT entries the UE is waiting for, kept while PitTransfer is
+   * enabled
+   */
+  RntiSlotTable<UeNameHistory_t> m_ueNameHistoryMap; // new
+
+  /**
+   * names requested on behalf of a target eNB, mapped to the cell ids of
+   * the eNBs waiting for them, once per UE handed over to the cell
+   */
+  std::map<ns3::ndn::Name, std::vector<uint16_t> > m_csMigrationPendingMap; // new
+
+  CsMigrationCallback m_csMigrationCallback; // new
+
+  VmChunkCallback m_vmChunkCallback; // new
+
+  bool m_csMigration; // new
+  uint32_t m_csMigrationHistory; // new
+  uint32_t m_csMigrationWindow; // new
+
+  /**
+   * PIT entries transferred by the source eNB for each incoming UE, indexed
+   * by its RNTI in this cell
+   */
+  RntiSlotTable<PitTransfer_t> m_pitTransferMap; // new
+  bool m_pitTransfer; // new
+
+  //             RNTI      names     names cached or pending here
+  TracedCallback<uint16_t, uint32_t, uint32_t> m_pitTransferTrace; // new
+
+  //             RNTI of the UE switched by the S1-AP message
+  TracedCallback<uint16_t> m_pathSwitchTrace; // new
+
 };
 
 } //namespace ns3
@@ -185,6 +185,12 @@ EpcSgwPgwApplication::RecvFromTunDevice (Ptr<Packet> packet, const Address& sour
             udpHeader.SetDestinationPort(tmp_pitFace[i].m_port);
             p->AddHeader(udpHeader);
             p->AddHeader(ipv4Header);
+            if (tmp_pitFace[i].m_enbAddress != Ipv4Address::GetAny ()) // new
+            {
+                NS_LOG_INFO ("Sending content to eNodeB " << tmp_pitFace[i].m_enbAddress << " which took over the PIT entry");
+                SendToS1uSocket (p, tmp_pitFace[i].m_enbAddress, PIT_TRANSFER_CONTENT_TEID);
+                continue;
+            }
             Ipv4Address ueAddr =  ipv4Header.GetDestination ();
             NS_LOG_LOGIC ("packet addressed to UE " << ueAddr);
 
@@ -230,7 +236,8 @@ EpcSgwPgwApplication::RecvFromS1uSocket (Ptr<Socket> socket)
 {
   NS_LOG_FUNCTION (this << socket);
   NS_ASSERT (socket == m_s1uSocket);
-  Ptr<Packet> packet = socket->Recv ();
+  Address from;
+  Ptr<Packet> packet = socket->RecvFrom (from);
   GtpuHeader gtpu;
   packet->RemoveHeader (gtpu);
   uint32_t teid = gtpu.GetTeid ();
@@ -239,6 +246,17 @@ EpcSgwPgwApplication::RecvFromS1uSocket (Ptr<Socket> socket)
   SocketAddressTag tag;
   packet->RemovePacketTag (tag);
 
+  if (teid == VM_CHUNK_INTEREST_TEID || teid == VM_CHUNK_CONTENT_TEID) // new
+    {
+      RecvVmChunkFromS1u (packet, teid, InetSocketAddress::ConvertFrom (from).GetIpv4 ());
+      return;
+    }
+
+  // an Interest re-expressed by the target eNB of a handover: the content
+  // goes back to that eNB, even before the path of the UE is switched
+  bool transferred = (teid == PIT_TRANSFER_INTEREST_TEID); // new
+  Ipv4Address enbAddr = InetSocketAddress::ConvertFrom (from).GetIpv4 (); // new
+
   // getting interest name
   Ptr<Packet> pCopy = packet->Copy ();
   Ipv4Header ipv4Header;
@@ -261,6 +279,10 @@ EpcSgwPgwApplication::RecvFromS1uSocket (Ptr<Socket> socket)
     = m_nameFaceMap.find (interestHeader.GetName());
 
     SgwPgwPitFace_t pitFace (udpHeader.GetSourcePort(), ipv4Header.GetSource());
+    if (transferred) // new
+    {
+        pitFace.m_enbAddress = enbAddr;
+    }
 
     if (interestNameIt == m_nameFaceMap.end ())  // no match is found in PIT
     {
@@ -282,13 +304,20 @@ EpcSgwPgwApplication::RecvFromS1uSocket (Ptr<Socket> socket)
     NS_LOG_INFO ("A match is found in CS table");
     // getting the packet to be forwarded from CS
     CsEps_t cs = contentNameIt->second;
-    Ptr<Packet> packetForUe = Create<Packet> (1316); // 7 PES @188Bytes
+    Ptr<Packet> packetForUe = cs.m_content->Copy (); // edit: the cached payload, whatever its size
     packetForUe->AddHeader(*(cs.m_contentHeader));
     cs.m_udpHeader.SetDestinationPort(udpHeader.GetSourcePort());
     packetForUe->AddHeader(cs.m_udpHeader);
     cs.m_ipHeader.SetDestination(ipv4Header.GetSource());
     packetForUe->AddHeader(cs.m_ipHeader);
 
+    if (transferred) // new
+      {
+        NS_LOG_INFO ("Sending packet to eNodeB " << enbAddr << " which took over the PIT entry");
+        SendToS1uSocket (packetForUe, enbAddr, PIT_TRANSFER_CONTENT_TEID);
+        return;
+      }
+
     // find corresponding UeInfo address
     std::map<Ipv4Address, Ptr<UeInfo> >::iterator it = m_ueInfoByAddrMap.find (ipv4Header.GetSource ());
     if (it == m_ueInfoByAddrMap.end ())
@@ -315,6 +344,42 @@ EpcSgwPgwApplication::RecvFromS1uSocket (Ptr<Socket> socket)
 
 }
 
+void
+EpcSgwPgwApplication::RecvVmChunkFromS1u (Ptr<Packet> packet, uint32_t teid, Ipv4Address enbAddr) // new
+{
+  NS_LOG_FUNCTION (this << packet << teid << enbAddr);
+
+  if (teid == VM_CHUNK_CONTENT_TEID)
+    {
+      Ptr<ns3::ndn::ContentObject> contentHeader = Create<ns3::ndn::ContentObject> ();
+      packet->RemoveHeader (*contentHeader);
+      NS_LOG_INFO ("Caching VM chunk " << contentHeader->GetName () << " published by eNB " << enbAddr);
+      CsEps_t cs;
+      cs.m_content       = packet;
+      cs.m_contentHeader = contentHeader;
+      m_nameContentMap[contentHeader->GetName ()] = cs;
+      return;
+    }
+
+  Ptr<Packet> pCopy = packet->Copy ();
+  ns3::ndn::Interest interestHeader;
+  pCopy->RemoveHeader (interestHeader);
+
+  std::map<ns3::ndn::Name, CsEps_t>::iterator contentNameIt = m_nameContentMap.find (interestHeader.GetName ());
+  if (contentNameIt == m_nameContentMap.end ())
+    {
+      NS_LOG_INFO ("VM chunk " << interestHeader.GetName () << " not cached, NACK to eNB " << enbAddr);
+      SendToS1uSocket (packet, enbAddr, VM_CHUNK_NACK_TEID);
+    }
+  else
+    {
+      NS_LOG_INFO ("VM chunk " << interestHeader.GetName () << " found in CS, sending it to eNB " << enbAddr);
+      Ptr<Packet> content = contentNameIt->second.m_content->Copy ();
+      content->AddHeader (*(contentNameIt->second.m_contentHeader));
+      SendToS1uSocket (content, enbAddr, VM_CHUNK_CONTENT_TEID);
+    }
+}
+
 void
 EpcSgwPgwApplication::SendToTunDevice (Ptr<Packet> packet, uint32_t teid)
 {
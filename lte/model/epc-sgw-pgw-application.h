@@ -172,6 +172,17 @@ private:
   void DoCreateSessionRequest (EpcS11SapSgw::CreateSessionRequestMessage msg);
   void DoModifyBearerRequest (EpcS11SapSgw::ModifyBearerRequestMessage msg);
 
+  /**
+   * Serve a named VM chunk packet received from an eNB: an Interest is
+   * answered from the CS, or returned as a NACK if the chunk is not cached;
+   * a content is cached for the next eNBs requesting it
+   *
+   * \param packet the Interest or the content header and content
+   * \param teid the VM chunk TEID telling the packet type
+   * \param enbAddr the S1-U address of the eNB
+   */
+  void RecvVmChunkFromS1u (Ptr<Packet> packet, uint32_t teid, Ipv4Address enbAddr); // new
+
   /**
    * store info for each UE connected to this SGW
    */
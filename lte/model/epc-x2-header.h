@@ -70,7 +70,15 @@ public:
     IcnMessageSource        = 4, // new
     MigrationRequest        = 5, // new
     StartVmCmd              = 6,  // new
-    InterestVm              = 7
+    InterestVm              = 7,
+    CsMigration             = 8, // new
+    InterestVmChunk         = 9, // new
+    InterestVmChunkCache    = 10, // new
+    VmPlacement             = 11, // new
+    VmPrediction            = 12, // new
+    X2Bundle                = 13, // new
+    PitTransfer             = 14, // new
+    VmReport                = 15 // new
   };
 
 private:
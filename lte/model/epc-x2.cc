@@ -30,7 +30,17 @@
 #include "ns3/string.h" // edit
 #include <stdlib.h> // edit
 #include <stdio.h> // edit
+#include <string.h> // new
 #include "ns3/simulator.h" // edit
+#include "ns3/boolean.h" // new
+#include "ns3/uinteger.h" // new
+#include "ns3/enum.h" // new
+#include "ns3/ipv4-address.h" // new
+#include "ns3/trace-source-accessor.h" // new
+#include <time.h> // new
+#include "ns3/ndn-interest.h" // new
+#include "ns3/ndn-content-object.h" // new
+#include <algorithm> // new
 
 
 NS_LOG_COMPONENT_DEFINE ("EpcX2");
@@ -43,6 +53,7 @@ X2IfaceInfo::X2IfaceInfo (Ipv4Address remoteIpAddr, Ptr<Socket> localCtrlPlaneSo
   m_remoteIpAddr = remoteIpAddr;
   m_localCtrlPlaneSocket = localCtrlPlaneSocket;
   m_localUserPlaneSocket = localUserPlaneSocket;
+  m_lastUse = Simulator::Now (); // new
 }
 
 X2IfaceInfo::~X2IfaceInfo (void)
@@ -58,6 +69,7 @@ X2IfaceInfo::operator= (const X2IfaceInfo& value)
   m_remoteIpAddr = value.m_remoteIpAddr;
   m_localCtrlPlaneSocket = value.m_localCtrlPlaneSocket;
   m_localUserPlaneSocket = value.m_localUserPlaneSocket;
+  m_lastUse = value.m_lastUse; // new
   return *this;
 }
 
@@ -86,17 +98,105 @@ X2CellInfo::operator= (const X2CellInfo& value)
 
 ///////////////////////////////////////////
 
+VmMigrationInfo::VmMigrationInfo (uint16_t peerCellId, uint16_t migrationId)
+  : m_peerCellId (peerCellId),
+    m_migrationId (migrationId),
+    m_chunks (0),
+    m_state (PREPARED),
+    m_nextChunk (0),
+    m_outstanding (0),
+    m_predictedCellId (0),
+    m_handoverCellId (0)
+{
+}
+
+VmMigrationInfo::~VmMigrationInfo (void)
+{
+}
+
+///////////////////////////////////////////
+
 NS_OBJECT_ENSURE_REGISTERED (EpcX2);
 
+const uint32_t EpcX2::X2C_LATENCY_BINS;
+const uint32_t EpcX2::VM_TEID_PREFIX;
+const uint32_t EpcX2::VM_TEID_MASK;
+const uint16_t EpcX2::VM_CHUNK_GATEWAY_ID;
+
 EpcX2::EpcX2 ()
-  : m_x2cUdpPort (4444),
+  : m_x2cUnhandled (0),
+    m_x2cStats (false),
+    m_x2cProfiling (false),
+    m_x2cDispatchDepth (0),
+    m_x2cNestedUs (0),
+    m_x2cUdpPort (4444),
     m_x2uUdpPort (6666),
-    m_counter (0), // edit
-    m_targetCounter (0) // edit
+    m_vmChunkSize (1298), // new
+    m_vmNamedChunks (false), // new
+    m_vmSharedChunks (0), // new
+    m_vmFetchWindow (16), // new
+    m_vmGatewayCache (true), // new
+    m_vmMultiSource (false), // new
+    m_vmPlacement (false), // new
+    m_vmCapacity (8), // new
+    m_vmPlacementHorizon (1000), // new
+    m_localCellId (0), // new
+    m_vmHosted (0), // new
+    m_sharedSockets (false),
+    m_x2Scheduler (X2_SCHED_NONE), // new
+    m_x2ControlQuantum (3000), // new
+    m_x2UeDataQuantum (3000), // new
+    m_x2BulkQuantum (1500), // new
+    m_x2cMessagesSent (0), // new
+    m_x2cBytesSent (0), // new
+    m_controllerMessagesSent (0), // new
+    m_controllerBytesSent (0), // new
+    m_maxBundleSize (65507), // new
+    m_x2SendFailures (0), // new
+    m_x2BundleDrops (0) // new
 {
   NS_LOG_FUNCTION (this);
 
   m_x2SapProvider = new EpcX2SpecificEpcX2SapProvider<EpcX2> (this);
+
+  RegisterX2cHandler (EpcX2Header::HandoverPreparation, EpcX2Header::InitiatingMessage,
+                      "HandoverRequest", &EpcX2::DoRecvHandoverRequest, true);
+  RegisterX2cHandler (EpcX2Header::HandoverPreparation, EpcX2Header::SuccessfulOutcome,
+                      "HandoverRequestAck", &EpcX2::DoRecvHandoverRequestAck, true);
+  RegisterX2cHandler (EpcX2Header::HandoverPreparation, EpcX2Header::UnsuccessfulOutcome,
+                      "HandoverPreparationFailure", &EpcX2::DoRecvHandoverPreparationFailure, true);
+  RegisterX2cHandler (EpcX2Header::HandoverPreparation, EpcX2Header::IcnMessage,
+                      "IcnMessage", &EpcX2::DoRecvIcnMessage, false);
+  RegisterX2cHandler (EpcX2Header::HandoverPreparation, EpcX2Header::IcnMessageSource,
+                      "IcnMessageSource", &EpcX2::DoRecvIcnMessageSource, false);
+  RegisterX2cHandler (EpcX2Header::HandoverPreparation, EpcX2Header::MigrationRequest,
+                      "MigrationRequest", &EpcX2::DoRecvMigrationRequest, false);
+  RegisterX2cHandler (EpcX2Header::HandoverPreparation, EpcX2Header::StartVmCmd,
+                      "StartVmCmd", &EpcX2::DoRecvStartVmCmd, false);
+  RegisterX2cHandler (EpcX2Header::HandoverPreparation, EpcX2Header::InterestVm,
+                      "InterestVm", &EpcX2::DoRecvInterestVm, true);
+  RegisterX2cHandler (EpcX2Header::HandoverPreparation, EpcX2Header::CsMigration,
+                      "CsMigration", &EpcX2::DoRecvCsMigration, true);
+  RegisterX2cHandler (EpcX2Header::HandoverPreparation, EpcX2Header::InterestVmChunk,
+                      "InterestVmChunk", &EpcX2::DoRecvInterestVmChunk, true);
+  RegisterX2cHandler (EpcX2Header::HandoverPreparation, EpcX2Header::InterestVmChunkCache,
+                      "InterestVmChunkCache", &EpcX2::DoRecvInterestVmChunkCache, true);
+  RegisterX2cHandler (EpcX2Header::HandoverPreparation, EpcX2Header::VmPlacement,
+                      "VmPlacement", &EpcX2::DoRecvVmPlacement, true);
+  RegisterX2cHandler (EpcX2Header::HandoverPreparation, EpcX2Header::VmPrediction,
+                      "VmPrediction", &EpcX2::DoRecvVmPrediction, true);
+  RegisterX2cHandler (EpcX2Header::HandoverPreparation, EpcX2Header::X2Bundle,
+                      "X2Bundle", &EpcX2::DoRecvX2Bundle, true);
+  RegisterX2cHandler (EpcX2Header::HandoverPreparation, EpcX2Header::PitTransfer,
+                      "PitTransfer", &EpcX2::DoRecvPitTransfer, true);
+  RegisterX2cHandler (EpcX2Header::LoadIndication, EpcX2Header::InitiatingMessage,
+                      "LoadInformation", &EpcX2::DoRecvLoadInformation, true);
+  RegisterX2cHandler (EpcX2Header::SnStatusTransfer, EpcX2Header::InitiatingMessage,
+                      "SnStatusTransfer", &EpcX2::DoRecvSnStatusTransfer, true);
+  RegisterX2cHandler (EpcX2Header::UeContextRelease, EpcX2Header::InitiatingMessage,
+                      "UeContextRelease", &EpcX2::DoRecvUeContextRelease, true);
+  RegisterX2cHandler (EpcX2Header::ResourceStatusReporting, EpcX2Header::InitiatingMessage,
+                      "ResourceStatusUpdate", &EpcX2::DoRecvResourceStatusUpdate, true);
 }
 
 EpcX2::~EpcX2 ()
@@ -109,8 +209,34 @@ EpcX2::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
 
+  if (m_x2cStats)
+    {
+      ostringstream x2cStatsFile;
+      x2cStatsFile << m_simName << "_x2cStats.csv";
+      ofstream out ((x2cStatsFile.str ()).c_str (), ios::app);
+      PrintX2cStats (out);
+    }
+  if (m_x2cProfiling)
+    {
+      // wall-clock times, kept apart from the results of the simulation
+      ostringstream x2cProfileFile;
+      x2cProfileFile << m_simName << "_x2cProfile.csv";
+      ofstream out ((x2cProfileFile.str ()).c_str (), ios::app);
+      PrintX2cProfile (out);
+    }
+
   m_x2InterfaceSockets.clear ();
   m_x2InterfaceCellIds.clear ();
+  m_x2InterfaceCellIdsByAddr.clear ();
+  m_sharedX2cSocket = 0;
+  m_sharedX2uSocket = 0;
+  m_x2InterfaceRequestCallback = MakeNullCallback<void, uint16_t, uint16_t> ();
+  for (std::map<uint16_t, X2LinkQueue>::iterator it = m_x2LinkQueues.begin (); it != m_x2LinkQueues.end (); ++it)
+    {
+      it->second.m_serveEvent.Cancel ();
+    }
+  m_x2LinkQueues.clear ();
+  m_x2Bundles.clear ();
   delete m_x2SapProvider;
 }
 
@@ -134,6 +260,192 @@ EpcX2::GetTypeId (void)
                    UintegerValue (0), // 0: no VM migration;
                    MakeUintegerAccessor (&EpcX2::m_vmMigration),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("VmChunkSize",
+                   "The size in bytes of the VM chunks sent over X2-U",
+                   UintegerValue (1298),
+                   MakeUintegerAccessor (&EpcX2::m_vmChunkSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("X2LinkDataRate",
+                   "The X2 link capacity the VM chunks are paced at. The VM migrations "
+                   "towards the same cell share this capacity",
+                   DataRateValue (DataRate ("50Mb/s")),
+                   MakeDataRateAccessor (&EpcX2::m_x2LinkDataRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("ControllerAddress",
+                   "The address of the controller of the VM migrations",
+                   Ipv4AddressValue ("13.0.0.1"),
+                   MakeIpv4AddressAccessor (&EpcX2::m_controllerAddress),
+                   MakeIpv4AddressChecker ())
+    .AddAttribute ("VmNamedChunks",
+                   "If true, the target eNB pulls the VM chunks as named content, "
+                   "looking them up in its CS and in the SGW/PGW cache before asking "
+                   "the source eNB, instead of the source eNB pushing them",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&EpcX2::m_vmNamedChunks),
+                   MakeBooleanChecker ())
+    .AddAttribute ("VmImageName",
+                   "The name of the base image of the migrated VMs",
+                   StringValue ("base"),
+                   MakeStringAccessor (&EpcX2::m_vmImageName),
+                   MakeStringChecker ())
+    .AddAttribute ("VmSharedChunks",
+                   "The number of leading VM chunks which belong to the base image "
+                   "and are the same for all the VMs, the others being unique",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&EpcX2::m_vmSharedChunks),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("VmFetchWindow",
+                   "The maximum number of named VM chunks requested to a source and not "
+                   "received yet",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&EpcX2::m_vmFetchWindow),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("VmGatewayCache",
+                   "If true, the named base image chunks are looked up in the SGW/PGW "
+                   "cache, and published to it when fetched from the source eNB",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&EpcX2::m_vmGatewayCache),
+                   MakeBooleanChecker ())
+    .AddAttribute ("VmMultiSource",
+                   "If true, the named base image chunks are fetched in parallel from the "
+                   "source eNB, the other X2 neighbors and the SGW/PGW cache, each chunk "
+                   "going to the source expected to deliver it first given its measured "
+                   "delivery rate. VmFetchWindow then applies to each source.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&EpcX2::m_vmMultiSource),
+                   MakeBooleanChecker ())
+    .AddAttribute ("VmPlacement",
+                   "If true, the target eNB of a handover places the VM of the UE on "
+                   "itself or on the X2 neighbor offering the lowest estimated response "
+                   "latency, given the load reported by the neighbors, the X2 link rate "
+                   "and the cell the UE is predicted to be served by",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&EpcX2::m_vmPlacement),
+                   MakeBooleanChecker ())
+    .AddAttribute ("VmCapacity",
+                   "The number of VMs an eNB can host, its compute load being the "
+                   "share of this capacity in use",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&EpcX2::m_vmCapacity),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("VmServiceTime",
+                   "The time a VM takes to serve a request on an idle eNB",
+                   TimeValue (MilliSeconds (5)),
+                   MakeTimeAccessor (&EpcX2::m_vmServiceTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("VmRemoteAccessDelay",
+                   "The latency added to each request when the VM is not hosted by the "
+                   "cell serving the UE, the request and the response crossing X2",
+                   TimeValue (MilliSeconds (4)),
+                   MakeTimeAccessor (&EpcX2::m_vmRemoteAccessDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("VmPlacementHorizon",
+                   "The number of requests the transfer of the VM is amortized over "
+                   "when comparing the placements",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&EpcX2::m_vmPlacementHorizon),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("VmNeighborLoadMaxAge",
+                   "The age beyond which the load reported by a neighbor is stale, "
+                   "and the neighbor is not considered for a VM placement",
+                   TimeValue (Seconds (5)),
+                   MakeTimeAccessor (&EpcX2::m_vmNeighborLoadMaxAge),
+                   MakeTimeChecker ())
+    .AddAttribute ("X2Scheduler",
+                   "How X2-C messages, forwarded UE data and VM chunks share the X2 link "
+                   "towards a neighbor. With a scheduler, the packets are queued per class "
+                   "and sent at X2LinkDataRate.",
+                   EnumValue (X2_SCHED_NONE),
+                   MakeEnumAccessor (&EpcX2::m_x2Scheduler),
+                   MakeEnumChecker (X2_SCHED_NONE,     "None",
+                                    X2_SCHED_PRIORITY, "StrictPriority",
+                                    X2_SCHED_DRR,      "Drr"))
+    .AddAttribute ("X2ControlQuantum",
+                   "The bytes the X2-C class may send per deficit round robin round",
+                   UintegerValue (3000),
+                   MakeUintegerAccessor (&EpcX2::m_x2ControlQuantum),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("X2UeDataQuantum",
+                   "The bytes the UE data class may send per deficit round robin round",
+                   UintegerValue (3000),
+                   MakeUintegerAccessor (&EpcX2::m_x2UeDataQuantum),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("X2BulkQuantum",
+                   "The bytes the VM chunk class may send per deficit round robin round",
+                   UintegerValue (1500),
+                   MakeUintegerAccessor (&EpcX2::m_x2BulkQuantum),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("SharedSockets",
+                   "If true, a single X2-C and a single X2-U socket are used for all the "
+                   "X2 interfaces of the eNB, the peer being identified by the source "
+                   "address of the received packets. Must be set before the X2 "
+                   "interfaces are added.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&EpcX2::m_sharedSockets),
+                   MakeBooleanChecker ())
+    .AddAttribute ("X2cStats",
+                   "If true, the per-handler X2-C counters are written to "
+                   "<SimName>_x2cStats.csv when the entity is disposed",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&EpcX2::m_x2cStats),
+                   MakeBooleanChecker ())
+    .AddAttribute ("X2cProfiling",
+                   "If true, the wall-clock handling time of each X2-C handler is "
+                   "measured and written to <SimName>_x2cProfile.csv when the entity "
+                   "is disposed. These times differ between identical runs.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&EpcX2::m_x2cProfiling),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxBundleSize",
+                   "The largest X2Bundle message, X2 header included, in bytes; the "
+                   "messages of a longer bundle are split over several datagrams. "
+                   "At most the largest UDP payload, 65507 bytes.",
+                   UintegerValue (65507),
+                   MakeUintegerAccessor (&EpcX2::m_maxBundleSize),
+                   MakeUintegerChecker<uint32_t> (64, 65507))
+    .AddTraceSource ("X2cHandled",
+                     "An X2-C message has been handled: procedure code, message type "
+                     "and whether it came inside an X2 bundle",
+                     MakeTraceSourceAccessor (&EpcX2::m_x2cHandledTrace))
+    .AddTraceSource ("VmMigrationState",
+                     "A VM migration changed state: peer cell id, migration id and new state",
+                     MakeTraceSourceAccessor (&EpcX2::m_vmMigrationStateTrace))
+    .AddTraceSource ("VmChunkFetched",
+                     "A named VM chunk has been fetched: migration id and source "
+                     "(0: local cache, 1: gateway cache, 2: source eNB, 3: neighbor eNB)",
+                     MakeTraceSourceAccessor (&EpcX2::m_vmChunkFetchedTrace))
+    .AddTraceSource ("VmPlacement",
+                     "The placement engine chose where a VM lands: migration id, cell id "
+                     "and estimated response latency",
+                     MakeTraceSourceAccessor (&EpcX2::m_vmPlacementTrace))
+    .AddTraceSource ("X2QueueDepth",
+                     "A packet has been queued on or dequeued from the X2 link: cell id of "
+                     "the neighbor, traffic class (0: X2-C, 1: UE data, 2: VM chunks) and "
+                     "new depth of the class queue",
+                     MakeTraceSourceAccessor (&EpcX2::m_x2QueueDepthTrace))
+    .AddTraceSource ("X2QueueDelay",
+                     "A packet has been dequeued from the X2 link: cell id of the neighbor, "
+                     "traffic class and time spent in the queue",
+                     MakeTraceSourceAccessor (&EpcX2::m_x2QueueDelayTrace))
+    .AddTraceSource ("X2cSent",
+                     "An X2-C message has been sent, a bundle counting as one message: "
+                     "cell id of the neighbor and size in bytes",
+                     MakeTraceSourceAccessor (&EpcX2::m_x2cSentTrace))
+    .AddTraceSource ("X2SendFailed",
+                     "An X2 datagram was refused by the socket: cell id of the "
+                     "neighbor and size in bytes",
+                     MakeTraceSourceAccessor (&EpcX2::m_x2SendFailedTrace))
+    .AddTraceSource ("X2BundleDropped",
+                     "The rest of a malformed X2 bundle was dropped: cell id of the "
+                     "neighbor and bytes dropped",
+                     MakeTraceSourceAccessor (&EpcX2::m_x2BundleDroppedTrace))
+    .AddTraceSource ("ControllerSent",
+                     "A message has been sent to the controller: size in bytes",
+                     MakeTraceSourceAccessor (&EpcX2::m_controllerSentTrace))
+    .AddTraceSource ("IcnMessageReceived",
+                     "target: the ICN message of the controller for a handed over UE "
+                     "has been received: IMSI of the UE",
+                     MakeTraceSourceAccessor (&EpcX2::m_icnMessageTrace))
     ;
   return tid;
 }
@@ -154,451 +466,1968 @@ EpcX2::GetEpcX2SapProvider ()
 
 
 void
-EpcX2::AddX2Interface (uint16_t localCellId, Ipv4Address localX2Address, uint16_t remoteCellId, Ipv4Address remoteX2Address)
+EpcX2::AddX2Interface (uint16_t localCellId, Ipv4Address localX2Address, uint16_t remoteCellId, Ipv4Address remoteX2Address)
+{
+  if (x2FileDataSent.str ().empty ())
+    {
+      x2FileDataSent << m_simName <<  "_X2DataSent.csv";
+      x2FileDataRecv << m_simName <<  "_X2DataRecv.csv";
+      ccMsgFileSent << m_simName <<  "_ccMsgSent.csv";
+      ccMsgFileRecvSrc << m_simName <<  "_ccMsgRecvSrc.csv";
+      ccMsgFileRecvTrg << m_simName <<  "_ccMsgRecvTrg.csv";
+      ackFile << m_simName <<  "_ackFile.csv";
+      vmFileSent << m_simName << "_vmSent.csv";
+      vmFileRecv << m_simName << "_vmRecv.csv";
+    }
+
+
+  NS_LOG_FUNCTION (this << localCellId << localX2Address << remoteCellId << remoteX2Address);
+
+  m_localCellId = localCellId;
+
+  int retval;
+
+  // Get local eNB where this X2 entity belongs to
+  Ptr<Node> localEnb = GetObject<Node> ();
+
+  if (m_sharedSockets)
+    {
+      // One X2-C and one X2-U socket for all the neighbors, the peer is
+      // identified by the source address of the received packets
+      if (m_sharedX2cSocket == 0)
+        {
+          m_sharedX2cSocket = Socket::CreateSocket (localEnb, TypeId::LookupByName ("ns3::UdpSocketFactory"));
+          retval = m_sharedX2cSocket->Bind (InetSocketAddress (localX2Address, m_x2cUdpPort));
+          NS_ASSERT (retval == 0);
+          m_sharedX2cSocket->SetRecvCallback (MakeCallback (&EpcX2::RecvFromX2cSocket, this));
+
+          m_sharedX2uSocket = Socket::CreateSocket (localEnb, TypeId::LookupByName ("ns3::UdpSocketFactory"));
+          retval = m_sharedX2uSocket->Bind (InetSocketAddress (localX2Address, m_x2uUdpPort));
+          NS_ASSERT (retval == 0);
+          m_sharedX2uSocket->SetRecvCallback (MakeCallback (&EpcX2::RecvFromX2uSocket, this));
+        }
+
+      NS_ASSERT_MSG (m_x2InterfaceSockets.find (remoteCellId) == m_x2InterfaceSockets.end (),
+                     "Mapping for remoteCellId = " << remoteCellId << " is already known");
+      m_x2InterfaceSockets [remoteCellId] = Create<X2IfaceInfo> (remoteX2Address, m_sharedX2cSocket, m_sharedX2uSocket);
+
+      NS_ASSERT_MSG (m_x2InterfaceCellIdsByAddr.find (remoteX2Address) == m_x2InterfaceCellIdsByAddr.end (),
+                     "Mapping for remote address = " << remoteX2Address << " is already known");
+      m_x2InterfaceCellIdsByAddr [remoteX2Address] = Create<X2CellInfo> (localCellId, remoteCellId);
+      return;
+    }
+
+  // Create X2-C socket for the local eNB
+  Ptr<Socket> localX2cSocket = Socket::CreateSocket (localEnb, TypeId::LookupByName ("ns3::UdpSocketFactory"));
+  retval = localX2cSocket->Bind (InetSocketAddress (localX2Address, m_x2cUdpPort));
+  NS_ASSERT (retval == 0);
+  localX2cSocket->SetRecvCallback (MakeCallback (&EpcX2::RecvFromX2cSocket, this));
+
+  // Create X2-U socket for the local eNB
+  Ptr<Socket> localX2uSocket = Socket::CreateSocket (localEnb, TypeId::LookupByName ("ns3::UdpSocketFactory"));
+  retval = localX2uSocket->Bind (InetSocketAddress (localX2Address, m_x2uUdpPort));
+  NS_ASSERT (retval == 0);
+  localX2uSocket->SetRecvCallback (MakeCallback (&EpcX2::RecvFromX2uSocket, this));
+
+
+  NS_ASSERT_MSG (m_x2InterfaceSockets.find (remoteCellId) == m_x2InterfaceSockets.end (),
+                 "Mapping for remoteCellId = " << remoteCellId << " is already known");
+  m_x2InterfaceSockets [remoteCellId] = Create<X2IfaceInfo> (remoteX2Address, localX2cSocket, localX2uSocket);
+
+  NS_ASSERT_MSG (m_x2InterfaceCellIds.find (localX2cSocket) == m_x2InterfaceCellIds.end (),
+                 "Mapping for control plane localSocket = " << localX2cSocket << " is already known");
+  m_x2InterfaceCellIds [localX2cSocket] = Create<X2CellInfo> (localCellId, remoteCellId);
+
+  NS_ASSERT_MSG (m_x2InterfaceCellIds.find (localX2uSocket) == m_x2InterfaceCellIds.end (),
+                 "Mapping for data plane localSocket = " << localX2uSocket << " is already known");
+  m_x2InterfaceCellIds [localX2uSocket] = Create<X2CellInfo> (localCellId, remoteCellId);
+}
+
+void
+EpcX2::RemoveX2Interface (uint16_t remoteCellId)
+{
+  NS_LOG_FUNCTION (this << remoteCellId);
+
+  std::map < uint16_t, Ptr<X2IfaceInfo> >::iterator it = m_x2InterfaceSockets.find (remoteCellId);
+  NS_ASSERT_MSG (it != m_x2InterfaceSockets.end (),
+                 "Missing infos for remoteCellId = " << remoteCellId);
+  Ptr<X2IfaceInfo> socketInfo = it->second;
+
+  if (m_sharedSockets)
+    {
+      // the shared sockets stay open for the remaining neighbors
+      m_x2InterfaceCellIdsByAddr.erase (socketInfo->m_remoteIpAddr);
+    }
+  else
+    {
+      m_x2InterfaceCellIds.erase (socketInfo->m_localCtrlPlaneSocket);
+      m_x2InterfaceCellIds.erase (socketInfo->m_localUserPlaneSocket);
+      socketInfo->m_localCtrlPlaneSocket->Close ();
+      socketInfo->m_localUserPlaneSocket->Close ();
+    }
+  m_x2InterfaceSockets.erase (it);
+  m_vmLinkFreeTime.erase (remoteCellId);
+
+  std::map<uint16_t, X2LinkQueue>::iterator linkIt = m_x2LinkQueues.find (remoteCellId);
+  if (linkIt != m_x2LinkQueues.end ())
+    {
+      linkIt->second.m_serveEvent.Cancel ();
+      m_x2LinkQueues.erase (linkIt);
+    }
+}
+
+bool
+EpcX2::HasX2Interface (uint16_t remoteCellId) const
+{
+  return m_x2InterfaceSockets.find (remoteCellId) != m_x2InterfaceSockets.end ();
+}
+
+Time
+EpcX2::GetX2InterfaceLastUse (uint16_t remoteCellId) const
+{
+  std::map < uint16_t, Ptr<X2IfaceInfo> >::const_iterator it = m_x2InterfaceSockets.find (remoteCellId);
+  NS_ASSERT_MSG (it != m_x2InterfaceSockets.end (),
+                 "Missing infos for remoteCellId = " << remoteCellId);
+  return it->second->m_lastUse;
+}
+
+void
+EpcX2::SetX2InterfaceRequestCallback (X2InterfaceRequestCallback cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_x2InterfaceRequestCallback = cb;
+}
+
+Ptr<X2CellInfo>
+EpcX2::GetX2CellInfo (Ptr<Socket> socket, const Address &from)
+{
+  if (m_sharedSockets)
+    {
+      X2CellInfoByAddrMap_t::iterator it = m_x2InterfaceCellIdsByAddr.find (InetSocketAddress::ConvertFrom (from).GetIpv4 ());
+      if (it != m_x2InterfaceCellIdsByAddr.end ())
+        {
+          return it->second;
+        }
+      return 0;
+    }
+  std::map < Ptr<Socket>, Ptr<X2CellInfo> >::iterator it = m_x2InterfaceCellIds.find (socket);
+  if (it != m_x2InterfaceCellIds.end ())
+    {
+      return it->second;
+    }
+  return 0;
+}
+
+void
+EpcX2::SendOverX2 (uint16_t cellId, Ptr<Socket> socket, Ipv4Address address, uint16_t port,
+                   Ptr<Packet> packet, X2TrafficClass_t trafficClass)
+{
+  NS_LOG_FUNCTION (this << cellId << packet << trafficClass);
+
+  if (trafficClass == X2_CLASS_CONTROL)
+    {
+      std::map<uint16_t, X2Bundle>::iterator bundleIt = m_x2Bundles.find (cellId);
+      if (bundleIt != m_x2Bundles.end () && bundleIt->second.m_depth > 0)
+        {
+          NS_ASSERT (port == m_x2cUdpPort);
+          bundleIt->second.m_messages.push_back (packet);
+          bundleIt->second.m_socket = socket;
+          bundleIt->second.m_address = address;
+          return;
+        }
+      ++m_x2cMessagesSent;
+      m_x2cBytesSent += packet->GetSize ();
+      m_x2cSentTrace (cellId, packet->GetSize ());
+    }
+
+  if (m_x2Scheduler == X2_SCHED_NONE)
+    {
+      SendX2Datagram (cellId, socket, address, port, packet);
+      return;
+    }
+
+  X2QueueItem item;
+  item.m_packet = packet;
+  item.m_socket = socket;
+  item.m_address = address;
+  item.m_port = port;
+  item.m_enqueueTime = Simulator::Now ();
+
+  X2LinkQueue &link = m_x2LinkQueues[cellId];
+  link.m_queues[trafficClass].push_back (item);
+  m_x2QueueDepthTrace (cellId, trafficClass, link.m_queues[trafficClass].size ());
+
+  if (!link.m_busy)
+    {
+      ServeX2Link (cellId);
+    }
+}
+
+int32_t
+EpcX2::SelectX2Class (X2LinkQueue &link)
+{
+  bool backlogged = false;
+  for (uint8_t c = 0; c < X2_N_CLASSES; ++c)
+    {
+      if (!link.m_queues[c].empty ())
+        {
+          backlogged = true;
+          if (m_x2Scheduler == X2_SCHED_PRIORITY)
+            {
+              return c;
+            }
+        }
+    }
+  if (!backlogged)
+    {
+      return -1;
+    }
+
+  // deficit round robin: a class keeps the link while its deficit covers
+  // the packet at the head of its queue, and earns its quantum when its
+  // turn comes again
+  const uint32_t quantum[X2_N_CLASSES] = { m_x2ControlQuantum, m_x2UeDataQuantum, m_x2BulkQuantum };
+  while (true)
+    {
+      uint8_t c = link.m_drrClass;
+      if (link.m_queues[c].empty ())
+        {
+          link.m_deficit[c] = 0;
+        }
+      else
+        {
+          uint32_t size = link.m_queues[c].front ().m_packet->GetSize ();
+          if (link.m_deficit[c] >= size)
+            {
+              link.m_deficit[c] -= size;
+              return c;
+            }
+        }
+      link.m_drrClass = (c + 1) % X2_N_CLASSES;
+      if (!link.m_queues[link.m_drrClass].empty ())
+        {
+          link.m_deficit[link.m_drrClass] += quantum[link.m_drrClass];
+        }
+    }
+}
+
+void
+EpcX2::ServeX2Link (uint16_t cellId)
+{
+  std::map<uint16_t, X2LinkQueue>::iterator linkIt = m_x2LinkQueues.find (cellId);
+  if (linkIt == m_x2LinkQueues.end ())
+    {
+      return;
+    }
+  X2LinkQueue &link = linkIt->second;
+
+  int32_t c = SelectX2Class (link);
+  if (c < 0)
+    {
+      link.m_busy = false;
+      return;
+    }
+
+  X2QueueItem item = link.m_queues[c].front ();
+  link.m_queues[c].pop_front ();
+  m_x2QueueDepthTrace (cellId, c, link.m_queues[c].size ());
+  m_x2QueueDelayTrace (cellId, c, Simulator::Now () - item.m_enqueueTime);
+
+  uint32_t size = item.m_packet->GetSize ();
+  SendX2Datagram (cellId, item.m_socket, item.m_address, item.m_port, item.m_packet);
+  link.m_busy = true;
+
+  if (c == X2_CLASS_BULK && link.m_queues[X2_CLASS_BULK].empty ())
+    {
+      // the VM transfers towards this cell queue their next chunks
+      SendVm (cellId);
+      SendVmChunk (cellId);
+    }
+
+  // the link is busy for the transmission time, UDP/IP header included
+  Time txTime = Seconds (m_x2LinkDataRate.CalculateTxTime (size + 28));
+  link.m_serveEvent = Simulator::Schedule (txTime, &EpcX2::ServeX2Link, this, cellId);
+}
+
+void
+EpcX2::BeginX2Bundle (uint16_t cellId)
+{
+  NS_LOG_FUNCTION (this << cellId);
+  ++m_x2Bundles[cellId].m_depth;
+}
+
+void
+EpcX2::EndX2Bundle (uint16_t cellId)
+{
+  NS_LOG_FUNCTION (this << cellId);
+
+  std::map<uint16_t, X2Bundle>::iterator it = m_x2Bundles.find (cellId);
+  NS_ASSERT_MSG (it != m_x2Bundles.end () && it->second.m_depth > 0,
+                 "No X2 bundle open towards cellId = " << cellId);
+  if (--it->second.m_depth > 0)
+    {
+      return;
+    }
+  X2Bundle bundle = it->second;
+  m_x2Bundles.erase (it);
+
+  NS_LOG_INFO ("Send X2 message: X2 BUNDLE of " << bundle.m_messages.size () << " messages");
+
+  // a new datagram is started when the next message would not fit
+  EpcX2Header x2Header;
+  uint32_t datagramSize = x2Header.GetSerializedSize ();
+  std::list<Ptr<Packet> > datagram;
+  for (std::list<Ptr<Packet> >::iterator msgIt = bundle.m_messages.begin ();
+       msgIt != bundle.m_messages.end (); ++msgIt)
+    {
+      uint32_t size = 2 + (*msgIt)->GetSize ();
+      if (!datagram.empty () && datagramSize + size > m_maxBundleSize)
+        {
+          SendX2BundleDatagram (cellId, bundle.m_socket, bundle.m_address, datagram);
+          datagram.clear ();
+          datagramSize = x2Header.GetSerializedSize ();
+        }
+      datagram.push_back (*msgIt);
+      datagramSize += size;
+    }
+  if (!datagram.empty ())
+    {
+      SendX2BundleDatagram (cellId, bundle.m_socket, bundle.m_address, datagram);
+    }
+
+  if (bundle.m_handovers.empty ())
+    {
+      return;
+    }
+
+  NS_LOG_INFO ("Target eNodeB Sends Client Info of " << bundle.m_handovers.size () << " UEs to VCP node");
+
+  if (bundle.m_handovers.size () == 1)
+    {
+      SendToController (bundle.m_socket, CreateControllerNotification (cellId, bundle.m_handovers, 13));
+    }
+  else
+    {
+      // the usual notification, the number of UEs in its first two bytes
+      Ptr<Packet> packetPit = CreateControllerNotification (cellId, bundle.m_handovers, 13);
+
+      EpcX2Header x2Header;
+      x2Header.SetMessageType (EpcX2Header::X2Bundle);
+      x2Header.SetProcedureCode (EpcX2Header::HandoverPreparation);
+      x2Header.SetLengthOfIes (1);
+      x2Header.SetNumberOfIes (1);
+      packetPit->AddHeader (x2Header);
+
+      SendToController (bundle.m_socket, packetPit);
+    }
+
+  ofstream out ((ccMsgFileSent.str ()).c_str (), ios::app);
+  out << Simulator::Now ().GetSeconds () << "\n";
+}
+
+void
+EpcX2::SendX2BundleDatagram (uint16_t cellId, Ptr<Socket> socket, Ipv4Address address,
+                             const std::list<Ptr<Packet> > &messages)
+{
+  if (messages.size () == 1)
+    {
+      SendOverX2 (cellId, socket, address, m_x2cUdpPort, messages.front (), X2_CLASS_CONTROL);
+      return;
+    }
+
+  // each message, X2 header included, is preceded by its length
+  Ptr<Packet> packet = Create<Packet> ();
+  for (std::list<Ptr<Packet> >::const_iterator msgIt = messages.begin ();
+       msgIt != messages.end (); ++msgIt)
+    {
+      uint32_t size = (*msgIt)->GetSize ();
+      NS_ASSERT_MSG (size <= 0xffff, "X2-C message too large to be bundled");
+      uint8_t length[2];
+      length[0] = size >> 8;
+      length[1] = size & 0xff;
+      packet->AddAtEnd (Create<Packet> (length, 2));
+      packet->AddAtEnd (*msgIt);
+    }
+
+  EpcX2Header x2Header;
+  x2Header.SetMessageType (EpcX2Header::X2Bundle);
+  x2Header.SetProcedureCode (EpcX2Header::HandoverPreparation);
+  x2Header.SetLengthOfIes (1);
+  x2Header.SetNumberOfIes (1);
+  packet->AddHeader (x2Header);
+
+  SendOverX2 (cellId, socket, address, m_x2cUdpPort, packet, X2_CLASS_CONTROL);
+}
+
+void
+EpcX2::SendX2Datagram (uint16_t cellId, Ptr<Socket> socket, Ipv4Address address, uint16_t port,
+                       Ptr<Packet> packet)
+{
+  if (socket->SendTo (packet, 0, InetSocketAddress (address, port)) < 0)
+    {
+      NS_LOG_WARN ("X2 datagram of " << packet->GetSize () << " bytes to cell " << cellId
+                   << " refused by the socket, error " << socket->GetErrno ());
+      ++m_x2SendFailures;
+      m_x2SendFailedTrace (cellId, packet->GetSize ());
+    }
+}
+
+void
+EpcX2::SendToController (Ptr<Socket> socket, Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  ++m_controllerMessagesSent;
+  m_controllerBytesSent += packet->GetSize ();
+  m_controllerSentTrace (packet->GetSize ());
+  socket->SendTo (packet, 0, InetSocketAddress (m_controllerAddress, m_x2cUdpPort));
+}
+
+Ptr<Packet>
+EpcX2::CreateControllerNotification (uint16_t sourceCellId, const std::list<uint16_t> &ueIds, uint32_t size)
+{
+  // the controller reaches the source eNB at its address on the X2 link
+  // it shares with this eNB, as it reaches this eNB at the sender address
+  std::map<uint16_t, Ptr<X2IfaceInfo> >::iterator ifaceIt = m_x2InterfaceSockets.find (sourceCellId);
+  NS_ASSERT_MSG (ifaceIt != m_x2InterfaceSockets.end (), "Missing X2 interface for cellId = " << sourceCellId);
+
+  uint32_t length = 10 + 2 * ueIds.size ();
+  std::vector<uint8_t> buf (std::max (size, length), 0);
+  if (ueIds.size () > 1)
+    {
+      buf[0] = ueIds.size () >> 8;
+      buf[1] = ueIds.size () & 0xff;
+    }
+  buf[2] = sourceCellId >> 8;
+  buf[3] = sourceCellId & 0xff;
+  buf[4] = m_localCellId >> 8;
+  buf[5] = m_localCellId & 0xff;
+  ifaceIt->second->m_remoteIpAddr.Serialize (&buf[6]);
+  uint32_t i = 10;
+  for (std::list<uint16_t>::const_iterator it = ueIds.begin (); it != ueIds.end (); ++it)
+    {
+      buf[i++] = *it >> 8;
+      buf[i++] = *it & 0xff;
+    }
+  return Create<Packet> (&buf[0], buf.size ());
+}
+
+Ptr<Packet>
+EpcX2::CreateVmControllerReport (Ptr<VmMigrationInfo> migration)
+{
+  uint16_t targetCellId = (migration->m_handoverCellId != 0) ? migration->m_handoverCellId : m_localCellId;
+  uint8_t buf[6];
+  buf[0] = migration->m_peerCellId >> 8;
+  buf[1] = migration->m_peerCellId & 0xff;
+  buf[2] = targetCellId >> 8;
+  buf[3] = targetCellId & 0xff;
+  buf[4] = migration->m_migrationId >> 8;
+  buf[5] = migration->m_migrationId & 0xff;
+  Ptr<Packet> packet = Create<Packet> (buf, 6);
+
+  EpcX2Header x2Header;
+  x2Header.SetMessageType (EpcX2Header::VmReport);
+  x2Header.SetProcedureCode (EpcX2Header::HandoverPreparation);
+  x2Header.SetLengthOfIes (3);
+  x2Header.SetNumberOfIes (3);
+  packet->AddHeader (x2Header);
+  return packet;
+}
+
+void EpcX2::GetEpcEnbApplication (Ptr<EpcEnbApplication> enb)  // new
+{
+    epcEnbApp = enb;
+    epcEnbApp->SetCsMigrationCallback (MakeCallback (&EpcX2::SendCsEntry, this));
+    epcEnbApp->SetVmChunkCallback (MakeCallback (&EpcX2::RecvVmChunkFromGateway, this));
+}
+
+void
+EpcX2::SendCsEntry (uint16_t targetCellId, CsEps_t cs)
+{
+  NS_LOG_FUNCTION (this << targetCellId);
+
+  NS_ASSERT_MSG (m_x2InterfaceSockets.find (targetCellId) != m_x2InterfaceSockets.end (),
+                 "Missing infos for targetCellId in CS migration = " << targetCellId);
+  Ptr<X2IfaceInfo> socketInfo = m_x2InterfaceSockets [targetCellId];
+  Ptr<Socket> sourceSocket    = socketInfo->m_localCtrlPlaneSocket;
+  Ipv4Address targetIpAddr    = socketInfo->m_remoteIpAddr;
+
+  EpcX2Header x2Header;
+  x2Header.SetMessageType (EpcX2Header::CsMigration);
+  x2Header.SetProcedureCode (EpcX2Header::HandoverPreparation);
+  x2Header.SetLengthOfIes (3);
+  x2Header.SetNumberOfIes (3);
+
+  Ptr<Packet> packet = cs.m_content->Copy ();
+  packet->AddHeader (*(cs.m_contentHeader));
+  packet->AddHeader (cs.m_udpHeader);
+  packet->AddHeader (cs.m_ipHeader);
+  packet->AddHeader (x2Header);
+
+  NS_LOG_INFO ("Send X2 message: CS MIGRATION " << cs.m_contentHeader->GetName ());
+  SendOverX2 (targetCellId, sourceSocket, targetIpAddr, m_x2cUdpPort, packet, X2_CLASS_UE_DATA);
+}
+
+void
+EpcX2::StartVmTransfer (uint16_t targetCellId, uint16_t migrationId)
+{
+  NS_LOG_FUNCTION (this << targetCellId << migrationId);
+
+  std::list<Ptr<VmMigrationInfo> > &transfers = m_vmTransfersOut[targetCellId];
+  for (std::list<Ptr<VmMigrationInfo> >::iterator it = transfers.begin (); it != transfers.end (); ++it)
+    {
+      if ((*it)->m_migrationId == migrationId)
+        {
+          NS_LOG_WARN ("VM migration " << migrationId << " to cell " << targetCellId << " already in progress");
+          return;
+        }
+    }
+
+  Ptr<VmMigrationInfo> migration = Create<VmMigrationInfo> (targetCellId, migrationId);
+  bool linkIdle = transfers.empty ();
+  transfers.push_back (migration);
+  NS_LOG_INFO ("VM migration " << migrationId << " to cell " << targetCellId << " queued, "
+               << transfers.size () << " migrations sharing the X2 link");
+
+  if (linkIdle)
+    {
+      // the previous chunk may still be on the link
+      Time delay = Seconds (0);
+      std::map<uint16_t, Time>::iterator freeIt = m_vmLinkFreeTime.find (targetCellId);
+      if (freeIt != m_vmLinkFreeTime.end () && freeIt->second > Simulator::Now ())
+        {
+          delay = freeIt->second - Simulator::Now ();
+        }
+      Simulator::Schedule (delay, &EpcX2::SendVm, this, targetCellId);
+    }
+}
+
+void
+EpcX2::SendVm (uint16_t targetCellId)
+{
+  std::map<uint16_t, std::list<Ptr<VmMigrationInfo> > >::iterator linkIt = m_vmTransfersOut.find (targetCellId);
+  if (linkIt == m_vmTransfersOut.end () || linkIt->second.empty ())
+    {
+      return;
+    }
+
+  NS_ASSERT_MSG (m_x2InterfaceSockets.find (targetCellId) != m_x2InterfaceSockets.end (),
+                 "Missing infos for targetCellId in VM migration = " << targetCellId);
+  Ptr<X2IfaceInfo> socketInfo = m_x2InterfaceSockets [targetCellId];
+  Ptr<Socket> sourceSocket    = socketInfo->m_localUserPlaneSocket;
+  Ipv4Address targetIpAddr    = socketInfo->m_remoteIpAddr;
+  socketInfo->m_lastUse = Simulator::Now ();
+
+  // the migrations sharing the X2 link are served in round robin
+  Ptr<VmMigrationInfo> migration = linkIt->second.front ();
+  linkIt->second.pop_front ();
+
+  if (migration->m_chunks == 0)
+    {
+      ofstream out ((vmFileSent.str ()).c_str (), ios::app);
+      out << Simulator::Now ().GetSeconds () << "\n";
+      migration->m_startTime = Simulator::Now ();
+      SetVmMigrationState (migration, VmMigrationInfo::SENDING);
+    }
+
+  uint32_t teid = VM_TEID_PREFIX | migration->m_migrationId;
+
+  GtpuHeader gtpu;
+  gtpu.SetTeid (teid);
+  gtpu.SetLength (m_vmChunkSize + gtpu.GetSerializedSize () - 8);
+
+  Ptr<Packet> packet = Create<Packet> (m_vmChunkSize);
+  packet->AddHeader (gtpu);
+
+  SendOverX2 (targetCellId, sourceSocket, targetIpAddr, m_x2uUdpPort, packet, X2_CLASS_BULK);
+  ++migration->m_chunks;
+
+  if (migration->m_chunks < m_numOfPacket)
+    {
+      linkIt->second.push_back (migration);
+    }
+  else
+    {
+      NS_LOG_INFO ("TOTAL VM CHUNKS SENT: " << migration->m_chunks << " for migration "
+                   << migration->m_migrationId << " to cell " << targetCellId);
+      SetVmMigrationState (migration, VmMigrationInfo::SENT);
+      if (m_vmHosted > 0)
+        {
+          --m_vmHosted;
+        }
+    }
+
+  if (m_x2Scheduler != X2_SCHED_NONE)
+    {
+      // the X2 link scheduler asks for the next chunk
+      return;
+    }
+
+  // pace the chunks at the X2 link rate, UDP/IP header included
+  Time txTime = Seconds (m_x2LinkDataRate.CalculateTxTime (m_vmChunkSize + 28));
+  m_vmLinkFreeTime[targetCellId] = Simulator::Now () + txTime;
+  if (!linkIt->second.empty ())
+    {
+      Simulator::Schedule (txTime, &EpcX2::SendVm, this, targetCellId);
+    }
+}
+
+Ptr<VmMigrationInfo>
+EpcX2::FindVmMigrationIn (VmMigrationInfo::State_t state)
+{
+  for (std::list<Ptr<VmMigrationInfo> >::iterator it = m_vmMigrationsInFifo.begin (); it != m_vmMigrationsInFifo.end (); ++it)
+    {
+      if ((*it)->m_state == state)
+        {
+          return *it;
+        }
+    }
+  return 0;
+}
+
+Ptr<VmMigrationInfo>
+EpcX2::FindVmMigrationIn (Ptr<Packet> packet, VmMigrationInfo::State_t state)
+{
+  if (packet->GetSize () >= 4)
+    {
+      uint8_t buf[4];
+      packet->CopyData (buf, 4);
+      uint32_t key = ((uint32_t) buf[0] << 24) | ((uint32_t) buf[1] << 16) | ((uint32_t) buf[2] << 8) | buf[3];
+      std::map<uint32_t, Ptr<VmMigrationInfo> >::iterator it = m_vmMigrationsIn.find (key);
+      if (it != m_vmMigrationsIn.end () && it->second->m_state == state)
+        {
+          return it->second;
+        }
+    }
+  return FindVmMigrationIn (state);
+}
+
+void
+EpcX2::SetVmMigrationState (Ptr<VmMigrationInfo> migration, VmMigrationInfo::State_t state)
+{
+  NS_LOG_LOGIC ("VM migration " << migration->m_migrationId << " with cell " << migration->m_peerCellId
+                << ": state " << (uint32_t) migration->m_state << " -> " << (uint32_t) state);
+  migration->m_state = state;
+  m_vmMigrationStateTrace (migration->m_peerCellId, migration->m_migrationId, (uint8_t) state);
+}
+
+void
+EpcX2::VmMigrationReceived (Ptr<VmMigrationInfo> migration)
+{
+  NS_LOG_FUNCTION (this << migration->m_peerCellId << migration->m_migrationId);
+
+  ofstream outvm ((vmFileRecv.str ()).c_str (), ios::app);
+  outvm << Simulator::Now ().GetSeconds () << "\n";
+  NS_LOG_INFO ("ALL CHUNKS OF VM HAS BEEN RECEIVED BY TARGET ENB");
+  NS_LOG_INFO ("NUMBER OF CHUNKS: " << migration->m_chunks);
+
+  NS_ASSERT_MSG (m_x2InterfaceSockets.find (migration->m_peerCellId) != m_x2InterfaceSockets.end (),
+                 "Missing infos for Migration Completed = " << migration->m_peerCellId);
+  Ptr<X2IfaceInfo> socketInfo = m_x2InterfaceSockets [migration->m_peerCellId];
+  Ptr<Socket> sourceSocket = socketInfo->m_localCtrlPlaneSocket;
+
+  Ptr<Packet> vmMigCompleted = CreateVmControllerReport (migration);
+
+  NS_LOG_INFO ("INFORM VCP THAT VM HAS BEEN MIGRATED SUCCESSFULLY");
+
+  SendToController (sourceSocket, vmMigCompleted);
+  SetVmMigrationState (migration, VmMigrationInfo::RECEIVED);
+}
+
+ns3::ndn::Name
+EpcX2::GetVmChunkName (Ptr<VmMigrationInfo> migration, uint32_t chunk) const
+{
+  ns3::ndn::Name name;
+  name ("vm") (m_vmImageName);
+  if (chunk >= m_vmSharedChunks)
+    {
+      std::ostringstream vmId;
+      vmId << migration->m_peerCellId << "-" << migration->m_migrationId;
+      name (vmId.str ());
+    }
+  name (chunk);
+  return name;
+}
+
+EpcX2::VmChunkSourceInfo &
+EpcX2::GetVmChunkSource (uint16_t sourceId)
+{
+  std::map<uint16_t, VmChunkSourceInfo>::iterator it = m_vmChunkSources.find (sourceId);
+  if (it == m_vmChunkSources.end ())
+    {
+      // until measured, every source is assumed to deliver at the X2 link rate
+      VmChunkSourceInfo info;
+      info.m_interval = Seconds (m_x2LinkDataRate.CalculateTxTime (m_vmChunkSize + 28));
+      it = m_vmChunkSources.insert (std::make_pair (sourceId, info)).first;
+    }
+  return it->second;
+}
+
+int32_t
+EpcX2::SelectVmChunkSource (Ptr<VmMigrationInfo> migration, uint32_t chunk)
+{
+  std::vector<uint16_t> candidates;
+  if (chunk >= m_vmSharedChunks)
+    {
+      // only the source eNB has the chunks unique to the VM
+      candidates.push_back (migration->m_peerCellId);
+    }
+  else if (!m_vmMultiSource)
+    {
+      candidates.push_back (m_vmGatewayCache ? VM_CHUNK_GATEWAY_ID : migration->m_peerCellId);
+    }
+  else
+    {
+      for (std::map < uint16_t, Ptr<X2IfaceInfo> >::iterator it = m_x2InterfaceSockets.begin (); it != m_x2InterfaceSockets.end (); ++it)
+        {
+          candidates.push_back (it->first);
+        }
+      if (m_vmGatewayCache)
+        {
+          candidates.push_back (VM_CHUNK_GATEWAY_ID);
+        }
+    }
+
+  // earliest expected delivery, given the chunks already queued at each source
+  int32_t best = -1;
+  double bestFinish = 0;
+  for (std::vector<uint16_t>::iterator it = candidates.begin (); it != candidates.end (); ++it)
+    {
+      VmChunkSourceInfo &info = GetVmChunkSource (*it);
+      if (info.m_outstanding >= m_vmFetchWindow)
+        {
+          continue;
+        }
+      double finish = (info.m_outstanding + 1) * info.m_interval.GetSeconds ();
+      if (best < 0 || finish < bestFinish)
+        {
+          best = *it;
+          bestFinish = finish;
+        }
+    }
+  return best;
+}
+
+void
+EpcX2::RequestVmChunks (Ptr<VmMigrationInfo> migration)
+{
+  NS_LOG_FUNCTION (this << migration->m_peerCellId << migration->m_migrationId);
+
+  if (migration->m_state != VmMigrationInfo::REQUESTED && migration->m_state != VmMigrationInfo::RECEIVING)
+    {
+      return;
+    }
+
+  while (migration->m_nextChunk < m_numOfPacket)
+    {
+      uint32_t chunk = migration->m_nextChunk;
+      ns3::ndn::Name name = GetVmChunkName (migration, chunk);
+
+      if (epcEnbApp->HasContent (name))
+        {
+          // the first chunk starts the reception, wherever it comes from
+          if (migration->m_chunks == 0)
+            {
+              SetVmMigrationState (migration, VmMigrationInfo::RECEIVING);
+            }
+          ++migration->m_nextChunk;
+          ++migration->m_chunks;
+          m_vmChunkFetchedTrace (migration->m_migrationId, VM_CHUNK_LOCAL_CACHE);
+          continue;
+        }
+
+      std::map<ns3::ndn::Name, VmChunkPitEntry_t>::iterator pitIt = m_vmChunkPit.find (name);
+      if (pitIt != m_vmChunkPit.end ())
+        {
+          // already requested for another migration of the same image
+          ++migration->m_nextChunk;
+          ++migration->m_outstanding;
+          pitIt->second.m_migrations.push_back (migration);
+          continue;
+        }
+
+      int32_t sourceId = SelectVmChunkSource (migration, chunk);
+      if (sourceId < 0)
+        {
+          // all the sources are busy, resumed when one of them delivers
+          break;
+        }
+      ++migration->m_nextChunk;
+      ++migration->m_outstanding;
+      VmChunkPitEntry_t &entry = m_vmChunkPit[name];
+      entry.m_migrations.push_back (migration);
+      entry.m_producer = migration->m_peerCellId;
+      SendVmChunkRequest (name, sourceId);
+    }
+
+  if (migration->m_chunks == m_numOfPacket)
+    {
+      VmMigrationReceived (migration);
+    }
+}
+
+void
+EpcX2::PumpVmChunkRequests ()
+{
+  for (std::list<Ptr<VmMigrationInfo> >::iterator it = m_vmMigrationsInFifo.begin (); it != m_vmMigrationsInFifo.end (); ++it)
+    {
+      RequestVmChunks (*it);
+    }
+}
+
+void
+EpcX2::SendVmChunkRequest (ns3::ndn::Name name, uint16_t sourceId)
+{
+  NS_LOG_FUNCTION (this << name << sourceId);
+
+  VmChunkPitEntry_t &entry = m_vmChunkPit[name];
+  entry.m_source = sourceId;
+  entry.m_sentTime = Simulator::Now ();
+  ++GetVmChunkSource (sourceId).m_outstanding;
+
+  if (sourceId == VM_CHUNK_GATEWAY_ID)
+    {
+      ns3::ndn::Interest interestHeader;
+      interestHeader.SetName (Create<ns3::ndn::Name> (name));
+      Ptr<Packet> interest = Create<Packet> ();
+      interest->AddHeader (interestHeader);
+      epcEnbApp->SendVmChunkToGateway (VM_CHUNK_INTEREST_TEID, interest);
+    }
+  else
+    {
+      SendVmChunkInterest (sourceId, name, sourceId != entry.m_producer);
+    }
+}
+
+void
+EpcX2::SendVmChunkInterest (uint16_t peerCellId, ns3::ndn::Name name, bool cacheOnly)
+{
+  NS_LOG_FUNCTION (this << peerCellId << name << cacheOnly);
+
+  NS_ASSERT_MSG (m_x2InterfaceSockets.find (peerCellId) != m_x2InterfaceSockets.end (),
+                 "Missing infos for VM chunk Interest = " << peerCellId);
+  Ptr<X2IfaceInfo> socketInfo = m_x2InterfaceSockets [peerCellId];
+
+  ns3::ndn::Interest interestHeader;
+  interestHeader.SetName (Create<ns3::ndn::Name> (name));
+
+  EpcX2Header x2Header;
+  x2Header.SetMessageType (cacheOnly ? EpcX2Header::InterestVmChunkCache : EpcX2Header::InterestVmChunk);
+  x2Header.SetProcedureCode (EpcX2Header::HandoverPreparation);
+  x2Header.SetLengthOfIes (1);
+  x2Header.SetNumberOfIes (1);
+
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (interestHeader);
+  packet->AddHeader (x2Header);
+
+  SendOverX2 (peerCellId, socketInfo->m_localCtrlPlaneSocket, socketInfo->m_remoteIpAddr, m_x2cUdpPort,
+              packet, X2_CLASS_CONTROL);
+}
+
+void
+EpcX2::QueueVmChunk (uint16_t targetCellId, ns3::ndn::Name name)
+{
+  std::list<ns3::ndn::Name> &requests = m_vmChunkRequestsOut[targetCellId];
+  bool linkIdle = requests.empty ();
+  requests.push_back (name);
+
+  if (linkIdle)
+    {
+      Time delay = Seconds (0);
+      std::map<uint16_t, Time>::iterator freeIt = m_vmLinkFreeTime.find (targetCellId);
+      if (freeIt != m_vmLinkFreeTime.end () && freeIt->second > Simulator::Now ())
+        {
+          delay = freeIt->second - Simulator::Now ();
+        }
+      Simulator::Schedule (delay, &EpcX2::SendVmChunk, this, targetCellId);
+    }
+}
+
+void
+EpcX2::SendVmChunk (uint16_t targetCellId)
+{
+  std::map<uint16_t, std::list<ns3::ndn::Name> >::iterator requestsIt = m_vmChunkRequestsOut.find (targetCellId);
+  if (requestsIt == m_vmChunkRequestsOut.end () || requestsIt->second.empty ())
+    {
+      return;
+    }
+
+  NS_ASSERT_MSG (m_x2InterfaceSockets.find (targetCellId) != m_x2InterfaceSockets.end (),
+                 "Missing infos for targetCellId in VM migration = " << targetCellId);
+  Ptr<X2IfaceInfo> socketInfo = m_x2InterfaceSockets [targetCellId];
+  socketInfo->m_lastUse = Simulator::Now ();
+
+  ns3::ndn::Name name = requestsIt->second.front ();
+  requestsIt->second.pop_front ();
+
+  // the chunks are produced by the source eNB, or served from the CS of a neighbor
+  ns3::ndn::ContentObject contentHeader;
+  contentHeader.SetName (Create<ns3::ndn::Name> (name));
+  Ptr<Packet> packet = Create<Packet> (m_vmChunkSize);
+  packet->AddHeader (contentHeader);
+
+  GtpuHeader gtpu;
+  gtpu.SetTeid (VM_CHUNK_CONTENT_TEID);
+  gtpu.SetLength (packet->GetSize () + gtpu.GetSerializedSize () - 8);
+  packet->AddHeader (gtpu);
+
+  NS_LOG_LOGIC ("Send VM chunk " << name << " to cell " << targetCellId);
+  uint32_t size = packet->GetSize ();
+  SendOverX2 (targetCellId, socketInfo->m_localUserPlaneSocket, socketInfo->m_remoteIpAddr, m_x2uUdpPort,
+              packet, X2_CLASS_BULK);
+  if (m_x2Scheduler != X2_SCHED_NONE)
+    {
+      return;
+    }
+
+  // the named chunks share the X2 link with the pushed VM migrations
+  Time txTime = Seconds (m_x2LinkDataRate.CalculateTxTime (size + 28));
+  m_vmLinkFreeTime[targetCellId] = Simulator::Now () + txTime;
+  if (!requestsIt->second.empty ())
+    {
+      Simulator::Schedule (txTime, &EpcX2::SendVmChunk, this, targetCellId);
+    }
+}
+
+void
+EpcX2::RecvVmChunk (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  CsEps_t cs;
+  cs.m_contentHeader = Create<ns3::ndn::ContentObject> ();
+  packet->RemoveHeader (*(cs.m_contentHeader));
+  cs.m_content = packet;
+  ns3::ndn::Name name = cs.m_contentHeader->GetName ();
+
+  std::map<ns3::ndn::Name, VmChunkPitEntry_t>::iterator pitIt = m_vmChunkPit.find (name);
+  if (pitIt == m_vmChunkPit.end ())
+    {
+      NS_LOG_WARN ("VM chunk " << name << " not requested, discarding packet");
+      return;
+    }
+  VmChunkPitEntry_t entry = pitIt->second;
+  m_vmChunkPit.erase (pitIt);
+
+  // delivery interval of the source: the time since its previous delivery,
+  // or since the request if it was idle
+  VmChunkSourceInfo &info = GetVmChunkSource (entry.m_source);
+  --info.m_outstanding;
+  ++info.m_chunks;
+  Time start = std::max (info.m_lastDelivery, entry.m_sentTime);
+  info.m_interval = Seconds ((7 * info.m_interval.GetSeconds () + (Simulator::Now () - start).GetSeconds ()) / 8);
+  info.m_lastDelivery = Simulator::Now ();
+
+  VmChunkSource_t source = VM_CHUNK_PEER;
+  if (entry.m_source == VM_CHUNK_GATEWAY_ID)
+    {
+      source = VM_CHUNK_GATEWAY_CACHE;
+    }
+  else if (entry.m_source != entry.m_producer)
+    {
+      source = VM_CHUNK_NEIGHBOR;
+    }
+
+  epcEnbApp->RecvMigratedContent (cs);
+  if (source != VM_CHUNK_GATEWAY_CACHE && m_vmGatewayCache && name.GetComponents ().size () == 3)
+    {
+      // base image chunk: let the next eNBs find it in the gateway cache
+      Ptr<Packet> publish = cs.m_content->Copy ();
+      publish->AddHeader (*(cs.m_contentHeader));
+      epcEnbApp->SendVmChunkToGateway (VM_CHUNK_CONTENT_TEID, publish);
+    }
+
+  for (std::list<Ptr<VmMigrationInfo> >::iterator it = entry.m_migrations.begin (); it != entry.m_migrations.end (); ++it)
+    {
+      VmChunkFetched (*it, source);
+    }
+  PumpVmChunkRequests ();
+}
+
+void
+EpcX2::RecvVmChunkNack (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  ns3::ndn::Interest interestHeader;
+  packet->RemoveHeader (interestHeader);
+  ns3::ndn::Name name = interestHeader.GetName ();
+
+  std::map<ns3::ndn::Name, VmChunkPitEntry_t>::iterator pitIt = m_vmChunkPit.find (name);
+  if (pitIt == m_vmChunkPit.end ())
+    {
+      return;
+    }
+  VmChunkSourceInfo &info = GetVmChunkSource (pitIt->second.m_source);
+  --info.m_outstanding;
+  ++info.m_nacks;
+  // a source missing the chunks is tried less often
+  info.m_interval = Seconds (2 * info.m_interval.GetSeconds ());
+
+  if (pitIt->second.m_source == pitIt->second.m_producer)
+    {
+      NS_LOG_WARN ("VM chunk " << name << " refused by its producer");
+      return;
+    }
+  NS_LOG_LOGIC ("VM chunk " << name << " not cached by source " << pitIt->second.m_source
+                << ", asking the source eNB " << pitIt->second.m_producer);
+  SendVmChunkRequest (name, pitIt->second.m_producer);
+  PumpVmChunkRequests ();
+}
+
+void
+EpcX2::RecvVmChunkFromGateway (uint32_t teid, Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << teid << packet);
+
+  if (teid == VM_CHUNK_CONTENT_TEID)
+    {
+      RecvVmChunk (packet);
+    }
+  else
+    {
+      RecvVmChunkNack (packet);
+    }
+}
+
+void
+EpcX2::VmChunkFetched (Ptr<VmMigrationInfo> migration, VmChunkSource_t source)
+{
+  if (migration->m_chunks == 0)
+    {
+      SetVmMigrationState (migration, VmMigrationInfo::RECEIVING);
+    }
+  ++migration->m_chunks;
+  --migration->m_outstanding;
+  m_vmChunkFetchedTrace (migration->m_migrationId, source);
+}
+
+void
+EpcX2::RegisterX2cHandler (uint8_t procedureCode, uint8_t messageType, std::string name, X2cHandler handler, bool fromPeer)
+{
+  NS_LOG_FUNCTION (this << (uint32_t) procedureCode << (uint32_t) messageType << name);
+  uint16_t key = GetX2cHandlerKey (procedureCode, messageType);
+  NS_ASSERT_MSG (m_x2cHandlers.find (key) == m_x2cHandlers.end (),
+                 "X2-C handler already registered for procedure " << (uint32_t) procedureCode
+                 << " message type " << (uint32_t) messageType);
+  X2cHandlerInfo &info = m_x2cHandlers[key];
+  info.m_handler = handler;
+  info.m_name = name;
+  info.m_fromPeer = fromPeer;
+  info.m_latencyHistogram.assign (X2C_LATENCY_BINS, 0);
+}
+
+uint16_t
+EpcX2::GetX2cHandlerKey (uint8_t procedureCode, uint8_t messageType)
+{
+  return ((uint16_t) procedureCode << 8) | messageType;
+}
+
+void
+EpcX2::PrintX2cStats (std::ostream &os) const
+{
+  // a message received in a bundle is counted once, in count and in nested
+  os << "procedure\tmessageType\thandler\tcount\tnested\n";
+  for (std::map<uint16_t, X2cHandlerInfo>::const_iterator it = m_x2cHandlers.begin (); it != m_x2cHandlers.end (); ++it)
+    {
+      const X2cHandlerInfo &info = it->second;
+      os << (it->first >> 8) << "\t" << (it->first & 0xff) << "\t" << info.m_name << "\t" << info.m_count
+         << "\t" << info.m_nested << "\n";
+    }
+  os << "unhandled\t\t\t" << m_x2cUnhandled << "\n";
+  // messages and bytes sent, a bundle counting as one message
+  os << "sent\t\t\t" << m_x2cMessagesSent << "\t" << m_x2cBytesSent << "\n";
+  os << "controller\t\t\t" << m_controllerMessagesSent << "\t" << m_controllerBytesSent << "\n";
+  os << "sendFailed\t\t\t" << m_x2SendFailures << "\n";
+  os << "bundleDropped\t\t\t" << m_x2BundleDrops << "\n";
+}
+
+void
+EpcX2::PrintX2cProfile (std::ostream &os) const
+{
+  os << "procedure\tmessageType\thandler\tcount\tmeanLatencyUs";
+  for (uint32_t bin = 0; bin < X2C_LATENCY_BINS; bin++)
+    {
+      os << "\t<" << (1u << bin) << "us";
+    }
+  os << "\n";
+  for (std::map<uint16_t, X2cHandlerInfo>::const_iterator it = m_x2cHandlers.begin (); it != m_x2cHandlers.end (); ++it)
+    {
+      const X2cHandlerInfo &info = it->second;
+      os << (it->first >> 8) << "\t" << (it->first & 0xff) << "\t" << info.m_name << "\t" << info.m_timed << "\t"
+         << ((info.m_timed > 0) ? ((double) info.m_totalLatencyUs / info.m_timed) : 0.0);
+      for (uint32_t bin = 0; bin < X2C_LATENCY_BINS; bin++)
+        {
+          os << "\t" << info.m_latencyHistogram[bin];
+        }
+      os << "\n";
+    }
+}
+
+uint64_t
+EpcX2::GetWallClockUs (void)
+{
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+void
+EpcX2::RecvFromX2cSocket (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+
+  NS_LOG_LOGIC ("Recv X2 message: from Socket");
+  Address from;
+  Ptr<Packet> packet = socket->RecvFrom (from);
+  NS_LOG_LOGIC ("packetLen = " << packet->GetSize ());
+
+  // messages from the controller do not come from an X2 peer
+  Ptr<X2CellInfo> cellsInfo = GetX2CellInfo (socket, from);
+  NS_ASSERT_MSG (cellsInfo != 0 || m_sharedSockets,
+                 "Missing infos of local and remote CellId");
+  if (cellsInfo != 0)
+    {
+      m_x2InterfaceSockets [cellsInfo->m_remoteCellId]->m_lastUse = Simulator::Now ();
+    }
+
+  DispatchX2cMessage (packet, cellsInfo);
+}
+
+void
+EpcX2::DispatchX2cMessage (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  EpcX2Header x2Header;
+  packet->RemoveHeader (x2Header);
+
+  NS_LOG_LOGIC ("X2 header: " << x2Header);
+
+  uint8_t messageType = x2Header.GetMessageType ();
+  uint8_t procedureCode = x2Header.GetProcedureCode ();
+
+  std::map<uint16_t, X2cHandlerInfo>::iterator handlerIt = m_x2cHandlers.find (GetX2cHandlerKey (procedureCode, messageType));
+  if (handlerIt == m_x2cHandlers.end ())
+    {
+      NS_LOG_WARN ("No X2-C handler for procedure " << (uint32_t) procedureCode
+                   << " message type " << (uint32_t) messageType << ", discarding packet");
+      ++m_x2cUnhandled;
+      return;
+    }
+
+  X2cHandlerInfo &info = handlerIt->second;
+  NS_ASSERT_MSG (cellsInfo != 0 || !info.m_fromPeer,
+                 "X2-C message " << info.m_name << " from a node which is not an X2 peer");
+  // the messages of a bundle are dispatched from within the bundle handler
+  bool nested = (m_x2cDispatchDepth > 0);
+  ++info.m_count;
+  if (nested)
+    {
+      ++info.m_nested;
+    }
+  if (!m_x2cProfiling)
+    {
+      ++m_x2cDispatchDepth;
+      (this->*(info.m_handler)) (packet, cellsInfo);
+      --m_x2cDispatchDepth;
+      m_x2cHandledTrace (procedureCode, messageType, nested);
+      return;
+    }
+
+  // the time of the nested handlers is charged to them and not to the bundle
+  uint64_t outerNestedUs = m_x2cNestedUs;
+  m_x2cNestedUs = 0;
+  uint64_t start = GetWallClockUs ();
+  ++m_x2cDispatchDepth;
+  (this->*(info.m_handler)) (packet, cellsInfo);
+  --m_x2cDispatchDepth;
+  uint64_t elapsedUs = GetWallClockUs () - start;
+  uint64_t latencyUs = (elapsedUs > m_x2cNestedUs) ? elapsedUs - m_x2cNestedUs : 0;
+  m_x2cNestedUs = outerNestedUs + elapsedUs;
+
+  // log2 buckets: bin i counts the latencies below 2^i us, the last bin is open ended
+  uint32_t bin = 0;
+  while (bin < X2C_LATENCY_BINS - 1 && latencyUs >= (1u << bin))
+    {
+      ++bin;
+    }
+  ++info.m_timed;
+  info.m_totalLatencyUs += latencyUs;
+  ++info.m_latencyHistogram[bin];
+  m_x2cHandledTrace (procedureCode, messageType, nested);
+}
+
+void
+EpcX2::DoRecvHandoverRequest (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  NS_LOG_LOGIC ("Recv X2 message: HANDOVER REQUEST");
+
+  EpcX2HandoverRequestHeader x2HoReqHeader;
+  packet->RemoveHeader (x2HoReqHeader);
+
+  NS_LOG_INFO ("X2 HandoverRequest header: " << x2HoReqHeader);
+
+  EpcX2SapUser::HandoverRequestParams params;
+  params.oldEnbUeX2apId = x2HoReqHeader.GetOldEnbUeX2apId ();
+  params.cause          = x2HoReqHeader.GetCause ();
+  params.sourceCellId   = cellsInfo->m_remoteCellId;
+  params.targetCellId   = x2HoReqHeader.GetTargetCellId ();
+  params.mmeUeS1apId    = x2HoReqHeader.GetMmeUeS1apId ();
+  params.ueAggregateMaxBitRateDownlink = x2HoReqHeader.GetUeAggregateMaxBitRateDownlink ();
+  params.ueAggregateMaxBitRateUplink   = x2HoReqHeader.GetUeAggregateMaxBitRateUplink ();
+  params.bearers        = x2HoReqHeader.GetBearers ();
+  params.rrcContext     = packet;
+
+  NS_LOG_LOGIC ("oldEnbUeX2apId = " << params.oldEnbUeX2apId);
+  NS_LOG_LOGIC ("sourceCellId = " << params.sourceCellId);
+  NS_LOG_LOGIC ("targetCellId = " << params.targetCellId);
+  NS_LOG_LOGIC ("mmeUeS1apId = " << params.mmeUeS1apId);
+  NS_LOG_LOGIC ("cellsInfo->m_localCellId = " << cellsInfo->m_localCellId);
+  NS_ASSERT_MSG (params.targetCellId == cellsInfo->m_localCellId,
+                 "TargetCellId mismatches with localCellId");
+
+  m_handoverImsis[((uint32_t) params.sourceCellId << 16) | params.oldEnbUeX2apId] = params.mmeUeS1apId;
+  m_x2SapUser->RecvHandoverRequest (params);
+}
+
+void
+EpcX2::DoRecvVmPrediction (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  NS_LOG_LOGIC ("Recv X2 message: VM PREDICTION");
+
+  uint8_t buf[4];
+  packet->CopyData (buf, 4);
+  uint16_t oldEnbUeX2apId = ((uint16_t) buf[0] << 8) | buf[1];
+  uint16_t predictedCellId = ((uint16_t) buf[2] << 8) | buf[3];
+
+  // the handover request came first and has been answered already
+  std::map<uint32_t, uint16_t>::iterator rntiIt
+    = m_handoverRntis.find (((uint32_t) cellsInfo->m_remoteCellId << 16) | oldEnbUeX2apId);
+  if (rntiIt == m_handoverRntis.end ())
+    {
+      NS_LOG_WARN ("No accepted handover for the VM prediction of oldEnbUeX2apId " << oldEnbUeX2apId);
+      return;
+    }
+  std::map<uint32_t, Ptr<VmMigrationInfo> >::iterator migrationIt
+    = m_vmMigrationsIn.find (((uint32_t) cellsInfo->m_remoteCellId << 16) | rntiIt->second);
+  if (migrationIt == m_vmMigrationsIn.end ())
+    {
+      NS_LOG_LOGIC ("no VM migration for the handover of oldEnbUeX2apId " << oldEnbUeX2apId);
+      return;
+    }
+  NS_LOG_INFO ("VM " << rntiIt->second << " of cell " << cellsInfo->m_remoteCellId
+               << " predicted to be used from cell " << predictedCellId);
+  migrationIt->second->m_predictedCellId = predictedCellId;
+}
+
+void
+EpcX2::DoRecvX2Bundle (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  NS_LOG_LOGIC ("Recv X2 message: X2 BUNDLE");
+
+  // the answers to the bundled messages go back in a bundle as well
+  BeginX2Bundle (cellsInfo->m_remoteCellId);
+  EpcX2Header x2Header;
+  while (packet->GetSize () > 0)
+    {
+      // a malformed bundle is dropped from the first message which does
+      // not fit, the messages before it have been handled
+      uint32_t size = 0;
+      if (packet->GetSize () >= 2)
+        {
+          uint8_t length[2];
+          packet->CopyData (length, 2);
+          size = ((uint32_t) length[0] << 8) | length[1];
+        }
+      if (size < x2Header.GetSerializedSize () || 2 + size > packet->GetSize ())
+        {
+          NS_LOG_WARN ("Malformed X2 bundle from cell " << cellsInfo->m_remoteCellId << ", "
+                       << packet->GetSize () << " bytes dropped");
+          ++m_x2BundleDrops;
+          m_x2BundleDroppedTrace (cellsInfo->m_remoteCellId, packet->GetSize ());
+          break;
+        }
+      packet->RemoveAtStart (2);
+      Ptr<Packet> message = packet->CreateFragment (0, size);
+      packet->RemoveAtStart (size);
+      DispatchX2cMessage (message, cellsInfo);
+    }
+  EndX2Bundle (cellsInfo->m_remoteCellId);
+}
+
+void
+EpcX2::DoRecvPitTransfer (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  NS_LOG_LOGIC ("Recv X2 message: PIT TRANSFER");
+
+  uint8_t buf[2];
+  packet->CopyData (buf, 2);
+  packet->RemoveAtStart (2);
+  uint16_t oldEnbUeX2apId = ((uint16_t) buf[0] << 8) | buf[1];
+
+  // the handover request came first and has been answered already
+  std::map<uint32_t, uint16_t>::iterator rntiIt
+    = m_handoverRntis.find (((uint32_t) cellsInfo->m_remoteCellId << 16) | oldEnbUeX2apId);
+  if (rntiIt == m_handoverRntis.end () || epcEnbApp == 0)
+    {
+      NS_LOG_WARN ("No accepted handover for the PIT transfer of oldEnbUeX2apId " << oldEnbUeX2apId);
+      return;
+    }
+  epcEnbApp->RecvPitTransfer (rntiIt->second, packet);
+}
+
+void
+EpcX2::DoRecvIcnMessage (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  NS_LOG_INFO ("TARGET ENB RECEIVES ICN MESSAGE. CONFIGURING PIT");
+  ofstream out ((ccMsgFileRecvTrg.str ()).c_str (), ios::app);
+  out << Simulator::Now ().GetSeconds () << "\n";
+
+  // the controller does not answer in notification order, e.g. once the
+  // VM of each UE has started: the UEs are named in the message
+  uint16_t handovers = GetIcnMessageHandovers (packet);
+  if (packet->GetSize () >= 4 + 2 * (uint32_t) handovers)
+    {
+      std::vector<uint8_t> buf (4 + 2 * handovers);
+      packet->CopyData (&buf[0], buf.size ());
+      uint16_t sourceCellId = ((uint16_t) buf[2] << 8) | buf[3];
+      for (uint16_t n = 0; n < handovers && sourceCellId != 0; n++)
+        {
+          uint16_t ueId = ((uint16_t) buf[4 + 2 * n] << 8) | buf[5 + 2 * n];
+          std::map<uint32_t, uint64_t>::iterator imsiIt
+            = m_icnPendingImsis.find (((uint32_t) sourceCellId << 16) | ueId);
+          if (imsiIt != m_icnPendingImsis.end ())
+            {
+              m_icnMessageTrace (imsiIt->second);
+              m_icnPendingImsis.erase (imsiIt);
+            }
+        }
+    }
+
+  if (m_vmMigration > 0)
+  {
+      for (uint32_t i = 0; i < m_paramsRecv.size(); i++)
+      {
+         EpcX2SapUser::UeDataParams params;
+
+         params.sourceCellId = m_paramsRecv[i].sourceCellId;
+         params.targetCellId = m_paramsRecv[i].targetCellId;
+         params.gtpTeid      = m_paramsRecv[i].gtpTeid;
+         params.ueData       = m_ueDataRecv[i];
+
+         NS_LOG_INFO ("SENDING UE DATA FROM TARGET ENB TO UE");
+         m_x2SapUser->RecvUeData (params);
+      }
+
+  }
+}
+
+void
+EpcX2::DoRecvIcnMessageSource (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  NS_LOG_INFO ("SOURCE ENB RECEIVES ICN MESSAGE. CONFIGURING PIT");
+
+  ofstream out ((ccMsgFileRecvSrc.str ()).c_str (), ios::app);
+  out << Simulator::Now ().GetSeconds () << "\n";
+
+  uint16_t handovers = GetIcnMessageHandovers (packet);
+  for (uint16_t n = 0; n < handovers; n++)
+    {
+      ForwardIcnUeData ();
+    }
+}
+
+uint16_t
+EpcX2::GetIcnMessageHandovers (Ptr<Packet> packet)
+{
+  // a grouped answer of the controller carries the number of UEs in its
+  // first two bytes, 0 meaning a single UE
+  uint16_t handovers = 1;
+  if (packet->GetSize () >= 2)
+    {
+      uint8_t buf[2];
+      packet->CopyData (buf, 2);
+      handovers = std::max<uint16_t> (1, ((uint16_t) buf[0] << 8) | buf[1]);
+    }
+  return handovers;
+}
+
+void
+EpcX2::ForwardIcnUeData ()
+{
+    if (m_sendUeData.size() > 0)
+    {
+      NS_LOG_INFO ("m_sendUeData");
+
+      uint16_t i = 0;
+
+      for (i = 0; i < m_params.size(); i++)
+      {
+         if (i == 0)
+         {
+             Ptr<Packet> packet = m_ueData[0]->Copy();
+             Ipv4Header ipv4Header;
+             packet->RemoveHeader (ipv4Header);
+             m_icnIpSource = ipv4Header.GetDestination();
+         }
+         NS_LOG_INFO ("COUNTER: " << i);
+         EpcX2SapProvider::UeDataParams params;
+         params.sourceCellId = m_params[i].sourceCellId;
+         params.targetCellId = m_params[i].targetCellId;
+         params.gtpTeid = m_params[i].gtpTeid;
+         params.ueData = m_ueData[i];
+
+         Ptr<Packet> packet = m_ueData[i]->Copy();
+         Ipv4Header ipv4Header;
+         packet->RemoveHeader (ipv4Header);
+
+         if (m_icnIpSource == ipv4Header.GetDestination())
+         {
+           EpcX2::DoSendUeData2 (params);
+
+           if(std::find(m_ipBuff.begin(), m_ipBuff.end(), m_icnIpSource)!=m_ipBuff.end())
+           {
+               NS_LOG_INFO ("FIND THE SAME ADDRESS IN THE BUFFER");
+           }
+           else
+           {
+               NS_LOG_INFO ("DON'T FIND THE SAME ADDRESS IN THE BUFFER");
+               m_ipBuff.push_back(m_icnIpSource);
+           }
+         }
+         else
+         {
+             goto skip_loop;
+         }
+      }
+
+      skip_loop:
+      NS_LOG_INFO ("NILAI i: " << i);
+
+      m_params.erase(m_params.begin(),m_params.begin()+i);
+      m_ueData.erase(m_ueData.begin(),m_ueData.begin()+i);
+
+      m_sendUeData.erase(m_sendUeData.begin(),m_sendUeData.begin()+i);
+    }
+    else
+    {
+       NS_LOG_INFO ("NO m_sendUeData");
+       bool icnMsg = true;
+       m_icnMsgSource.push_back(icnMsg);
+    }
+}
+
+void
+EpcX2::DoRecvMigrationRequest (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  NS_LOG_INFO("Target eNodeB receives VM migration request");
+
+  // requests from the controller are served in the order the handovers were accepted
+  Ptr<VmMigrationInfo> migration = FindVmMigrationIn (packet, VmMigrationInfo::PREPARED);
+  if (migration == 0)
+    {
+      NS_LOG_WARN ("VM migration request without a prepared migration, ignoring");
+      return;
+    }
+
+  if (m_vmPlacement)
+    {
+      // the prediction of the source eNB, sent with the handover request
+      uint16_t predictedCellId = (migration->m_predictedCellId != 0) ? migration->m_predictedCellId : m_localCellId;
+      uint16_t cellId = SelectVmPlacement (predictedCellId);
+      Time latency;
+      EstimateVmResponseLatency (cellId, predictedCellId, latency);
+      NS_LOG_INFO ("VM " << migration->m_migrationId << " placed on cell " << cellId
+                   << ", estimated response latency " << latency.GetSeconds () << " s");
+      m_vmPlacementTrace (migration->m_migrationId, cellId, latency);
+      if (cellId != m_localCellId)
+        {
+          PlaceVm (migration, cellId);
+          return;
+        }
+    }
+
+  RequestVm (migration);
+}
+
+void
+EpcX2::RequestVm (Ptr<VmMigrationInfo> migration)
 {
-  x2FileDataSent << m_simName <<  "_X2DataSent.csv";
-  x2FileDataRecv << m_simName <<  "_X2DataRecv.csv";
-  ccMsgFileSent << m_simName <<  "_ccMsgSent.csv";
-  ccMsgFileRecvSrc << m_simName <<  "_ccMsgRecvSrc.csv";
-  ccMsgFileRecvTrg << m_simName <<  "_ccMsgRecvTrg.csv";
-  ackFile << m_simName <<  "_ackFile.csv";
-  vmFileSent << m_simName << "_vmSent.csv";
-  vmFileRecv << m_simName << "_vmRecv.csv";
+  uint16_t sourceCellId = migration->m_peerCellId;
 
+  if (m_vmNamedChunks)
+    {
+      NS_LOG_INFO ("Target eNodeB pulls the chunks of VM " << migration->m_migrationId);
+      migration->m_startTime = Simulator::Now ();
+      SetVmMigrationState (migration, VmMigrationInfo::REQUESTED);
+      RequestVmChunks (migration);
+      return;
+    }
 
-  NS_LOG_FUNCTION (this << localCellId << localX2Address << remoteCellId << remoteX2Address);
+  NS_ASSERT_MSG (m_x2InterfaceSockets.find (sourceCellId) != m_x2InterfaceSockets.end (),
+           "Missing infos for Migration Request = " << sourceCellId);
+  Ptr<X2IfaceInfo> socketInfo = m_x2InterfaceSockets [sourceCellId];
+  Ptr<Socket> sourceSocket = socketInfo->m_localCtrlPlaneSocket;
+  Ipv4Address sourceIpAddr = socketInfo->m_remoteIpAddr;
 
-  int retval;
+  EpcX2Header x2Header;
+  x2Header.SetMessageType (EpcX2Header::InterestVm);
+  x2Header.SetProcedureCode (EpcX2Header::HandoverPreparation);
+  x2Header.SetLengthOfIes (1);
+  x2Header.SetNumberOfIes (1);
 
-  // Get local eNB where this X2 entity belongs to
-  Ptr<Node> localEnb = GetObject<Node> ();
+  uint8_t buf[17] = { 0 }; // 24 - header
+  buf[0] = migration->m_migrationId >> 8;
+  buf[1] = migration->m_migrationId & 0xff;
+  Ptr<Packet> interestForVm = Create<Packet> (buf, 17);
+  interestForVm->AddHeader (x2Header);
 
-  // Create X2-C socket for the local eNB
-  Ptr<Socket> localX2cSocket = Socket::CreateSocket (localEnb, TypeId::LookupByName ("ns3::UdpSocketFactory"));
-  retval = localX2cSocket->Bind (InetSocketAddress (localX2Address, m_x2cUdpPort));
-  NS_ASSERT (retval == 0);
-  localX2cSocket->SetRecvCallback (MakeCallback (&EpcX2::RecvFromX2cSocket, this));
+  NS_LOG_INFO("INTEREST SIZE: " << interestForVm->GetSize());
 
-  // Create X2-U socket for the local eNB
-  Ptr<Socket> localX2uSocket = Socket::CreateSocket (localEnb, TypeId::LookupByName ("ns3::UdpSocketFactory"));
-  retval = localX2uSocket->Bind (InetSocketAddress (localX2Address, m_x2uUdpPort));
-  NS_ASSERT (retval == 0);
-  localX2uSocket->SetRecvCallback (MakeCallback (&EpcX2::RecvFromX2uSocket, this));
+  SendOverX2 (sourceCellId, sourceSocket, sourceIpAddr, m_x2cUdpPort, interestForVm, X2_CLASS_CONTROL);
 
+  NS_LOG_INFO("Target eNodeB sends Interest for VM to Source eNodeB");
+  SetVmMigrationState (migration, VmMigrationInfo::REQUESTED);
+}
 
-  NS_ASSERT_MSG (m_x2InterfaceSockets.find (remoteCellId) == m_x2InterfaceSockets.end (),
-                 "Mapping for remoteCellId = " << remoteCellId << " is already known");
-  m_x2InterfaceSockets [remoteCellId] = Create<X2IfaceInfo> (remoteX2Address, localX2cSocket, localX2uSocket);
+void
+EpcX2::PlaceVm (Ptr<VmMigrationInfo> migration, uint16_t cellId)
+{
+  NS_LOG_FUNCTION (this << migration->m_migrationId << cellId);
 
-  NS_ASSERT_MSG (m_x2InterfaceCellIds.find (localX2cSocket) == m_x2InterfaceCellIds.end (),
-                 "Mapping for control plane localSocket = " << localX2cSocket << " is already known");
-  m_x2InterfaceCellIds [localX2cSocket] = Create<X2CellInfo> (localCellId, remoteCellId);
+  NS_ASSERT_MSG (m_x2InterfaceSockets.find (cellId) != m_x2InterfaceSockets.end (),
+                 "Missing infos for VM placement = " << cellId);
+  Ptr<X2IfaceInfo> socketInfo = m_x2InterfaceSockets [cellId];
 
-  NS_ASSERT_MSG (m_x2InterfaceCellIds.find (localX2uSocket) == m_x2InterfaceCellIds.end (),
-                 "Mapping for data plane localSocket = " << localX2uSocket << " is already known");
-  m_x2InterfaceCellIds [localX2uSocket] = Create<X2CellInfo> (localCellId, remoteCellId);
-}
+  EpcX2Header x2Header;
+  x2Header.SetMessageType (EpcX2Header::VmPlacement);
+  x2Header.SetProcedureCode (EpcX2Header::HandoverPreparation);
+  x2Header.SetLengthOfIes (3);
+  x2Header.SetNumberOfIes (3);
+
+  // the neighbor reports to the controller on behalf of this cell
+  uint8_t buf[6];
+  buf[0] = migration->m_peerCellId >> 8;
+  buf[1] = migration->m_peerCellId & 0xff;
+  buf[2] = migration->m_migrationId >> 8;
+  buf[3] = migration->m_migrationId & 0xff;
+  buf[4] = m_localCellId >> 8;
+  buf[5] = m_localCellId & 0xff;
+  Ptr<Packet> packet = Create<Packet> (buf, 6);
+  packet->AddHeader (x2Header);
 
-void EpcX2::GetEpcEnbApplication (Ptr<EpcEnbApplication> enb)  // new
-{
-    epcEnbApp = enb;
+  SendOverX2 (cellId, socketInfo->m_localCtrlPlaneSocket, socketInfo->m_remoteIpAddr, m_x2cUdpPort,
+              packet, X2_CLASS_CONTROL);
+  ++m_vmPlacedOn[cellId];
+
+  SetVmMigrationState (migration, VmMigrationInfo::PLACED);
+  m_vmMigrationsIn.erase (((uint32_t) migration->m_peerCellId << 16) | migration->m_migrationId);
+  m_vmMigrationsInFifo.remove (migration);
 }
 
 void
-EpcX2::SendVm ()
+EpcX2::DoRecvVmPlacement (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
 {
-  if (m_counter < m_numOfPacket)
-  {
-     if (m_counter == 0)
-     {
-         ofstream out ((vmFileSent.str ()).c_str (), ios::app);
-         out << Simulator::Now ().GetSeconds () << "\n";
-     }
-     uint16_t  targetCellId = 2;
-
-     NS_ASSERT_MSG (m_x2InterfaceSockets.find (targetCellId) != m_x2InterfaceSockets.end (),
-                 "Missing infos for targetCellId in VM migration = " << targetCellId);
-     Ptr<X2IfaceInfo> socketInfo = m_x2InterfaceSockets [targetCellId];
-     Ptr<Socket> sourceSocket    = socketInfo->m_localUserPlaneSocket;
-     Ipv4Address targetIpAddr    = socketInfo->m_remoteIpAddr;
+  uint8_t buf[6];
+  packet->CopyData (buf, 6);
+  uint16_t sourceCellId = (buf[0] << 8) | buf[1];
+  uint16_t migrationId = (buf[2] << 8) | buf[3];
+  uint16_t handoverCellId = (buf[4] << 8) | buf[5];
+  NS_LOG_INFO ("VM " << migrationId << " of cell " << sourceCellId << " placed here by cell " << handoverCellId);
+
+  // the VM is fetched from its source eNB, which may not be a neighbor yet
+  if (!HasX2Interface (sourceCellId) && !m_x2InterfaceRequestCallback.IsNull ())
+    {
+      m_x2InterfaceRequestCallback (cellsInfo->m_localCellId, sourceCellId);
+    }
+  NS_ASSERT_MSG (HasX2Interface (sourceCellId),
+                 "VM placement needs an X2 interface with the source cell " << sourceCellId);
 
-     uint32_t teid   = 9999;
+  uint32_t key = ((uint32_t) sourceCellId << 16) | migrationId;
+  if (m_vmMigrationsIn.find (key) != m_vmMigrationsIn.end ())
+    {
+      NS_LOG_WARN ("VM migration " << migrationId << " from cell " << sourceCellId << " already in progress");
+      return;
+    }
+  Ptr<VmMigrationInfo> migration = Create<VmMigrationInfo> (sourceCellId, migrationId);
+  migration->m_handoverCellId = handoverCellId;
+  m_vmMigrationsIn[key] = migration;
+  m_vmMigrationsInFifo.push_back (migration);
+  SetVmMigrationState (migration, VmMigrationInfo::PREPARED);
 
-     GtpuHeader gtpu;
-     gtpu.SetTeid (teid);
-     gtpu.SetLength (1298 + gtpu.GetSerializedSize () - 8); // TODO This should be done in GtpuHeader
+  RequestVm (migration);
+}
 
-     Ptr<Packet> packet = Create<Packet> (1298);
-     packet->AddHeader (gtpu);
+void
+EpcX2::RecvMeasurementReport (uint64_t imsi, uint16_t cellId, uint16_t rnti, LteRrcSap::MeasurementReport report)
+{
+  if (!m_vmPlacement)
+    {
+      return;
+    }
 
-//     NS_LOG_INFO("PACKET LENGTH: " << packet->GetSize());
+  uint16_t predictedCellId = cellId;
+  uint8_t bestRsrp = report.measResults.rsrpResult;
+  if (report.measResults.haveMeasResultNeighCells)
+    {
+      // the physical cell id of the neighbors is their cell id
+      for (std::list<LteRrcSap::MeasResultEutra>::iterator it = report.measResults.measResultListEutra.begin ();
+           it != report.measResults.measResultListEutra.end ();
+           ++it)
+        {
+          if (it->haveRsrpResult && it->rsrpResult > bestRsrp)
+            {
+              bestRsrp = it->rsrpResult;
+              predictedCellId = it->physCellId;
+            }
+        }
+    }
+  NS_LOG_LOGIC ("UE " << imsi << " predicted to be served by cell " << predictedCellId);
+  m_vmPredictedCell[imsi] = predictedCellId;
+}
 
-     sourceSocket->SendTo (packet, 0, InetSocketAddress (targetIpAddr, m_x2uUdpPort));
+bool
+EpcX2::EstimateVmResponseLatency (uint16_t cellId, uint16_t predictedCellId, Time &latency) const
+{
+  double load;
+  uint32_t inFlight = 0;
+  if (cellId == m_localCellId)
+    {
+      for (std::list<Ptr<VmMigrationInfo> >::const_iterator it = m_vmMigrationsInFifo.begin (); it != m_vmMigrationsInFifo.end (); ++it)
+        {
+          if ((*it)->m_state == VmMigrationInfo::REQUESTED || (*it)->m_state == VmMigrationInfo::RECEIVING)
+            {
+              ++inFlight;
+            }
+        }
+      load = (double) (m_vmHosted + inFlight) / m_vmCapacity;
+    }
+  else
+    {
+      std::map<uint16_t, X2NeighborLoad>::const_iterator loadIt = m_x2NeighborLoad.find (cellId);
+      if (loadIt == m_x2NeighborLoad.end () || !HasX2Interface (cellId))
+        {
+          return false;
+        }
+      if (Simulator::Now () - loadIt->second.m_lastUpdate > m_vmNeighborLoadMaxAge)
+        {
+          NS_LOG_LOGIC ("load of cell " << cellId << " reported at "
+                        << loadIt->second.m_lastUpdate.GetSeconds () << "s is stale");
+          return false;
+        }
+      std::map<uint16_t, uint32_t>::const_iterator placedIt = m_vmPlacedOn.find (cellId);
+      if (placedIt != m_vmPlacedOn.end ())
+        {
+          inFlight = placedIt->second;
+        }
+      load = std::max (loadIt->second.m_resourceLoad, loadIt->second.m_interferenceLoad)
+        + (double) inFlight / m_vmCapacity;
+    }
+  if (load >= 1)
+    {
+      return false;
+    }
 
-     Simulator::Schedule (Seconds(0.00021216), &EpcX2::SendVm, this);
-     ++m_counter;
+  // the VMs already on their way to the cell share the X2 link with this one
+  double transfer = m_x2LinkDataRate.CalculateTxTime (m_vmChunkSize + 28) * m_numOfPacket * (1 + inFlight);
+  latency = Seconds (m_vmServiceTime.GetSeconds () / (1 - load) + transfer / m_vmPlacementHorizon);
+  if (cellId != predictedCellId)
+    {
+      latency += m_vmRemoteAccessDelay;
+    }
+  return true;
+}
 
-     if (m_counter == m_numOfPacket)
-     {
-        NS_LOG_INFO("TOTAL VM CHUNKS SENT: " << m_counter);
-     }
-  }
+uint16_t
+EpcX2::SelectVmPlacement (uint16_t predictedCellId) const
+{
+  uint16_t bestCellId = m_localCellId;
+  Time bestLatency;
+  bool found = EstimateVmResponseLatency (m_localCellId, predictedCellId, bestLatency);
 
+  for (std::map<uint16_t, X2NeighborLoad>::const_iterator it = m_x2NeighborLoad.begin (); it != m_x2NeighborLoad.end (); ++it)
+    {
+      Time latency;
+      if (EstimateVmResponseLatency (it->first, predictedCellId, latency)
+          && (!found || latency < bestLatency))
+        {
+          bestCellId = it->first;
+          bestLatency = latency;
+          found = true;
+        }
+    }
+  // when all the cells are overloaded the VM stays with the UE
+  return bestCellId;
 }
 
 void
-EpcX2::RecvFromX2cSocket (Ptr<Socket> socket)
+EpcX2::DoRecvCsMigration (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
 {
-  NS_LOG_FUNCTION (this << socket);
+  NS_LOG_LOGIC ("Recv X2 message: CS MIGRATION");
 
-  NS_LOG_LOGIC ("Recv X2 message: from Socket");
-  Ptr<Packet> packet = socket->Recv ();
-  NS_LOG_LOGIC ("packetLen = " << packet->GetSize ());
+  CsEps_t cs;
+  packet->RemoveHeader (cs.m_ipHeader);
+  packet->RemoveHeader (cs.m_udpHeader);
+  cs.m_contentHeader = Create<ns3::ndn::ContentObject> ();
+  packet->RemoveHeader (*(cs.m_contentHeader));
+  cs.m_content = packet;
 
-  NS_ASSERT_MSG (m_x2InterfaceCellIds.find (socket) != m_x2InterfaceCellIds.end (),
-                 "Missing infos of local and remote CellId");
-  Ptr<X2CellInfo> cellsInfo = m_x2InterfaceCellIds [socket];
+  epcEnbApp->RecvMigratedContent (cs);
+}
 
-  EpcX2Header x2Header;
-  packet->RemoveHeader (x2Header);
+void
+EpcX2::DoRecvInterestVm (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  NS_LOG_INFO("Source eNodeB receives Interest for VM");
 
-  NS_LOG_LOGIC ("X2 header: " << x2Header);
+  uint8_t buf[2];
+  packet->CopyData (buf, 2);
+  uint16_t migrationId = (buf[0] << 8) | buf[1];
 
-  uint8_t messageType = x2Header.GetMessageType ();
-  uint8_t procedureCode = x2Header.GetProcedureCode ();
+  StartVmTransfer (cellsInfo->m_remoteCellId, migrationId);
+}
 
-  if (procedureCode == EpcX2Header::HandoverPreparation)
-    {
-      if (messageType == EpcX2Header::InitiatingMessage)
-        {
-          NS_LOG_LOGIC ("Recv X2 message: HANDOVER REQUEST");
-
-          EpcX2HandoverRequestHeader x2HoReqHeader;
-          packet->RemoveHeader (x2HoReqHeader);
-
-          NS_LOG_INFO ("X2 HandoverRequest header: " << x2HoReqHeader);
-
-          EpcX2SapUser::HandoverRequestParams params;
-          params.oldEnbUeX2apId = x2HoReqHeader.GetOldEnbUeX2apId ();
-          params.cause          = x2HoReqHeader.GetCause ();
-          params.sourceCellId   = cellsInfo->m_remoteCellId;
-          params.targetCellId   = x2HoReqHeader.GetTargetCellId ();
-          params.mmeUeS1apId    = x2HoReqHeader.GetMmeUeS1apId ();
-          params.ueAggregateMaxBitRateDownlink = x2HoReqHeader.GetUeAggregateMaxBitRateDownlink ();
-          params.ueAggregateMaxBitRateUplink   = x2HoReqHeader.GetUeAggregateMaxBitRateUplink ();
-          params.bearers        = x2HoReqHeader.GetBearers ();
-          params.rrcContext     = packet;
-
-          NS_LOG_LOGIC ("oldEnbUeX2apId = " << params.oldEnbUeX2apId);
-          NS_LOG_LOGIC ("sourceCellId = " << params.sourceCellId);
-          NS_LOG_LOGIC ("targetCellId = " << params.targetCellId);
-          NS_LOG_LOGIC ("mmeUeS1apId = " << params.mmeUeS1apId);
-          NS_LOG_LOGIC ("cellsInfo->m_localCellId = " << cellsInfo->m_localCellId);
-          NS_ASSERT_MSG (params.targetCellId == cellsInfo->m_localCellId,
-                         "TargetCellId mismatches with localCellId");
-
-          m_x2SapUser->RecvHandoverRequest (params);
-        }
-      else if (messageType == EpcX2Header::IcnMessage)
-      {
-         NS_LOG_INFO ("TARGET ENB RECEIVES ICN MESSAGE. CONFIGURING PIT");
-         ofstream out ((ccMsgFileRecvTrg.str ()).c_str (), ios::app);
-         out << Simulator::Now ().GetSeconds () << "\n";
+void
+EpcX2::DoRecvInterestVmChunk (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  ns3::ndn::Interest interestHeader;
+  packet->RemoveHeader (interestHeader);
+  NS_LOG_LOGIC ("Recv X2 message: INTEREST VM CHUNK " << interestHeader.GetName ());
 
-         if (m_vmMigration > 0)
-         {
-             for (uint32_t i = 0; i < m_paramsRecv.size(); i++)
-             {
-                EpcX2SapUser::UeDataParams params;
+  // the source eNB is the producer of the chunks of the VMs it hosts
+  QueueVmChunk (cellsInfo->m_remoteCellId, interestHeader.GetName ());
+}
 
-                params.sourceCellId = m_paramsRecv[i].sourceCellId;
-                params.targetCellId = m_paramsRecv[i].targetCellId;
-                params.gtpTeid      = m_paramsRecv[i].gtpTeid;
-                params.ueData       = m_ueDataRecv[i];
+void
+EpcX2::DoRecvInterestVmChunkCache (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  ns3::ndn::Interest interestHeader;
+  packet->RemoveHeader (interestHeader);
+  NS_LOG_LOGIC ("Recv X2 message: INTEREST VM CHUNK CACHE " << interestHeader.GetName ());
 
-                NS_LOG_INFO ("SENDING UE DATA FROM TARGET ENB TO UE");
-                m_x2SapUser->RecvUeData (params);
-             }
+  if (epcEnbApp->HasContent (interestHeader.GetName ()))
+    {
+      QueueVmChunk (cellsInfo->m_remoteCellId, interestHeader.GetName ());
+      return;
+    }
 
-         }
-      }
-      else if (messageType == EpcX2Header::IcnMessageSource)
-      {
-          NS_LOG_INFO ("SOURCE ENB RECEIVES ICN MESSAGE. CONFIGURING PIT");
+  NS_LOG_LOGIC ("VM chunk " << interestHeader.GetName () << " not cached, NACK to cell " << cellsInfo->m_remoteCellId);
+  Ptr<X2IfaceInfo> socketInfo = m_x2InterfaceSockets [cellsInfo->m_remoteCellId];
+  Ptr<Packet> nack = Create<Packet> ();
+  nack->AddHeader (interestHeader);
+  GtpuHeader gtpu;
+  gtpu.SetTeid (VM_CHUNK_NACK_TEID);
+  gtpu.SetLength (nack->GetSize () + gtpu.GetSerializedSize () - 8);
+  nack->AddHeader (gtpu);
+  SendOverX2 (cellsInfo->m_remoteCellId, socketInfo->m_localUserPlaneSocket, socketInfo->m_remoteIpAddr, m_x2uUdpPort,
+              nack, X2_CLASS_CONTROL);
+}
 
-          ofstream out ((ccMsgFileRecvSrc.str ()).c_str (), ios::app);
-          out << Simulator::Now ().GetSeconds () << "\n";
+void
+EpcX2::DoRecvStartVmCmd (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  NS_LOG_INFO("Target eNodeB receives Start VM Command");
 
-            if (m_sendUeData.size() > 0)
-            {
-              NS_LOG_INFO ("m_sendUeData");
-
-              uint16_t i = 0;
-
-              for (i = 0; i < m_params.size(); i++)
-              {
-                 if (i == 0)
-                 {
-                     Ptr<Packet> packet = m_ueData[0]->Copy();
-                     Ipv4Header ipv4Header;
-                     packet->RemoveHeader (ipv4Header);
-                     m_icnIpSource = ipv4Header.GetDestination();
-                 }
-                 NS_LOG_INFO ("COUNTER: " << i);
-                 EpcX2SapProvider::UeDataParams params;
-                 params.sourceCellId = m_params[i].sourceCellId;
-                 params.targetCellId = m_params[i].targetCellId;
-                 params.gtpTeid = m_params[i].gtpTeid;
-                 params.ueData = m_ueData[i];
-
-                 Ptr<Packet> packet = m_ueData[i]->Copy();
-                 Ipv4Header ipv4Header;
-                 packet->RemoveHeader (ipv4Header);
-
-                 if (m_icnIpSource == ipv4Header.GetDestination())
-                 {
-                   EpcX2::DoSendUeData2 (params);
-
-                   if(std::find(m_ipBuff.begin(), m_ipBuff.end(), m_icnIpSource)!=m_ipBuff.end())
-                   {
-                       NS_LOG_INFO ("FIND THE SAME ADDRESS IN THE BUFFER");
-                   }
-                   else
-                   {
-                       NS_LOG_INFO ("DON'T FIND THE SAME ADDRESS IN THE BUFFER");
-                       m_ipBuff.push_back(m_icnIpSource);
-                   }
-                 }
-                 else
-                 {
-                     goto skip_loop;
-                 }
-              }
-
-              skip_loop:
-              NS_LOG_INFO ("NILAI i: " << i);
-
-              m_params.erase(m_params.begin(),m_params.begin()+i);
-              m_ueData.erase(m_ueData.begin(),m_ueData.begin()+i);
-
-              m_sendUeData.erase(m_sendUeData.begin(),m_sendUeData.begin()+i);
-            }
-            else
-            {
-               NS_LOG_INFO ("NO m_sendUeData");
-               bool icnMsg = true;
-               m_icnMsgSource.push_back(icnMsg);
-            }
+  Ptr<VmMigrationInfo> migration = FindVmMigrationIn (packet, VmMigrationInfo::RECEIVED);
+  if (migration == 0)
+    {
+      NS_LOG_WARN ("Start VM command without a received VM, ignoring");
+      return;
+    }
 
-      }
-      else if (messageType == EpcX2Header::MigrationRequest)
-      {
-        NS_LOG_INFO("Target eNodeB receives VM migration request");
-        uint16_t  targetCellId = 1;
+  NS_ASSERT_MSG (m_x2InterfaceSockets.find (migration->m_peerCellId) != m_x2InterfaceSockets.end (),
+           "Missing infos for start VM ACK = " << migration->m_peerCellId);
+  Ptr<X2IfaceInfo> socketInfo = m_x2InterfaceSockets [migration->m_peerCellId];
+  Ptr<Socket> sourceSocket = socketInfo->m_localCtrlPlaneSocket;
 
-        NS_ASSERT_MSG (m_x2InterfaceSockets.find (targetCellId) != m_x2InterfaceSockets.end (),
-                 "Missing infos for Migration Request = " << targetCellId);
-        Ptr<X2IfaceInfo> socketInfo = m_x2InterfaceSockets [targetCellId];
-        Ptr<Socket> sourceSocket = socketInfo->m_localCtrlPlaneSocket;
-        Ipv4Address targetIpAddr = socketInfo->m_remoteIpAddr;
+  Ptr<Packet> vmStarted = CreateVmControllerReport (migration);
 
-        EpcX2Header x2Header;
-        x2Header.SetMessageType (EpcX2Header::InterestVm);
-        x2Header.SetProcedureCode (EpcX2Header::HandoverPreparation);
-        x2Header.SetLengthOfIes (1);
-        x2Header.SetNumberOfIes (1);
+  NS_LOG_INFO("ACK VM STARTED SIZE: " << vmStarted->GetSize());
 
-        Ptr<Packet> interestForVm = Create<Packet> (17); // 24 - header
-        interestForVm->AddHeader (x2Header);
+  SendToController (sourceSocket, vmStarted);
+  NS_LOG_INFO("Target eNodeB sends ACK of Start VM Command to the controller");
 
-        NS_LOG_INFO("INTEREST SIZE: " << interestForVm->GetSize());
+  SetVmMigrationState (migration, VmMigrationInfo::STARTED);
+  ++m_vmHosted;
+  m_vmMigrationsIn.erase (((uint32_t) migration->m_peerCellId << 16) | migration->m_migrationId);
+  m_vmMigrationsInFifo.remove (migration);
+}
 
-        sourceSocket->SendTo (interestForVm, 0, InetSocketAddress (targetIpAddr, m_x2cUdpPort));
+void
+EpcX2::DoRecvHandoverRequestAck (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  NS_LOG_LOGIC ("Recv X2 message: HANDOVER REQUEST ACK");
 
-        NS_LOG_INFO("Target eNodeB sends Interest for VM to Source eNodeB");
+  ofstream out ((ackFile.str ()).c_str (), ios::app);
+  out << Simulator::Now ().GetSeconds () << "\n";
 
-      }
-      else if (messageType == EpcX2Header::InterestVm)
-      {
-        NS_LOG_INFO("Source eNodeB receives Interest for VM");
-        SendVm();
-      }
-      else if (messageType == EpcX2Header::StartVmCmd)
-      {
-        NS_LOG_INFO("Target eNodeB receives Start VM Command");
-        uint16_t  targetCellId = 1;
+  EpcX2HandoverRequestAckHeader x2HoReqAckHeader;
+  packet->RemoveHeader (x2HoReqAckHeader);
 
-        NS_ASSERT_MSG (m_x2InterfaceSockets.find (targetCellId) != m_x2InterfaceSockets.end (),
-                 "Missing infos for start VM ACK = " << targetCellId);
-        Ptr<X2IfaceInfo> socketInfo = m_x2InterfaceSockets [targetCellId];
-        Ptr<Socket> sourceSocket = socketInfo->m_localCtrlPlaneSocket;
+  NS_LOG_INFO ("X2 HandoverRequestAck header: " << x2HoReqAckHeader);
 
-        Ptr<Packet> vmStarted = Create<Packet> (6);
+  EpcX2SapUser::HandoverRequestAckParams params;
+  params.oldEnbUeX2apId = x2HoReqAckHeader.GetOldEnbUeX2apId ();
+  params.newEnbUeX2apId = x2HoReqAckHeader.GetNewEnbUeX2apId ();
+  params.sourceCellId   = cellsInfo->m_localCellId;
+  params.targetCellId   = cellsInfo->m_remoteCellId;
+  params.admittedBearers = x2HoReqAckHeader.GetAdmittedBearers ();
+  params.notAdmittedBearers = x2HoReqAckHeader.GetNotAdmittedBearers ();
+  params.rrcContext     = packet;
 
-        NS_LOG_INFO("ACK VM STARTED SIZE: " << vmStarted->GetSize());
+  NS_LOG_LOGIC ("oldEnbUeX2apId = " << params.oldEnbUeX2apId);
+  NS_LOG_LOGIC ("newEnbUeX2apId = " << params.newEnbUeX2apId);
+  NS_LOG_LOGIC ("sourceCellId = " << params.sourceCellId);
+  NS_LOG_LOGIC ("targetCellId = " << params.targetCellId);
 
-        sourceSocket->SendTo (vmStarted, 0, InetSocketAddress (Ipv4Address ("13.0.0.1"), m_x2cUdpPort));
-        NS_LOG_INFO("Target eNodeB sends ACK of Start VM Command to Target eNodeB");
+  m_x2SapUser->RecvHandoverRequestAck (params);
+}
 
-      }
-      else if (messageType == EpcX2Header::SuccessfulOutcome)
-        {
-          NS_LOG_LOGIC ("Recv X2 message: HANDOVER REQUEST ACK");
+void
+EpcX2::DoRecvHandoverPreparationFailure (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  NS_LOG_LOGIC ("Recv X2 message: HANDOVER PREPARATION FAILURE");
 
-          ofstream out ((ackFile.str ()).c_str (), ios::app);
-          out << Simulator::Now ().GetSeconds () << "\n";
+  EpcX2HandoverPreparationFailureHeader x2HoPrepFailHeader;
+  packet->RemoveHeader (x2HoPrepFailHeader);
 
-          EpcX2HandoverRequestAckHeader x2HoReqAckHeader;
-          packet->RemoveHeader (x2HoReqAckHeader);
+  NS_LOG_INFO ("X2 HandoverPreparationFailure header: " << x2HoPrepFailHeader);
 
-          NS_LOG_INFO ("X2 HandoverRequestAck header: " << x2HoReqAckHeader);
+  EpcX2SapUser::HandoverPreparationFailureParams params;
+  params.oldEnbUeX2apId = x2HoPrepFailHeader.GetOldEnbUeX2apId ();
+  params.sourceCellId   = cellsInfo->m_localCellId;
+  params.targetCellId   = cellsInfo->m_remoteCellId;
+  params.cause          = x2HoPrepFailHeader.GetCause ();
+  params.criticalityDiagnostics = x2HoPrepFailHeader.GetCriticalityDiagnostics ();
 
-          EpcX2SapUser::HandoverRequestAckParams params;
-          params.oldEnbUeX2apId = x2HoReqAckHeader.GetOldEnbUeX2apId ();
-          params.newEnbUeX2apId = x2HoReqAckHeader.GetNewEnbUeX2apId ();
-          params.sourceCellId   = cellsInfo->m_localCellId;
-          params.targetCellId   = cellsInfo->m_remoteCellId;
-          params.admittedBearers = x2HoReqAckHeader.GetAdmittedBearers ();
-          params.notAdmittedBearers = x2HoReqAckHeader.GetNotAdmittedBearers ();
-          params.rrcContext     = packet;
+  NS_LOG_LOGIC ("oldEnbUeX2apId = " << params.oldEnbUeX2apId);
+  NS_LOG_LOGIC ("sourceCellId = " << params.sourceCellId);
+  NS_LOG_LOGIC ("targetCellId = " << params.targetCellId);
+  NS_LOG_LOGIC ("cause = " << params.cause);
+  NS_LOG_LOGIC ("criticalityDiagnostics = " << params.criticalityDiagnostics);
 
-          NS_LOG_LOGIC ("oldEnbUeX2apId = " << params.oldEnbUeX2apId);
-          NS_LOG_LOGIC ("newEnbUeX2apId = " << params.newEnbUeX2apId);
-          NS_LOG_LOGIC ("sourceCellId = " << params.sourceCellId);
-          NS_LOG_LOGIC ("targetCellId = " << params.targetCellId);
+  m_x2SapUser->RecvHandoverPreparationFailure (params);
+}
 
-          m_x2SapUser->RecvHandoverRequestAck (params);
-        }
-      else // messageType == EpcX2Header::UnsuccessfulOutcome
-        {
-          NS_LOG_LOGIC ("Recv X2 message: HANDOVER PREPARATION FAILURE");
+void
+EpcX2::DoRecvLoadInformation (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  NS_LOG_LOGIC ("Recv X2 message: LOAD INFORMATION");
 
-          EpcX2HandoverPreparationFailureHeader x2HoPrepFailHeader;
-          packet->RemoveHeader (x2HoPrepFailHeader);
+  EpcX2LoadInformationHeader x2LoadInfoHeader;
+  packet->RemoveHeader (x2LoadInfoHeader);
 
-          NS_LOG_INFO ("X2 HandoverPreparationFailure header: " << x2HoPrepFailHeader);
+  NS_LOG_INFO ("X2 LoadInformation header: " << x2LoadInfoHeader);
 
-          EpcX2SapUser::HandoverPreparationFailureParams params;
-          params.oldEnbUeX2apId = x2HoPrepFailHeader.GetOldEnbUeX2apId ();
-          params.sourceCellId   = cellsInfo->m_localCellId;
-          params.targetCellId   = cellsInfo->m_remoteCellId;
-          params.cause          = x2HoPrepFailHeader.GetCause ();
-          params.criticalityDiagnostics = x2HoPrepFailHeader.GetCriticalityDiagnostics ();
+  EpcX2SapUser::LoadInformationParams params;
+  params.cellInformationList = x2LoadInfoHeader.GetCellInformationList ();
 
-          NS_LOG_LOGIC ("oldEnbUeX2apId = " << params.oldEnbUeX2apId);
-          NS_LOG_LOGIC ("sourceCellId = " << params.sourceCellId);
-          NS_LOG_LOGIC ("targetCellId = " << params.targetCellId);
-          NS_LOG_LOGIC ("cause = " << params.cause);
-          NS_LOG_LOGIC ("criticalityDiagnostics = " << params.criticalityDiagnostics);
+  NS_LOG_LOGIC ("cellInformationList size = " << params.cellInformationList.size ());
 
-          m_x2SapUser->RecvHandoverPreparationFailure (params);
-        }
-    }
-  else if (procedureCode == EpcX2Header::LoadIndication)
+  for (std::vector<EpcX2Sap::CellInformationItem>::iterator it = params.cellInformationList.begin ();
+       it != params.cellInformationList.end ();
+       ++it)
     {
-      if (messageType == EpcX2Header::InitiatingMessage)
+      uint32_t high = 0;
+      for (std::vector<EpcX2Sap::UlInterferenceOverloadIndicationItem>::iterator prbIt = it->ulInterferenceOverloadIndicationList.begin ();
+           prbIt != it->ulInterferenceOverloadIndicationList.end ();
+           ++prbIt)
         {
-          NS_LOG_LOGIC ("Recv X2 message: LOAD INFORMATION");
-
-          EpcX2LoadInformationHeader x2LoadInfoHeader;
-          packet->RemoveHeader (x2LoadInfoHeader);
-
-          NS_LOG_INFO ("X2 LoadInformation header: " << x2LoadInfoHeader);
+          if (*prbIt == EpcX2Sap::HighInterference)
+            {
+              ++high;
+            }
+        }
+      X2NeighborLoad &load = m_x2NeighborLoad[it->sourceCellId];
+      load.m_interferenceLoad = it->ulInterferenceOverloadIndicationList.empty ()
+        ? 0 : (double) high / it->ulInterferenceOverloadIndicationList.size ();
+      load.m_lastUpdate = Simulator::Now ();
+    }
 
-          EpcX2SapUser::LoadInformationParams params;
-          params.cellInformationList = x2LoadInfoHeader.GetCellInformationList ();
+  m_x2SapUser->RecvLoadInformation (params);
+}
 
-          NS_LOG_LOGIC ("cellInformationList size = " << params.cellInformationList.size ());
+void
+EpcX2::DoRecvSnStatusTransfer (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  NS_LOG_LOGIC ("Recv X2 message: SN STATUS TRANSFER");
 
-          m_x2SapUser->RecvLoadInformation (params);
-        }
-    }
-  else if (procedureCode == EpcX2Header::SnStatusTransfer)
-    {
-      if (messageType == EpcX2Header::InitiatingMessage)
-        {
-          NS_LOG_LOGIC ("Recv X2 message: SN STATUS TRANSFER");
+  EpcX2SnStatusTransferHeader x2SnStatusXferHeader;
+  packet->RemoveHeader (x2SnStatusXferHeader);
 
-            EpcX2SnStatusTransferHeader x2SnStatusXferHeader;
-            packet->RemoveHeader (x2SnStatusXferHeader);
+  NS_LOG_INFO ("X2 SnStatusTransfer header: " << x2SnStatusXferHeader);
 
-            NS_LOG_INFO ("X2 SnStatusTransfer header: " << x2SnStatusXferHeader);
+  EpcX2SapUser::SnStatusTransferParams params;
+  params.oldEnbUeX2apId = x2SnStatusXferHeader.GetOldEnbUeX2apId ();
+  params.newEnbUeX2apId = x2SnStatusXferHeader.GetNewEnbUeX2apId ();
+  params.sourceCellId   = cellsInfo->m_remoteCellId;
+  params.targetCellId   = cellsInfo->m_localCellId;
+  params.erabsSubjectToStatusTransferList = x2SnStatusXferHeader.GetErabsSubjectToStatusTransferList ();
 
-            EpcX2SapUser::SnStatusTransferParams params;
-            params.oldEnbUeX2apId = x2SnStatusXferHeader.GetOldEnbUeX2apId ();
-            params.newEnbUeX2apId = x2SnStatusXferHeader.GetNewEnbUeX2apId ();
-            params.sourceCellId   = cellsInfo->m_remoteCellId;
-            params.targetCellId   = cellsInfo->m_localCellId;
-            params.erabsSubjectToStatusTransferList = x2SnStatusXferHeader.GetErabsSubjectToStatusTransferList ();
+  NS_LOG_LOGIC ("oldEnbUeX2apId = " << params.oldEnbUeX2apId);
+  NS_LOG_LOGIC ("newEnbUeX2apId = " << params.newEnbUeX2apId);
+  NS_LOG_LOGIC ("sourceCellId = " << params.sourceCellId);
+  NS_LOG_LOGIC ("targetCellId = " << params.targetCellId);
+  NS_LOG_LOGIC ("erabsList size = " << params.erabsSubjectToStatusTransferList.size ());
 
-            NS_LOG_LOGIC ("oldEnbUeX2apId = " << params.oldEnbUeX2apId);
-            NS_LOG_LOGIC ("newEnbUeX2apId = " << params.newEnbUeX2apId);
-            NS_LOG_LOGIC ("sourceCellId = " << params.sourceCellId);
-            NS_LOG_LOGIC ("targetCellId = " << params.targetCellId);
-            NS_LOG_LOGIC ("erabsList size = " << params.erabsSubjectToStatusTransferList.size ());
+  m_x2SapUser->RecvSnStatusTransfer (params);
+}
 
-            m_x2SapUser->RecvSnStatusTransfer (params);
-        }
-    }
-  else if (procedureCode == EpcX2Header::UeContextRelease)
-    {
-      if (messageType == EpcX2Header::InitiatingMessage)
-        {
-          NS_LOG_LOGIC ("Recv X2 message: UE CONTEXT RELEASE");
+void
+EpcX2::DoRecvUeContextRelease (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  NS_LOG_LOGIC ("Recv X2 message: UE CONTEXT RELEASE");
 
-          EpcX2UeContextReleaseHeader x2UeCtxReleaseHeader;
-          packet->RemoveHeader (x2UeCtxReleaseHeader);
+  EpcX2UeContextReleaseHeader x2UeCtxReleaseHeader;
+  packet->RemoveHeader (x2UeCtxReleaseHeader);
 
-          NS_LOG_INFO ("X2 UeContextRelease header: " << x2UeCtxReleaseHeader);
+  NS_LOG_INFO ("X2 UeContextRelease header: " << x2UeCtxReleaseHeader);
 
-          EpcX2SapUser::UeContextReleaseParams params;
-          params.oldEnbUeX2apId = x2UeCtxReleaseHeader.GetOldEnbUeX2apId ();
-          params.newEnbUeX2apId = x2UeCtxReleaseHeader.GetNewEnbUeX2apId ();
+  EpcX2SapUser::UeContextReleaseParams params;
+  params.oldEnbUeX2apId = x2UeCtxReleaseHeader.GetOldEnbUeX2apId ();
+  params.newEnbUeX2apId = x2UeCtxReleaseHeader.GetNewEnbUeX2apId ();
 
-          NS_LOG_LOGIC ("oldEnbUeX2apId = " << params.oldEnbUeX2apId);
-          NS_LOG_LOGIC ("newEnbUeX2apId = " << params.newEnbUeX2apId);
+  NS_LOG_LOGIC ("oldEnbUeX2apId = " << params.oldEnbUeX2apId);
+  NS_LOG_LOGIC ("newEnbUeX2apId = " << params.newEnbUeX2apId);
 
-//          if (m_icnMessage)
-//          {
-//             m_x2SapUser->RecvUeContextRelease (params);
-//             m_icnMessage = false;
-//          }
-//          else
-//          {
-//             m_params2.push_back(params);
-//             m_contextRelease = true;
-//          }
+  m_x2SapUser->RecvUeContextRelease (params);
+}
 
-          m_x2SapUser->RecvUeContextRelease (params);
-        }
-    }
-  else if (procedureCode == EpcX2Header::ResourceStatusReporting)
-    {
-      if (messageType == EpcX2Header::InitiatingMessage)
-        {
-          NS_LOG_LOGIC ("Recv X2 message: RESOURCE STATUS UPDATE");
+void
+EpcX2::DoRecvResourceStatusUpdate (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo)
+{
+  NS_LOG_LOGIC ("Recv X2 message: RESOURCE STATUS UPDATE");
 
-          EpcX2ResourceStatusUpdateHeader x2ResStatUpdHeader;
-          packet->RemoveHeader (x2ResStatUpdHeader);
+  EpcX2ResourceStatusUpdateHeader x2ResStatUpdHeader;
+  packet->RemoveHeader (x2ResStatUpdHeader);
 
-          NS_LOG_INFO ("X2 ResourceStatusUpdate header: " << x2ResStatUpdHeader);
+  NS_LOG_INFO ("X2 ResourceStatusUpdate header: " << x2ResStatUpdHeader);
 
-          EpcX2SapUser::ResourceStatusUpdateParams params;
-          params.enb1MeasurementId = x2ResStatUpdHeader.GetEnb1MeasurementId ();
-          params.enb2MeasurementId = x2ResStatUpdHeader.GetEnb2MeasurementId ();
-          params.cellMeasurementResultList = x2ResStatUpdHeader.GetCellMeasurementResultList ();
+  EpcX2SapUser::ResourceStatusUpdateParams params;
+  params.enb1MeasurementId = x2ResStatUpdHeader.GetEnb1MeasurementId ();
+  params.enb2MeasurementId = x2ResStatUpdHeader.GetEnb2MeasurementId ();
+  params.cellMeasurementResultList = x2ResStatUpdHeader.GetCellMeasurementResultList ();
 
-          NS_LOG_LOGIC ("enb1MeasurementId = " << params.enb1MeasurementId);
-          NS_LOG_LOGIC ("enb2MeasurementId = " << params.enb2MeasurementId);
-          NS_LOG_LOGIC ("cellMeasurementResultList size = " << params.cellMeasurementResultList.size ());
+  NS_LOG_LOGIC ("enb1MeasurementId = " << params.enb1MeasurementId);
+  NS_LOG_LOGIC ("enb2MeasurementId = " << params.enb2MeasurementId);
+  NS_LOG_LOGIC ("cellMeasurementResultList size = " << params.cellMeasurementResultList.size ());
 
-          m_x2SapUser->RecvResourceStatusUpdate (params);
-        }
-    }
-  else
+  for (std::vector<EpcX2Sap::CellMeasurementResultItem>::iterator it = params.cellMeasurementResultList.begin ();
+       it != params.cellMeasurementResultList.end ();
+       ++it)
     {
-      NS_ASSERT_MSG (false, "ProcedureCode NOT SUPPORTED!!!");
+      // LowLoad .. Overload map to 0 .. 1, and so does the capacity in use
+      double hardwareLoad = std::max (it->dlHardwareLoadIndicator, it->ulHardwareLoadIndicator) / 3.0;
+      double capacityLoad = 1 - std::min (it->dlCompositeAvailableCapacity.capacityValue,
+                                          it->ulCompositeAvailableCapacity.capacityValue) / 100.0;
+      X2NeighborLoad &load = m_x2NeighborLoad[it->sourceCellId];
+      load.m_resourceLoad = std::max (hardwareLoad, capacityLoad);
+      load.m_lastUpdate = Simulator::Now ();
+      NS_LOG_LOGIC ("load of cell " << it->sourceCellId << " = " << load.m_resourceLoad);
     }
+
+  m_x2SapUser->RecvResourceStatusUpdate (params);
 }
 
 void
@@ -612,12 +2441,13 @@ EpcX2::RecvFromX2uSocket (Ptr<Socket> socket)
     NS_LOG_FUNCTION (this << socket);
 
     NS_LOG_LOGIC ("Recv UE DATA through X2-U interface from Socket");
-    Ptr<Packet> packet = socket->Recv ();
+    Address from;
+    Ptr<Packet> packet = socket->RecvFrom (from);
     NS_LOG_LOGIC ("packetLen = " << packet->GetSize ());
 
-    NS_ASSERT_MSG (m_x2InterfaceCellIds.find (socket) != m_x2InterfaceCellIds.end (),
-                 "Missing infos of local and remote CellId");
-    Ptr<X2CellInfo> cellsInfo = m_x2InterfaceCellIds [socket];
+    Ptr<X2CellInfo> cellsInfo = GetX2CellInfo (socket, from);
+    NS_ASSERT_MSG (cellsInfo != 0, "Missing infos of local and remote CellId");
+    m_x2InterfaceSockets [cellsInfo->m_remoteCellId]->m_lastUse = Simulator::Now ();
 
     GtpuHeader gtpu;
     packet->RemoveHeader (gtpu);
@@ -634,37 +2464,45 @@ EpcX2::RecvFromX2uSocket (Ptr<Socket> socket)
   }
   else
   {
-    Ptr<Packet> packet = socket->Recv ();
-    NS_ASSERT_MSG (m_x2InterfaceCellIds.find (socket) != m_x2InterfaceCellIds.end (),
-                 "Missing infos of local and remote CellId in VM migration");
-    Ptr<X2CellInfo> cellsInfo = m_x2InterfaceCellIds [socket];
+    Address from;
+    Ptr<Packet> packet = socket->RecvFrom (from);
+    Ptr<X2CellInfo> cellsInfo = GetX2CellInfo (socket, from);
+    NS_ASSERT_MSG (cellsInfo != 0, "Missing infos of local and remote CellId in VM migration");
+    m_x2InterfaceSockets [cellsInfo->m_remoteCellId]->m_lastUse = Simulator::Now ();
 
     GtpuHeader gtpu;
     packet->RemoveHeader (gtpu);
 
-    if (gtpu.GetTeid () == 9999)
+    if (gtpu.GetTeid () == VM_CHUNK_CONTENT_TEID)
     {
-        m_targetCounter++;
-
-        if (m_targetCounter == m_numOfPacket)
+        RecvVmChunk (packet);
+    }
+    else if (gtpu.GetTeid () == VM_CHUNK_NACK_TEID)
+    {
+        RecvVmChunkNack (packet);
+    }
+    else if ((gtpu.GetTeid () & VM_TEID_MASK) == VM_TEID_PREFIX)
+    {
+        uint16_t migrationId = gtpu.GetTeid () & ~VM_TEID_MASK;
+        std::map<uint32_t, Ptr<VmMigrationInfo> >::iterator migrationIt
+          = m_vmMigrationsIn.find (((uint32_t) cellsInfo->m_remoteCellId << 16) | migrationId);
+        if (migrationIt == m_vmMigrationsIn.end ())
         {
-           ofstream outvm ((vmFileRecv.str ()).c_str (), ios::app);
-           outvm << Simulator::Now ().GetSeconds () << "\n";
-           NS_LOG_INFO ("ALL CHUNKS OF VM HAS BEEN RECEIVED BY TARGET ENB");
-           NS_LOG_INFO ("NUMBER OF CHUNKS: " << m_targetCounter);
-
-            uint16_t  targetCellId = 1;
-
-            NS_ASSERT_MSG (m_x2InterfaceSockets.find (targetCellId) != m_x2InterfaceSockets.end (),
-                 "Missing infos for Migration Completed = " << targetCellId);
-            Ptr<X2IfaceInfo> socketInfo = m_x2InterfaceSockets [targetCellId];
-            Ptr<Socket> sourceSocket = socketInfo->m_localCtrlPlaneSocket;
-
-            Ptr<Packet> vmMigCompleted = Create<Packet> (6);
+           NS_LOG_WARN ("VM chunk for unknown migration " << migrationId << " from cell " << cellsInfo->m_remoteCellId);
+           return;
+        }
+        Ptr<VmMigrationInfo> migration = migrationIt->second;
 
-            NS_LOG_INFO ("INFORM VCP THAT VM HAS BEEN MIGRATED SUCCESSFULLY");
+        if (migration->m_chunks == 0)
+        {
+           migration->m_startTime = Simulator::Now ();
+           SetVmMigrationState (migration, VmMigrationInfo::RECEIVING);
+        }
+        migration->m_chunks++;
 
-            sourceSocket->SendTo (vmMigCompleted, 0, InetSocketAddress (Ipv4Address ("13.0.0.1"), m_x2cUdpPort));
+        if (migration->m_chunks == m_numOfPacket)
+        {
+           VmMigrationReceived (migration);
         }
 
     }
@@ -701,9 +2539,16 @@ EpcX2::DoSendHandoverRequest (EpcX2SapProvider::HandoverRequestParams params)
   NS_LOG_LOGIC ("targetCellId = " << params.targetCellId);
   NS_LOG_LOGIC ("mmeUeS1apId  = " << params.mmeUeS1apId);
 
+  if (m_x2InterfaceSockets.find (params.targetCellId) == m_x2InterfaceSockets.end ()
+      && !m_x2InterfaceRequestCallback.IsNull ())
+    {
+      // first handover towards this neighbor: set up the X2 interface now
+      m_x2InterfaceRequestCallback (params.sourceCellId, params.targetCellId);
+    }
   NS_ASSERT_MSG (m_x2InterfaceSockets.find (params.targetCellId) != m_x2InterfaceSockets.end (),
                  "Missing infos for targetCellId = " << params.targetCellId);
   Ptr<X2IfaceInfo> socketInfo = m_x2InterfaceSockets [params.targetCellId];
+  socketInfo->m_lastUse = Simulator::Now ();
   Ptr<Socket> sourceSocket = socketInfo->m_localCtrlPlaneSocket;
   Ipv4Address targetIpAddr = socketInfo->m_remoteIpAddr;
 
@@ -737,8 +2582,68 @@ EpcX2::DoSendHandoverRequest (EpcX2SapProvider::HandoverRequestParams params)
   packet->AddHeader (x2Header);
   NS_LOG_INFO ("packetLen = " << packet->GetSize ());
 
+  // the PIT entries and the predicted cell of the UE travel in the same
+  // bundle, right after the request
+  Ptr<Packet> pitTransfer = (epcEnbApp != 0) ? epcEnbApp->GetPitTransfer (params.oldEnbUeX2apId) : 0; // new
+  uint16_t predictedCellId = 0; // new
+  std::map<uint64_t, uint16_t>::iterator predictedIt = m_vmPredictedCell.find (params.mmeUeS1apId);
+  if (predictedIt != m_vmPredictedCell.end ())
+    {
+      // the prediction leaves with the context of the UE
+      predictedCellId = predictedIt->second;
+      m_vmPredictedCell.erase (predictedIt);
+    }
+  bool bundle = (pitTransfer != 0 || predictedCellId != 0);
+  if (bundle)
+    {
+      BeginX2Bundle (params.targetCellId);
+    }
+
   // Send the X2 message through the socket
-  sourceSocket->SendTo (packet, 0, InetSocketAddress (targetIpAddr, m_x2cUdpPort));
+  SendOverX2 (params.targetCellId, sourceSocket, targetIpAddr, m_x2cUdpPort, packet, X2_CLASS_CONTROL);
+
+  if (pitTransfer != 0) // new
+    {
+      NS_LOG_INFO ("Send X2 message: PIT TRANSFER");
+      uint8_t buf[2];
+      buf[0] = params.oldEnbUeX2apId >> 8;
+      buf[1] = params.oldEnbUeX2apId & 0xff;
+      Ptr<Packet> pitPacket = Create<Packet> (buf, 2);
+      pitPacket->AddAtEnd (pitTransfer);
+
+      EpcX2Header pitHeader;
+      pitHeader.SetMessageType (EpcX2Header::PitTransfer);
+      pitHeader.SetProcedureCode (EpcX2Header::HandoverPreparation);
+      pitHeader.SetLengthOfIes (2);
+      pitHeader.SetNumberOfIes (2);
+      pitPacket->AddHeader (pitHeader);
+
+      SendOverX2 (params.targetCellId, sourceSocket, targetIpAddr, m_x2cUdpPort, pitPacket, X2_CLASS_CONTROL);
+    }
+
+  if (predictedCellId != 0) // new
+    {
+      NS_LOG_INFO ("Send X2 message: VM PREDICTION " << predictedCellId);
+      uint8_t buf[4];
+      buf[0] = params.oldEnbUeX2apId >> 8;
+      buf[1] = params.oldEnbUeX2apId & 0xff;
+      buf[2] = predictedCellId >> 8;
+      buf[3] = predictedCellId & 0xff;
+      Ptr<Packet> predictionPacket = Create<Packet> (buf, 4);
+
+      EpcX2Header predictionHeader;
+      predictionHeader.SetMessageType (EpcX2Header::VmPrediction);
+      predictionHeader.SetProcedureCode (EpcX2Header::HandoverPreparation);
+      predictionHeader.SetLengthOfIes (2);
+      predictionHeader.SetNumberOfIes (2);
+      predictionPacket->AddHeader (predictionHeader);
+
+      SendOverX2 (params.targetCellId, sourceSocket, targetIpAddr, m_x2cUdpPort, predictionPacket, X2_CLASS_CONTROL);
+    }
+  if (bundle)
+    {
+      EndX2Bundle (params.targetCellId);
+    }
 
   m_ipv4Address = Ipv4Address ("192.168.100.10"); // new
 }
@@ -790,19 +2695,51 @@ EpcX2::DoSendHandoverRequestAck (EpcX2SapProvider::HandoverRequestAckParams para
   NS_LOG_INFO ("packetLen = " << packet->GetSize ());
 
   // Send the X2 message through the socket
-  localSocket->SendTo (packet, 0, InetSocketAddress (remoteIpAddr, m_x2cUdpPort));
+  SendOverX2 (params.sourceCellId, localSocket, remoteIpAddr, m_x2cUdpPort, packet, X2_CLASS_CONTROL);
+
+  m_handoverRntis[((uint32_t) params.sourceCellId << 16) | params.oldEnbUeX2apId] = params.newEnbUeX2apId; // new
+
+  std::map<uint32_t, uint64_t>::iterator imsiIt
+    = m_handoverImsis.find (((uint32_t) params.sourceCellId << 16) | params.oldEnbUeX2apId);
+  if (imsiIt != m_handoverImsis.end ())
+    {
+      m_icnPendingImsis[((uint32_t) params.sourceCellId << 16) | params.newEnbUeX2apId] = imsiIt->second;
+      m_handoverImsis.erase (imsiIt);
+    }
 
-  // create a packet
+  std::map<uint16_t, X2Bundle>::iterator bundleIt = m_x2Bundles.find (params.sourceCellId);
+  if (bundleIt != m_x2Bundles.end () && bundleIt->second.m_depth > 0)
+    {
+      // the controller is notified of all the handovers of the bundle at once
+      bundleIt->second.m_handovers.push_back (params.newEnbUeX2apId);
+    }
+  else
+    {
+      // create a packet
 
-  NS_LOG_INFO("Target eNodeB Sends Client Info to VCP node");
+      NS_LOG_INFO("Target eNodeB Sends Client Info to VCP node");
 
-  Ptr<Packet> packetPit = Create<Packet> (13);
+      Ptr<Packet> packetPit = CreateControllerNotification (params.sourceCellId,
+                                                            std::list<uint16_t> (1, params.newEnbUeX2apId), 13);
 
-  localSocket->SendTo (packetPit, 0, InetSocketAddress (Ipv4Address ("13.0.0.1"), m_x2cUdpPort));
+      SendToController (localSocket, packetPit);
 
-  ofstream out ((ccMsgFileSent.str ()).c_str (), ios::app);
-  out << Simulator::Now ().GetSeconds () << "\n";
+      ofstream out ((ccMsgFileSent.str ()).c_str (), ios::app);
+      out << Simulator::Now ().GetSeconds () << "\n";
+    }
 
+  if (m_vmMigration > 0)
+    {
+      // the VM of the UE follows it: wait for the controller to request it
+      uint32_t key = ((uint32_t) params.sourceCellId << 16) | params.newEnbUeX2apId;
+      if (m_vmMigrationsIn.find (key) == m_vmMigrationsIn.end ())
+        {
+          Ptr<VmMigrationInfo> migration = Create<VmMigrationInfo> (params.sourceCellId, params.newEnbUeX2apId);
+          m_vmMigrationsIn[key] = migration;
+          m_vmMigrationsInFifo.push_back (migration);
+          SetVmMigrationState (migration, VmMigrationInfo::PREPARED);
+        }
+    }
 }
 
 
@@ -817,6 +2754,8 @@ EpcX2::DoSendHandoverPreparationFailure (EpcX2SapProvider::HandoverPreparationFa
   NS_LOG_LOGIC ("cause = " << params.cause);
   NS_LOG_LOGIC ("criticalityDiagnostics = " << params.criticalityDiagnostics);
 
+  m_handoverImsis.erase (((uint32_t) params.sourceCellId << 16) | params.oldEnbUeX2apId);
+
   NS_ASSERT_MSG (m_x2InterfaceSockets.find (params.sourceCellId) != m_x2InterfaceSockets.end (),
                  "Socket infos not defined for sourceCellId = " << params.sourceCellId);
 
@@ -850,7 +2789,7 @@ EpcX2::DoSendHandoverPreparationFailure (EpcX2SapProvider::HandoverPreparationFa
   NS_LOG_INFO ("packetLen = " << packet->GetSize ());
 
   // Send the X2 message through the socket
-  localSocket->SendTo (packet, 0, InetSocketAddress (remoteIpAddr, m_x2cUdpPort));
+  SendOverX2 (params.sourceCellId, localSocket, remoteIpAddr, m_x2cUdpPort, packet, X2_CLASS_CONTROL);
 }
 
 
@@ -898,7 +2837,7 @@ EpcX2::DoSendSnStatusTransfer (EpcX2SapProvider::SnStatusTransferParams params)
   NS_LOG_INFO ("packetLen = " << packet->GetSize ());
 
   // Send the X2 message through the socket
-  localSocket->SendTo (packet, 0, InetSocketAddress (remoteIpAddr, m_x2cUdpPort));
+  SendOverX2 (params.targetCellId, localSocket, remoteIpAddr, m_x2cUdpPort, packet, X2_CLASS_CONTROL);
 }
 
 
@@ -911,6 +2850,8 @@ EpcX2::DoSendUeContextRelease (EpcX2SapProvider::UeContextReleaseParams params)
   NS_LOG_LOGIC ("newEnbUeX2apId = " << params.newEnbUeX2apId);
   NS_LOG_LOGIC ("sourceCellId = " << params.sourceCellId);
 
+  m_handoverRntis.erase (((uint32_t) params.sourceCellId << 16) | params.oldEnbUeX2apId); // new
+
   NS_ASSERT_MSG (m_x2InterfaceSockets.find (params.sourceCellId) != m_x2InterfaceSockets.end (),
                  "Socket infos not defined for sourceCellId = " << params.sourceCellId);
 
@@ -943,7 +2884,7 @@ EpcX2::DoSendUeContextRelease (EpcX2SapProvider::UeContextReleaseParams params)
   NS_LOG_INFO ("packetLen = " << packet->GetSize ());
 
   // Send the X2 message through the socket
-  localSocket->SendTo (packet, 0, InetSocketAddress (remoteIpAddr, m_x2cUdpPort));
+  SendOverX2 (params.sourceCellId, localSocket, remoteIpAddr, m_x2cUdpPort, packet, X2_CLASS_CONTROL);
 }
 
 void
@@ -985,7 +2926,7 @@ EpcX2::DoSendLoadInformation (EpcX2SapProvider::LoadInformationParams params)
   NS_LOG_INFO ("packetLen = " << packet->GetSize ());
 
   // Send the X2 message through the socket
-  sourceSocket->SendTo (packet, 0, InetSocketAddress (targetIpAddr, m_x2cUdpPort));
+  SendOverX2 (params.targetCellId, sourceSocket, targetIpAddr, m_x2cUdpPort, packet, X2_CLASS_CONTROL);
 
 }
 
@@ -1033,7 +2974,7 @@ EpcX2::DoSendResourceStatusUpdate (EpcX2SapProvider::ResourceStatusUpdateParams
   NS_LOG_INFO ("packetLen = " << packet->GetSize ());
 
   // Send the X2 message through the socket
-  sourceSocket->SendTo (packet, 0, InetSocketAddress (targetIpAddr, m_x2cUdpPort));
+  SendOverX2 (params.targetCellId, sourceSocket, targetIpAddr, m_x2cUdpPort, packet, X2_CLASS_CONTROL);
 
 }
 
@@ -1126,7 +3067,7 @@ EpcX2::DoSendUeData2 (EpcX2SapProvider::UeDataParams params)
   packet->AddHeader (gtpu);
 
   NS_LOG_INFO ("Forward UE DATA through X2 interface");
-  sourceSocket->SendTo (packet, 0, InetSocketAddress (targetIpAddr, m_x2uUdpPort));
+  SendOverX2 (params.targetCellId, sourceSocket, targetIpAddr, m_x2uUdpPort, packet, X2_CLASS_UE_DATA);
 }
 
 } // namespace ns3
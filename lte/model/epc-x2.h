@@ -25,12 +25,20 @@
 #include "ns3/callback.h"
 #include "ns3/ptr.h"
 #include "ns3/object.h"
+#include "ns3/traced-callback.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
 #include "ns3/epc-x2-sap.h"
 #include "ns3/epc-enb-application.h" // edit
+#include "ns3/lte-rrc-sap.h" // new
 #include <iostream> // edit
 #include <fstream>  // edit
 
 #include <map>
+#include <list>
 
 using namespace std;
 
@@ -49,6 +57,7 @@ public:
   Ipv4Address   m_remoteIpAddr;
   Ptr<Socket>   m_localCtrlPlaneSocket;
   Ptr<Socket>   m_localUserPlaneSocket;
+  Time          m_lastUse; // new
 };
 
 
@@ -66,6 +75,43 @@ public:
 };
 
 
+/**
+ * State of the migration of the VM of a UE between two eNBs. The source eNB
+ * identifies it by (target cell id, migration id) and the target eNB by
+ * (source cell id, migration id), the migration id being the UE X2AP id
+ * allocated by the target eNB.
+ */
+class VmMigrationInfo : public SimpleRefCount<VmMigrationInfo>
+{
+public:
+  enum State_t
+  {
+    PREPARED,   ///< target: handover accepted, waiting for the controller
+    REQUESTED,  ///< target: VM requested to the source eNB
+    RECEIVING,  ///< target: first chunk received
+    RECEIVED,   ///< target: all chunks received, controller notified
+    STARTED,    ///< target: VM started by the controller
+    SENDING,    ///< source: first chunk sent
+    SENT,       ///< source: all chunks sent
+    PLACED      ///< target: VM placed on another neighbor
+  };
+
+  VmMigrationInfo (uint16_t peerCellId, uint16_t migrationId);
+  virtual ~VmMigrationInfo (void);
+
+public:
+  uint16_t m_peerCellId;
+  uint16_t m_migrationId;
+  uint32_t m_chunks;
+  Time     m_startTime;
+  State_t  m_state;
+  uint32_t m_nextChunk;   ///< target, named chunks: next chunk to be requested
+  uint32_t m_outstanding; ///< target, named chunks: chunks requested and not received yet
+  uint16_t m_predictedCellId; ///< target: cell the UE is predicted to be served by, 0 if unknown
+  uint16_t m_handoverCellId;  ///< target: cell the UE is handed over to, 0 if this cell
+};
+
+
 /**
  * \ingroup lte
  *
@@ -110,6 +156,36 @@ public:
    */
   void AddX2Interface (uint16_t enb1CellId, Ipv4Address enb1X2Address, uint16_t enb2CellId, Ipv4Address enb2X2Address);
 
+  /**
+   * Remove the X2 interface towards the given cell, closing its sockets
+   * unless they are shared with the other neighbors
+   *
+   * \param remoteCellId the cell id of the peer eNB
+   */
+  void RemoveX2Interface (uint16_t remoteCellId);
+
+  /**
+   * \param remoteCellId the cell id of the peer eNB
+   * \return true if an X2 interface towards the given cell exists
+   */
+  bool HasX2Interface (uint16_t remoteCellId) const;
+
+  /**
+   * \param remoteCellId the cell id of the peer eNB
+   * \return the last time a message was sent or received over the X2
+   * interface towards the given cell
+   */
+  Time GetX2InterfaceLastUse (uint16_t remoteCellId) const;
+
+  /**
+   * Callback invoked with (local cell id, remote cell id) when a handover
+   * is requested towards a cell with no X2 interface yet. It is expected to
+   * set up the X2 interface before returning.
+   */
+  typedef Callback<void, uint16_t, uint16_t> X2InterfaceRequestCallback;
+
+  void SetX2InterfaceRequestCallback (X2InterfaceRequestCallback cb);
+
 
   /**
    * Method to be assigned to the recv callback of the X2-C (X2 Control Plane) socket.
@@ -129,7 +205,126 @@ public:
 
   void GetEpcEnbApplication (Ptr<EpcEnbApplication> enb); // new
 
-  void SendVm (); // new
+  /**
+   * Send the next VM chunk towards the given cell, serving in round robin the
+   * migrations sharing the X2 link
+   *
+   * \param targetCellId the cell id of the target eNB
+   */
+  void SendVm (uint16_t targetCellId); // new
+
+  /**
+   * Send a CS entry to the target eNB of a handover through the X2-C interface
+   *
+   * \param targetCellId the cell id of the target eNB
+   * \param cs the CS entry to be migrated
+   */
+  void SendCsEntry (uint16_t targetCellId, CsEps_t cs); // new
+
+  /**
+   * Print, for every registered X2-C handler, the number of messages handled,
+   * and among them those received inside an X2 bundle
+   *
+   * \param os the output stream
+   */
+  void PrintX2cStats (std::ostream &os) const;
+
+  /**
+   * Print, for every registered X2-C handler, the histogram of the wall-clock
+   * handling time measured with X2cProfiling, the time spent in the handlers
+   * of the messages of a bundle being excluded from that of the bundle
+   *
+   * \param os the output stream
+   */
+  void PrintX2cProfile (std::ostream &os) const;
+
+  /**
+   * Sink of the RecvMeasurementReport trace of the RRC of the eNB, keeping
+   * the cell each UE is predicted to be served by next: the strongest
+   * reported cell, the serving cell included. The prediction is sent to the
+   * target eNB with the handover request of the UE.
+   *
+   * \param imsi the IMSI of the UE
+   * \param cellId the serving cell id
+   * \param rnti the RNTI of the UE
+   * \param report the measurement report
+   */
+  void RecvMeasurementReport (uint64_t imsi, uint16_t cellId, uint16_t rnti, LteRrcSap::MeasurementReport report); // new
+
+  /**
+   * Estimate the response latency a VM would offer if it were placed on the
+   * given cell: the service time inflated by the load of the cell, the X2
+   * hop when the cell does not serve the UE, and the transfer of the VM over
+   * X2 amortized over VmPlacementHorizon requests
+   *
+   * \param cellId the candidate cell, this eNB or an X2 neighbor
+   * \param predictedCellId the cell the UE is expected to be served by
+   * \param latency the estimated latency
+   * \return false if the candidate is unknown, its load report is older
+   * than VmNeighborLoadMaxAge, or it is overloaded
+   */
+  bool EstimateVmResponseLatency (uint16_t cellId, uint16_t predictedCellId, Time &latency) const; // new
+
+  /**
+   * \param predictedCellId the cell the UE is expected to be served by
+   * \return the cell, among this eNB and the X2 neighbors with a recent
+   * load report, where a VM gets the lowest estimated response latency
+   */
+  uint16_t SelectVmPlacement (uint16_t predictedCellId) const; // new
+
+  /**
+   * Open a bundle towards an X2 neighbor. Until the matching EndX2Bundle,
+   * the X2-C messages for the neighbor are collected instead of being sent,
+   * and the handover notifications for the controller are merged. Bundles
+   * can be nested.
+   *
+   * \param cellId the cell id of the neighbor
+   */
+  void BeginX2Bundle (uint16_t cellId); // new
+
+  /**
+   * Close a bundle opened by BeginX2Bundle. When the outermost bundle is
+   * closed, the collected messages are sent as X2Bundle messages of at most
+   * MaxBundleSize bytes each, the controller receives one notification for all the handovers
+   * accepted meanwhile. The path switch requests of these handovers are
+   * still sent one per UE by the eNB application.
+   *
+   * \param cellId the cell id of the neighbor
+   */
+  void EndX2Bundle (uint16_t cellId); // new
+
+  /**
+   * Where a named VM chunk was fetched from
+   */
+  enum VmChunkSource_t
+  {
+    VM_CHUNK_LOCAL_CACHE,   ///< CS of the target eNB
+    VM_CHUNK_GATEWAY_CACHE, ///< CS of the SGW/PGW
+    VM_CHUNK_PEER,          ///< source eNB, over X2
+    VM_CHUNK_NEIGHBOR       ///< CS of another X2 neighbor
+  };
+
+  /**
+   * Traffic classes sharing the X2 link towards a neighbor, in decreasing
+   * priority order
+   */
+  enum X2TrafficClass_t
+  {
+    X2_CLASS_CONTROL = 0, ///< X2-C messages and VM chunk Interests/NACKs
+    X2_CLASS_UE_DATA,     ///< UE data forwarded during handover and CS migration
+    X2_CLASS_BULK,        ///< VM chunks
+    X2_N_CLASSES
+  };
+
+  /**
+   * How the traffic classes share the X2 link
+   */
+  enum X2Scheduler_t
+  {
+    X2_SCHED_NONE,     ///< no queueing, the packets are sent as soon as they are generated
+    X2_SCHED_PRIORITY, ///< strict priority between the classes
+    X2_SCHED_DRR       ///< deficit round robin, weighted by the per-class quantum
+  };
 
 protected:
   // Interface provided by EpcX2SapProvider
@@ -149,6 +344,257 @@ protected:
 
 private:
 
+  /**
+   * Handler of a received X2-C message. The packet has the X2 header
+   * already removed.
+   */
+  typedef void (EpcX2::*X2cHandler) (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo);
+
+  /**
+   * Register the handler of the X2-C messages with the given procedure code
+   * and message type
+   *
+   * \param procedureCode the X2 procedure code
+   * \param messageType the X2 message type
+   * \param name the name of the handler, used in the statistics
+   * \param handler the handler
+   * \param fromPeer true if the message can only be sent by an X2 peer, false
+   * if it can come from the controller as well
+   */
+  void RegisterX2cHandler (uint8_t procedureCode, uint8_t messageType, std::string name, X2cHandler handler, bool fromPeer);
+
+  static uint16_t GetX2cHandlerKey (uint8_t procedureCode, uint8_t messageType);
+
+  /**
+   * Hand an X2-C message to the handler registered for its procedure code
+   * and message type
+   *
+   * \param packet the message, X2 header included
+   * \param cellsInfo the X2 interface the message was received from, 0 for
+   * the controller
+   */
+  void DispatchX2cMessage (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo);
+
+  /**
+   * Send a message to the controller and account for it
+   */
+  void SendToController (Ptr<Socket> socket, Ptr<Packet> packet); // new
+
+  /**
+   * Notification of accepted handovers for the controller: the number of
+   * UEs (0 for a single one), the source and target cells, the address of
+   * the source eNB on its X2 link with this eNB, then the X2AP id allocated
+   * by the target to each UE, which is also the id of its VM migration. The
+   * controller keys its sessions on them.
+   *
+   * \param sourceCellId the cell the UEs come from
+   * \param ueIds the new X2AP ids of the UEs
+   * \param size the size of the notification, at least the fields above
+   */
+  Ptr<Packet> CreateControllerNotification (uint16_t sourceCellId, const std::list<uint16_t> &ueIds,
+                                            uint32_t size); // new
+
+  /**
+   * \return the report of a VM migration step for the controller, a VmReport
+   * header followed by the source cell, the target cell of the handover and
+   * the migration id. The target cell
+   * is the one the controller keys the session on, even if the VM was
+   * placed on this cell by another target.
+   */
+  Ptr<Packet> CreateVmControllerReport (Ptr<VmMigrationInfo> migration); // new
+
+  /**
+   * source: forward the UE data buffered for one UE whose handover the
+   * controller has acknowledged
+   */
+  void ForwardIcnUeData (); // new
+
+  /**
+   * An ICN message of the controller carries the number of UEs it is about
+   * (0 for a single UE), the source cell id, and the new X2AP id of each UE,
+   * the source cell id being 0 if the UEs are not known to the controller.
+   *
+   * \param packet an ICN message of the controller
+   * \return the number of handed over UEs the message is about
+   */
+  static uint16_t GetIcnMessageHandovers (Ptr<Packet> packet); // new
+
+  /**
+   * Start sending a VM to the given cell. The transfer shares the X2 link
+   * with the other migrations towards the same cell.
+   *
+   * \param targetCellId the cell id of the target eNB
+   * \param migrationId the migration id allocated by the target eNB
+   */
+  void StartVmTransfer (uint16_t targetCellId, uint16_t migrationId); // new
+
+  /**
+   * \param state the state looked for
+   * \return the oldest incoming VM migration in the given state, or 0
+   */
+  Ptr<VmMigrationInfo> FindVmMigrationIn (VmMigrationInfo::State_t state); // new
+
+  /**
+   * \param packet a command of the controller, starting with the source cell
+   * and the migration id of the VM it is about
+   * \param state the state the migration must be in
+   * \return the migration named by the command, or the oldest in the state
+   * if the command names none
+   */
+  Ptr<VmMigrationInfo> FindVmMigrationIn (Ptr<Packet> packet, VmMigrationInfo::State_t state); // new
+
+  void SetVmMigrationState (Ptr<VmMigrationInfo> migration, VmMigrationInfo::State_t state); // new
+
+  /**
+   * Notify the controller that all the chunks of a VM have been received
+   */
+  void VmMigrationReceived (Ptr<VmMigrationInfo> migration); // new
+
+  /**
+   * \return the name of a VM chunk: /vm/<image>/<chunk> for the chunks of
+   * the base image, /vm/<image>/<source cell id>-<migration id>/<chunk> for
+   * the chunks unique to the migrated VM
+   */
+  ns3::ndn::Name GetVmChunkName (Ptr<VmMigrationInfo> migration, uint32_t chunk) const; // new
+
+  /**
+   * Request the next chunks of a named VM migration while a source can
+   * take them. The chunks are looked up in the CS of the eNB first.
+   */
+  void RequestVmChunks (Ptr<VmMigrationInfo> migration); // new
+
+  /**
+   * Request the next chunks of all the named VM migrations in progress
+   */
+  void PumpVmChunkRequests (); // new
+
+  /**
+   * \return the source the chunk is to be requested to, VM_CHUNK_GATEWAY_ID
+   * for the SGW/PGW cache, or -1 if all the possible sources are busy
+   */
+  int32_t SelectVmChunkSource (Ptr<VmMigrationInfo> migration, uint32_t chunk); // new
+
+  /**
+   * Send an Interest for a VM chunk to a source, recording it in the PIT entry
+   */
+  void SendVmChunkRequest (ns3::ndn::Name name, uint16_t sourceId); // new
+
+  /**
+   * Send an Interest for a VM chunk to an X2 peer
+   *
+   * \param cacheOnly true if the peer is not the producer of the chunk and
+   * must answer with a NACK if the chunk is not in its CS
+   */
+  void SendVmChunkInterest (uint16_t peerCellId, ns3::ndn::Name name, bool cacheOnly); // new
+
+  /**
+   * Queue a VM chunk to be sent to the given cell
+   */
+  void QueueVmChunk (uint16_t targetCellId, ns3::ndn::Name name); // new
+
+  /**
+   * Send the next requested VM chunk to the given cell, paced at the X2
+   * link rate along with the pushed VM migrations
+   */
+  void SendVmChunk (uint16_t targetCellId); // new
+
+  /**
+   * Cache a received VM chunk and hand it to the migrations waiting for it
+   *
+   * \param packet the content header and content
+   */
+  void RecvVmChunk (Ptr<Packet> packet); // new
+
+  /**
+   * A cache did not have the requested VM chunk: ask it to the source eNB
+   *
+   * \param packet the Interest
+   */
+  void RecvVmChunkNack (Ptr<Packet> packet); // new
+
+  /**
+   * Callback of the EpcEnbApplication for the VM chunks coming from the
+   * SGW/PGW cache
+   */
+  void RecvVmChunkFromGateway (uint32_t teid, Ptr<Packet> packet); // new
+
+  void VmChunkFetched (Ptr<VmMigrationInfo> migration, VmChunkSource_t source); // new
+
+  /**
+   * target: request a prepared VM to its source eNB, pushed or as named
+   * chunks
+   */
+  void RequestVm (Ptr<VmMigrationInfo> migration); // new
+
+  /**
+   * target: hand a prepared VM migration over to the neighbor chosen by the
+   * placement engine, which fetches the VM from the source eNB itself
+   */
+  void PlaceVm (Ptr<VmMigrationInfo> migration, uint16_t cellId); // new
+
+  // X2-C message handlers
+  void DoRecvHandoverRequest (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo);
+  void DoRecvHandoverRequestAck (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo);
+  void DoRecvHandoverPreparationFailure (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo);
+  void DoRecvIcnMessage (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo); // new
+  void DoRecvIcnMessageSource (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo); // new
+  void DoRecvMigrationRequest (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo); // new
+  void DoRecvStartVmCmd (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo); // new
+  void DoRecvInterestVm (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo); // new
+  void DoRecvCsMigration (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo); // new
+  void DoRecvInterestVmChunk (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo); // new
+  void DoRecvInterestVmChunkCache (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo); // new
+  void DoRecvVmPlacement (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo); // new
+  void DoRecvVmPrediction (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo); // new
+  void DoRecvX2Bundle (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo); // new
+  void DoRecvPitTransfer (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo); // new
+  void DoRecvLoadInformation (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo);
+  void DoRecvSnStatusTransfer (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo);
+  void DoRecvUeContextRelease (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo);
+  void DoRecvResourceStatusUpdate (Ptr<Packet> packet, Ptr<X2CellInfo> cellsInfo);
+
+  /**
+   * number of log2 bins of the handling time histograms, in microseconds
+   */
+  static const uint32_t X2C_LATENCY_BINS = 16;
+
+  struct X2cHandlerInfo
+  {
+    X2cHandler m_handler;
+    std::string m_name;
+    bool m_fromPeer;
+    uint64_t m_count;
+    uint64_t m_nested;          ///< messages received inside an X2 bundle
+    uint64_t m_timed;           ///< messages timed with X2cProfiling
+    uint64_t m_totalLatencyUs;
+    std::vector<uint64_t> m_latencyHistogram;
+
+    X2cHandlerInfo () : m_handler (0), m_fromPeer (true), m_count (0), m_nested (0), m_timed (0), m_totalLatencyUs (0) {}
+  };
+
+  /**
+   * X2-C dispatch table, keyed by (procedure code << 8) | message type
+   */
+  std::map<uint16_t, X2cHandlerInfo> m_x2cHandlers;
+
+  /**
+   * number of X2-C messages received without a registered handler
+   */
+  uint64_t m_x2cUnhandled;
+
+  bool m_x2cStats;
+  bool m_x2cProfiling;
+
+  /**
+   * \return a monotonic wall-clock time in microseconds
+   */
+  static uint64_t GetWallClockUs (void);
+
+  uint32_t m_x2cDispatchDepth; ///< number of handlers being run, > 1 inside a bundle
+  uint64_t m_x2cNestedUs;      ///< time spent in the nested handlers of the running one
+
+  TracedCallback<uint8_t, uint8_t, bool> m_x2cHandledTrace;
+
    Ptr<EpcEnbApplication> epcEnbApp;
 
   /**
@@ -203,10 +649,329 @@ private:
   ostringstream vmFileSent; // edit
   ostringstream vmFileRecv; // edit
 
-  uint32_t m_counter; // edit
   uint32_t m_numOfPacket; // edit
   uint32_t m_vmMigration; // edit
-  uint32_t m_targetCounter; // edit
+
+  /**
+   * GTP-U TEIDs carrying VM chunks: the prefix ORed with the migration id
+   */
+  static const uint32_t VM_TEID_PREFIX = 0xffff0000;
+  static const uint32_t VM_TEID_MASK = 0xffff0000;
+
+  uint32_t m_vmChunkSize; // new
+  DataRate m_x2LinkDataRate; // new
+  Ipv4Address m_controllerAddress; // new
+
+  /**
+   * outgoing VM migrations, per target cell id, in round robin order
+   */
+  std::map<uint16_t, std::list<Ptr<VmMigrationInfo> > > m_vmTransfersOut; // new
+
+  /**
+   * time at which the X2 link towards each target cell is free again
+   */
+  std::map<uint16_t, Time> m_vmLinkFreeTime; // new
+
+  /**
+   * incoming VM migrations indexed by (source cell id << 16) | migration id,
+   * and in the order they were prepared
+   */
+  std::map<uint32_t, Ptr<VmMigrationInfo> > m_vmMigrationsIn; // new
+  std::list<Ptr<VmMigrationInfo> > m_vmMigrationsInFifo; // new
+
+  TracedCallback<uint16_t, uint16_t, uint8_t> m_vmMigrationStateTrace; // new
+
+  /**
+   * Named VM chunks: the target eNB pulls the chunks through the CS/PIT
+   * instead of the source eNB pushing anonymous chunks
+   */
+  bool m_vmNamedChunks; // new
+  std::string m_vmImageName; // new
+  uint32_t m_vmSharedChunks; // new
+  uint32_t m_vmFetchWindow; // new
+  bool m_vmGatewayCache; // new
+  bool m_vmMultiSource; // new
+
+  /**
+   * source id of the SGW/PGW cache, the eNB sources being identified by
+   * their cell id
+   */
+  static const uint16_t VM_CHUNK_GATEWAY_ID = 0;
+
+  struct VmChunkPitEntry_t
+  {
+    std::list<Ptr<VmMigrationInfo> > m_migrations; ///< migrations waiting for the chunk
+    uint16_t m_producer;                           ///< source eNB of the VM
+    uint16_t m_source;                             ///< source the chunk was requested to
+    Time m_sentTime;
+
+    VmChunkPitEntry_t () : m_producer (0), m_source (0) {}
+  };
+
+  /**
+   * target: VM chunks requested
+   */
+  std::map<ns3::ndn::Name, VmChunkPitEntry_t> m_vmChunkPit; // new
+
+  /**
+   * target: state of a source of VM chunks, the delivery interval being an
+   * EWMA of the time between two chunks delivered by the source
+   */
+  struct VmChunkSourceInfo
+  {
+    uint32_t m_outstanding;
+    Time m_interval;
+    Time m_lastDelivery;
+    uint64_t m_chunks;
+    uint64_t m_nacks;
+
+    VmChunkSourceInfo () : m_outstanding (0), m_chunks (0), m_nacks (0) {}
+  };
+
+  VmChunkSourceInfo &GetVmChunkSource (uint16_t sourceId); // new
+
+  std::map<uint16_t, VmChunkSourceInfo> m_vmChunkSources; // new
+
+  /**
+   * source: VM chunks requested by each target cell, in request order
+   */
+  std::map<uint16_t, std::list<ns3::ndn::Name> > m_vmChunkRequestsOut; // new
+
+  //             migration id  source
+  TracedCallback<uint16_t, uint8_t> m_vmChunkFetchedTrace; // new
+
+  /**
+   * VM placement engine: the target eNB of a handover chooses where the VM
+   * of the UE lands instead of always hosting it
+   */
+  bool m_vmPlacement; // new
+  uint32_t m_vmCapacity; // new
+  Time m_vmServiceTime; // new
+  Time m_vmRemoteAccessDelay; // new
+  uint32_t m_vmPlacementHorizon; // new
+  Time m_vmNeighborLoadMaxAge; // new
+
+  /**
+   * cell id of this eNB, learnt from the X2 interfaces
+   */
+  uint16_t m_localCellId; // new
+
+  /**
+   * VMs started on this eNB and not migrated away since
+   */
+  uint32_t m_vmHosted; // new
+
+  /**
+   * load of a neighbor cell in [0, 1], from its ResourceStatusUpdate and
+   * LoadInformation reports
+   */
+  struct X2NeighborLoad
+  {
+    double m_resourceLoad;     ///< hardware load and composite available capacity
+    double m_interferenceLoad; ///< share of the PRBs with high UL interference
+    Time m_lastUpdate;         ///< when the last report was received
+
+    X2NeighborLoad () : m_resourceLoad (0), m_interferenceLoad (0) {}
+  };
+
+  std::map<uint16_t, X2NeighborLoad> m_x2NeighborLoad; // new
+
+  /**
+   * VMs placed on each neighbor by this eNB
+   */
+  std::map<uint16_t, uint32_t> m_vmPlacedOn; // new
+
+  /**
+   * cell each UE served here is predicted to be served by next, by IMSI,
+   * until the UE is handed over
+   */
+  std::map<uint64_t, uint16_t> m_vmPredictedCell; // new
+
+  /**
+   * target: RNTI given to the incoming UEs by (source cell id << 16) | old
+   * X2AP id, from the acknowledgement of their handover until its end
+   */
+  std::map<uint32_t, uint16_t> m_handoverRntis; // new
+
+  //             migration id  cell id  estimated latency
+  TracedCallback<uint16_t, uint16_t, Time> m_vmPlacementTrace; // new
+
+  /**
+   * \param socket the socket the packet was received from
+   * \param from the source address of the packet
+   * \return the (local, remote) cell ids of the X2 interface the packet
+   * belongs to, or 0 if the sender is not an X2 peer
+   */
+  Ptr<X2CellInfo> GetX2CellInfo (Ptr<Socket> socket, const Address &from);
+
+  /**
+   * If true, all the X2 interfaces share m_sharedX2cSocket and
+   * m_sharedX2uSocket, and m_x2InterfaceCellIdsByAddr replaces
+   * m_x2InterfaceCellIds
+   */
+  bool m_sharedSockets;
+  Ptr<Socket> m_sharedX2cSocket;
+  Ptr<Socket> m_sharedX2uSocket;
+
+  typedef sgi::hash_map<Ipv4Address, Ptr<X2CellInfo>, Ipv4AddressHash> X2CellInfoByAddrMap_t;
+
+  /**
+   * Map the remote X2 address to the corresponding (sourceCellId, targetCellId)
+   */
+  X2CellInfoByAddrMap_t m_x2InterfaceCellIdsByAddr;
+
+  X2InterfaceRequestCallback m_x2InterfaceRequestCallback;
+
+  /**
+   * Send a packet to an X2 neighbor, through the X2 link scheduler when
+   * enabled
+   *
+   * \param cellId the cell id of the neighbor
+   * \param socket the local socket to send the packet from
+   * \param address the address of the neighbor
+   * \param port the destination port
+   * \param packet the packet
+   * \param trafficClass the class the packet is queued in
+   */
+  void SendOverX2 (uint16_t cellId, Ptr<Socket> socket, Ipv4Address address, uint16_t port,
+                   Ptr<Packet> packet, X2TrafficClass_t trafficClass); // new
+
+  /**
+   * Send the next packet queued on the X2 link towards the given cell, and
+   * schedule the following one when the packet has been transmitted at the
+   * X2 link rate
+   *
+   * \param cellId the cell id of the neighbor
+   */
+  void ServeX2Link (uint16_t cellId); // new
+
+  /**
+   * Send X2-C messages to an X2 neighbor in a single datagram, as an
+   * X2Bundle message if there are several
+   *
+   * \param cellId the cell id of the neighbor
+   * \param socket the local socket to send the messages from
+   * \param address the address of the neighbor
+   * \param messages the messages, X2 header included
+   */
+  void SendX2BundleDatagram (uint16_t cellId, Ptr<Socket> socket, Ipv4Address address,
+                             const std::list<Ptr<Packet> > &messages); // new
+
+  /**
+   * Send a datagram on an X2 socket, counting the datagrams the socket refuses
+   */
+  void SendX2Datagram (uint16_t cellId, Ptr<Socket> socket, Ipv4Address address, uint16_t port,
+                       Ptr<Packet> packet); // new
+
+  struct X2QueueItem
+  {
+    Ptr<Packet> m_packet;
+    Ptr<Socket> m_socket;
+    Ipv4Address m_address;
+    uint16_t m_port;
+    Time m_enqueueTime;
+  };
+
+  /**
+   * Per-class queues of the X2 link towards a neighbor. The bulk class is
+   * kept short: it is refilled from the VM transfers whenever it empties,
+   * so that a VM chunk never waits behind more than one other.
+   */
+  struct X2LinkQueue
+  {
+    std::list<X2QueueItem> m_queues[X2_N_CLASSES];
+    uint32_t m_deficit[X2_N_CLASSES];
+    uint8_t m_drrClass;
+    bool m_busy;
+    EventId m_serveEvent;
+
+    X2LinkQueue () : m_drrClass (0), m_busy (false)
+    {
+      for (uint8_t c = 0; c < X2_N_CLASSES; ++c)
+        {
+          m_deficit[c] = 0;
+        }
+    }
+  };
+
+  /**
+   * \param link the queues of the X2 link
+   * \return the class to be served next, or -1 if all the queues are empty
+   */
+  int32_t SelectX2Class (X2LinkQueue &link); // new
+
+  X2Scheduler_t m_x2Scheduler; // new
+  uint32_t m_x2ControlQuantum; // new
+  uint32_t m_x2UeDataQuantum; // new
+  uint32_t m_x2BulkQuantum; // new
+  std::map<uint16_t, X2LinkQueue> m_x2LinkQueues; // new
+
+  //             cell id   class    depth
+  TracedCallback<uint16_t, uint8_t, uint32_t> m_x2QueueDepthTrace; // new
+  //             cell id   class    queueing delay
+  TracedCallback<uint16_t, uint8_t, Time> m_x2QueueDelayTrace; // new
+
+  /**
+   * X2-C messages being bundled towards a neighbor, along with the target
+   * RNTIs of the handovers accepted meanwhile
+   */
+  struct X2Bundle
+  {
+    uint32_t m_depth;
+    std::list<Ptr<Packet> > m_messages;
+    Ptr<Socket> m_socket;
+    Ipv4Address m_address;
+    std::list<uint16_t> m_handovers;
+
+    X2Bundle () : m_depth (0) {}
+  };
+
+  std::map<uint16_t, X2Bundle> m_x2Bundles; // new
+  uint32_t m_maxBundleSize; // new
+
+  /**
+   * X2 datagrams refused by the sockets, e.g. larger than a UDP datagram
+   */
+  uint64_t m_x2SendFailures; // new
+  //             cell id   bytes
+  TracedCallback<uint16_t, uint32_t> m_x2SendFailedTrace; // new
+
+  /**
+   * received X2 bundles whose rest was dropped for being malformed
+   */
+  uint64_t m_x2BundleDrops; // new
+  //             cell id   bytes
+  TracedCallback<uint16_t, uint32_t> m_x2BundleDroppedTrace; // new
+
+  /**
+   * signaling sent on the X2-C interfaces, a bundle counting as one
+   * message, and to the controller
+   */
+  uint64_t m_x2cMessagesSent; // new
+  uint64_t m_x2cBytesSent; // new
+  uint64_t m_controllerMessagesSent; // new
+  uint64_t m_controllerBytesSent; // new
+
+  //             cell id   bytes
+  TracedCallback<uint16_t, uint32_t> m_x2cSentTrace; // new
+  //             bytes
+  TracedCallback<uint32_t> m_controllerSentTrace; // new
+
+  /**
+   * target: IMSI of the incoming handovers by (source cell id << 16) | old
+   * X2AP id, until acknowledged
+   */
+  std::map<uint32_t, uint64_t> m_handoverImsis; // new
+
+  /**
+   * target: IMSI of the handovers waiting for the ICN message of the
+   * controller, by (source cell id << 16) | new X2AP id, the ids the
+   * controller answers with
+   */
+  std::map<uint32_t, uint64_t> m_icnPendingImsis; // new
+
+  //             imsi
+  TracedCallback<uint64_t> m_icnMessageTrace; // new
 
 };
 
@@ -4,6 +4,7 @@
 namespace ns3 {
 
 EnbPitFace_t::EnbPitFace_t()
+  : m_generation (0)
 {
 }
 
@@ -11,18 +12,20 @@ EnbPitFace_t::EnbPitFace_t(const uint16_t rnti, const uint8_t bid, const uint16_
   : m_rnti (rnti),
     m_bid (bid),
     m_port (port),
-    m_ipv4address(addr)
-
+    m_ipv4address(addr),
+    m_generation (0)
 {
 }
 
 SgwPgwPitFace_t::SgwPgwPitFace_t()
+  : m_enbAddress (Ipv4Address::GetAny ()) // new
 {
 }
 
 SgwPgwPitFace_t::SgwPgwPitFace_t(const uint16_t port, const Ipv4Address addr)
   : m_port (port),
-    m_ipv4address(addr)
+    m_ipv4address(addr),
+    m_enbAddress (Ipv4Address::GetAny ()) // new
 
 {
 }
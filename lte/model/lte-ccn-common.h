@@ -18,6 +18,7 @@ struct EnbPitFace_t
   uint8_t       m_bid;
   uint16_t      m_port;
   Ipv4Address   m_ipv4address;
+  uint32_t      m_generation; ///< generation of the UE context of the RNTI, 0 if not checked
 
 public:
   EnbPitFace_t ();
@@ -29,6 +30,7 @@ struct SgwPgwPitFace_t
 {
   uint16_t      m_port;
   Ipv4Address   m_ipv4address;
+  Ipv4Address   m_enbAddress; ///< eNB which re-expressed a transferred PIT entry, any if the face is the UE // new
 
 public:
   SgwPgwPitFace_t ();
@@ -47,6 +49,22 @@ public:
   CsEps_t ();
 };
 
+/**
+ * GTP-U TEIDs reserved for the named VM chunks exchanged between the eNBs
+ * and the SGW/PGW cache, over S1-U and X2-U
+ */
+const uint32_t VM_CHUNK_INTEREST_TEID = 0xfffe0001; // new
+const uint32_t VM_CHUNK_CONTENT_TEID  = 0xfffe0002; // new
+const uint32_t VM_CHUNK_NACK_TEID     = 0xfffe0003; // new
+
+/**
+ * GTP-U TEIDs reserved for the Interests re-expressed by the target eNB of a
+ * handover on behalf of an incoming UE, and for the content answering them,
+ * which goes to that eNB rather than to the one currently serving the UE
+ */
+const uint32_t PIT_TRANSFER_INTEREST_TEID = 0xfffe0004; // new
+const uint32_t PIT_TRANSFER_CONTENT_TEID  = 0xfffe0005; // new
+
 
 };
 
@@ -142,7 +142,8 @@ UeManager::UeManager (Ptr<LteEnbRrc> rrc, uint16_t rnti, State s)
     m_pendingRrcConnectionReconfiguration (false),
     m_sourceX2apId (0),
     m_sourceCellId (0),
-    m_needTransmissionModeConfiguration (false)
+    m_needTransmissionModeConfiguration (false),
+    m_handoverFirstDataPending (false) // new
 {
   NS_LOG_FUNCTION (this);
 }
@@ -548,6 +549,7 @@ UeManager::PrepareHandover (uint16_t cellId)
         NS_LOG_LOGIC ("rrcContext   = " << params.rrcContext);
 
         m_rrc->m_x2SapProvider->SendHandoverRequest (params);
+        m_rrc->m_handoverPhaseTrace (m_imsi, m_rrc->m_cellId, m_rnti, LteEnbRrc::HO_PREPARATION); // new
         SwitchToState (HANDOVER_PREPARATION);
       }
       break;
@@ -566,6 +568,9 @@ UeManager::RecvHandoverRequestAck (EpcX2SapUser::HandoverRequestAckParams params
 
   NS_ASSERT_MSG (params.notAdmittedBearers.empty (), "not admission of some bearers upon handover is not supported");
   NS_ASSERT_MSG (params.admittedBearers.size () == m_drbMap.size (), "not enough bearers in admittedBearers");
+  m_rrc->m_handoverPhaseTrace (m_imsi, m_rrc->m_cellId, m_rnti, LteEnbRrc::HO_REQUEST_ACK); // new
+  // the target has admitted the UE: it can be sent the content of the UE
+  m_rrc->epcEnbApp->PrepareCsMigration (m_rnti, params.targetCellId); // new
 
   // note: the Handover command from the target eNB to the source eNB
   // is expected to be sent transparently to the UE; however, here we
@@ -601,21 +606,21 @@ UeManager::RecvHandoverRequestAck (EpcX2SapUser::HandoverRequestAckParams params
     }
   m_rrc->m_x2SapProvider->SendSnStatusTransfer (sst);
 
-  std::map<uint16_t, EpcEnbApplication::Buff_t>::iterator buffIt = m_rrc->epcEnbApp->m_buffMap.find (m_rnti);
+  EpcEnbApplication::Buff_t *buff = m_rrc->epcEnbApp->m_buffMap.Find (m_rnti);
 
-  if (buffIt == m_rrc->epcEnbApp->m_buffMap.end ())
+  if (buff == 0)
     {
       NS_LOG_INFO ("BUFFER IS EMPTY!!!!!!!!!!!!!!!");
     }
   else
     {
       NS_LOG_INFO ("THERE IS BUFFER!!!!!!!!!!!!!!!");
-      uint8_t drbid = Bid2Drbid (buffIt->second.m_bid);
+      uint8_t drbid = Bid2Drbid (buff->m_bid);
       EpcX2Sap::UeDataParams params;
       params.sourceCellId = m_rrc->m_cellId;
       params.targetCellId = m_targetCellId;
       params.gtpTeid = GetDataRadioBearerInfo (drbid)->m_gtpTeid;
-      params.ueData = buffIt->second.m_packet;
+      params.ueData = buff->m_packet;
       m_rrc->m_x2SapProvider->SendUeData (params);
     }
 }
@@ -654,6 +659,11 @@ UeManager::SendData (uint8_t bid, Ptr<Packet> p)
     case HANDOVER_JOINING:
     case HANDOVER_PATH_SWITCH:
       {
+        if (m_handoverFirstDataPending) // new
+          {
+            m_handoverFirstDataPending = false;
+            m_rrc->m_handoverPhaseTrace (m_imsi, m_rrc->m_cellId, m_rnti, LteEnbRrc::HO_FIRST_DATA);
+          }
         NS_LOG_LOGIC ("queueing data on PDCP for transmission over the air");
         LtePdcpSapProvider::TransmitPdcpSduParameters params;
         params.pdcpSdu = p;
@@ -718,6 +728,7 @@ UeManager::SendUeContextRelease ()
       ueCtxReleaseParams.sourceCellId = m_sourceCellId;
       m_rrc->m_x2SapProvider->SendUeContextRelease (ueCtxReleaseParams);
       SwitchToState (CONNECTED_NORMALLY);
+      m_rrc->m_handoverPhaseTrace (m_imsi, m_rrc->m_cellId, m_rnti, LteEnbRrc::HO_PATH_SWITCH); // new
       m_rrc->m_handoverEndOkTrace (m_imsi, m_rrc->m_cellId, m_rnti);
       break;
 
@@ -749,6 +760,7 @@ void
 UeManager::RecvSnStatusTransfer (EpcX2SapUser::SnStatusTransferParams params)
 {
   NS_LOG_FUNCTION (this);
+  m_rrc->m_handoverPhaseTrace (m_imsi, m_rrc->m_cellId, m_rnti, LteEnbRrc::HO_SN_STATUS_TRANSFER); // new
   for (std::vector<EpcX2Sap::ErabsSubjectToStatusTransferItem>::iterator erabIt
          = params.erabsSubjectToStatusTransferList.begin ();
        erabIt != params.erabsSubjectToStatusTransferList.end ();
@@ -873,6 +885,9 @@ UeManager::RecvRrcConnectionReconfigurationCompleted (LteRrcSap::RrcConnectionRe
         params.cellId = m_rrc->m_cellId;
         params.mmeUeS1Id = m_imsi;
         SwitchToState (HANDOVER_PATH_SWITCH);
+        // new: the data forwarded over X2 while joining waits in the
+        // buffers, the UE is only served from here on
+        m_handoverFirstDataPending = true;
         for (std::map <uint8_t, Ptr<LteDataRadioBearerInfo> >::iterator it =  m_drbMap.begin ();
              it != m_drbMap.end ();
              ++it)
@@ -983,6 +998,15 @@ UeManager::SetSrsConfigurationIndex (uint16_t srsConfIndex)
       // RRC connection establishment
       break;
 
+    case HANDOVER_PATH_SWITCH: // new
+      // the reconfiguration is sent once the UE is connected normally
+      m_pendingRrcConnectionReconfiguration = true;
+      break;
+
+    case CONNECTION_REJECTED: // new
+      // the UE is about to be removed, nothing to reconfigure
+      break;
+
     default:
       ScheduleRrcConnectionReconfiguration ();
       break;
@@ -1187,6 +1211,8 @@ LteEnbRrc::LteEnbRrc ()
     m_configured (false),
     m_lastAllocatedRnti (0),
     m_srsCurrentPeriodicityId (0),
+    m_srsCiAllocated (0),
+    m_srsPeriodicityEscalation (true),
     m_lastAllocatedConfigurationIndex (0),
     m_reconfigureUes (false)
 {
@@ -1212,6 +1238,7 @@ LteEnbRrc::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
   m_ueMap.clear ();
+  m_ueSlots.Clear ();
   delete m_cmacSapUser;
   delete m_rrcSapProvider;
   delete m_x2SapUser;
@@ -1254,6 +1281,13 @@ LteEnbRrc::GetTypeId (void)
                    MakeUintegerAccessor (&LteEnbRrc::SetSrsPeriodicity,
                                          &LteEnbRrc::GetSrsPeriodicity),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SrsPeriodicityEscalation",
+                   "If true, the SRS periodicity is increased when a UE joins a cell "
+                   "whose SRS configuration indexes are all in use, instead of aborting "
+                   "the simulation",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&LteEnbRrc::m_srsPeriodicityEscalation),
+                   MakeBooleanChecker ())
    .AddAttribute ("AdmitHandoverRequest",
                    "Whether to admit an X2 handover request from another eNB",
                    BooleanValue (true),
@@ -1279,6 +1313,13 @@ LteEnbRrc::GetTypeId (void)
     .AddTraceSource ("HandoverEndOk",
                      "trace fired upon successful termination of a handover procedure",
                      MakeTraceSourceAccessor (&LteEnbRrc::m_handoverEndOkTrace))
+    .AddTraceSource ("HandoverPhase",
+                     "trace fired when a handover procedure reaches a new phase, "
+                     "see LteEnbRrc::HandoverPhase_t",
+                     MakeTraceSourceAccessor (&LteEnbRrc::m_handoverPhaseTrace))
+    .AddTraceSource ("RecvMeasurementReport",
+                     "trace fired when measurement report is received",
+                     MakeTraceSourceAccessor (&LteEnbRrc::m_recvMeasurementReportTrace))
   ;
   return tid;
 }
@@ -1364,9 +1405,15 @@ LteEnbRrc::GetUeManager (uint16_t rnti)
 {
   NS_LOG_FUNCTION (this << (uint32_t) rnti);
   NS_ASSERT (0 != rnti);
-  std::map<uint16_t, Ptr<UeManager> >::iterator it = m_ueMap.find (rnti);
-  NS_ASSERT_MSG (it != m_ueMap.end (), "RNTI " << rnti << " not found in eNB with cellId " << m_cellId);
-  return it->second;
+  Ptr<UeManager> *ueManager = m_ueSlots.Find (rnti);
+  NS_ASSERT_MSG (ueManager != 0, "RNTI " << rnti << " not found in eNB with cellId " << m_cellId);
+  return *ueManager;
+}
+
+bool
+LteEnbRrc::HasUeManager (uint16_t rnti) const // new
+{
+  return m_ueSlots.Contains (rnti);
 }
 
 void
@@ -1486,7 +1533,9 @@ void
 LteEnbRrc::DoRecvMeasurementReport (uint16_t rnti, LteRrcSap::MeasurementReport msg)
 {
   NS_LOG_FUNCTION (this << rnti);
-  GetUeManager (rnti)->RecvMeasurementReport (msg);
+  Ptr<UeManager> ueManager = GetUeManager (rnti);
+  m_recvMeasurementReportTrace (ueManager->GetImsi (), m_cellId, rnti, msg);
+  ueManager->RecvMeasurementReport (msg);
 }
 
 void
@@ -1655,7 +1704,8 @@ LteEnbRrc::DoRecvUeContextRelease (EpcX2SapUser::UeContextReleaseParams params)
   NS_LOG_LOGIC ("newEnbUeX2apId = " << params.newEnbUeX2apId);
 
   uint16_t rnti = params.oldEnbUeX2apId;
-  RemoveUe (rnti);
+  m_handoverPhaseTrace (GetUeManager (rnti)->GetImsi (), m_cellId, rnti, HO_CONTEXT_RELEASE); // new
+  RemoveUe (rnti, true); // edit
 }
 
 void
@@ -1860,7 +1910,7 @@ LteEnbRrc::AddUe (UeManager::State state)
        (rnti != m_lastAllocatedRnti - 1) && (!found);
        ++rnti)
     {
-      if ((rnti != 0) && (m_ueMap.find (rnti) == m_ueMap.end ()))
+      if ((rnti != 0) && !m_ueSlots.Contains (rnti))
         {
           found = true;
           break;
@@ -1871,6 +1921,7 @@ LteEnbRrc::AddUe (UeManager::State state)
   m_lastAllocatedRnti = rnti;
   Ptr<UeManager> ueManager = CreateObject<UeManager> (this, rnti, state);
   m_ueMap.insert (std::pair<uint16_t, Ptr<UeManager> > (rnti, ueManager));
+  m_ueSlots.Get (rnti) = ueManager;
   ueManager->Initialize ();
   NS_LOG_DEBUG (this << " New UE RNTI " << rnti << " cellId " << m_cellId << " srs CI " << ueManager->GetSrsConfigurationIndex ());
   m_newUeContextTrace (m_cellId, rnti);
@@ -1878,13 +1929,20 @@ LteEnbRrc::AddUe (UeManager::State state)
 }
 
 void
-LteEnbRrc::RemoveUe (uint16_t rnti)
+LteEnbRrc::RemoveUe (uint16_t rnti, bool handoverCompleted) // edit
 {
   NS_LOG_FUNCTION (this << (uint32_t) rnti);
   std::map <uint16_t, Ptr<UeManager> >::iterator it = m_ueMap.find (rnti);
   NS_ASSERT_MSG (it != m_ueMap.end (), "request to remove UE info with unknown rnti " << rnti);
+  if (!handoverCompleted && epcEnbApp != 0
+      && it->second->GetState () == UeManager::HANDOVER_LEAVING) // new
+    {
+      // the handover is aborted after the target admitted the UE
+      epcEnbApp->CancelCsMigration (rnti);
+    }
   uint16_t srsCi = (*it).second->GetSrsConfigurationIndex ();
   m_ueMap.erase (it);
+  m_ueSlots.Erase (rnti);
   m_cmacSapProvider->RemoveUe (rnti);
   m_cphySapProvider->RemoveUe (rnti);
   if (m_s1SapProvider != 0)
@@ -1946,7 +2004,10 @@ LteEnbRrc::SetSrsPeriodicity (uint32_t p)
     {
       if (g_srsPeriodicity[id] == p)
         {
+          NS_ASSERT_MSG (m_srsCiAllocated == 0, "SRS periodicity changed with UEs attached");
           m_srsCurrentPeriodicityId = id;
+          m_srsCiUsed.clear ();
+          ResetSrsConfigurationIndexes ();
           return;
         }
     }
@@ -1972,54 +2033,29 @@ LteEnbRrc::GetSrsPeriodicity () const
 uint16_t
 LteEnbRrc::GetNewSrsConfigurationIndex ()
 {
-  NS_LOG_FUNCTION (this << m_ueSrsConfigurationIndexSet.size ());
+  NS_LOG_FUNCTION (this << m_srsCiAllocated);
   // SRS
   NS_ASSERT (m_srsCurrentPeriodicityId > 0);
   NS_ASSERT (m_srsCurrentPeriodicityId < SRS_ENTRIES);
-  NS_LOG_DEBUG (this << " SRS p " << g_srsPeriodicity[m_srsCurrentPeriodicityId] << " set " << m_ueSrsConfigurationIndexSet.size ());
-  if (m_ueSrsConfigurationIndexSet.size () >= g_srsPeriodicity[m_srsCurrentPeriodicityId])
-    {
-      NS_FATAL_ERROR ("too many UEs (" << m_ueSrsConfigurationIndexSet.size () + 1
-                      << ") for current SRS periodicity "
-                      <<  g_srsPeriodicity[m_srsCurrentPeriodicityId]
-                      << ", consider increasing the value of ns3::LteEnbRrc::SrsPeriodicity");
-    }
-
-  if (m_ueSrsConfigurationIndexSet.empty ())
-    {
-      // first entry
-      m_lastAllocatedConfigurationIndex = g_srsCiLow[m_srsCurrentPeriodicityId];
-      m_ueSrsConfigurationIndexSet.insert (m_lastAllocatedConfigurationIndex);
-    }
-  else
+  NS_LOG_DEBUG (this << " SRS p " << g_srsPeriodicity[m_srsCurrentPeriodicityId] << " set " << m_srsCiAllocated);
+  if (m_srsCiFree.empty ())
     {
-      // find a CI from the available ones
-      std::set<uint16_t>::reverse_iterator rit = m_ueSrsConfigurationIndexSet.rbegin ();
-      NS_ASSERT (rit != m_ueSrsConfigurationIndexSet.rend ());
-      NS_LOG_DEBUG (this << " lower bound " << (*rit) << " of " << g_srsCiHigh[m_srsCurrentPeriodicityId]);
-      if ((*rit) < g_srsCiHigh[m_srsCurrentPeriodicityId])
+      if (!m_srsPeriodicityEscalation || m_srsCurrentPeriodicityId + 1 >= SRS_ENTRIES)
         {
-          // got it from the upper bound
-          m_lastAllocatedConfigurationIndex = (*rit) + 1;
-          m_ueSrsConfigurationIndexSet.insert (m_lastAllocatedConfigurationIndex);
-        }
-      else
-        {
-          // look for released ones
-          for (uint16_t srcCi = g_srsCiLow[m_srsCurrentPeriodicityId]; srcCi < g_srsCiHigh[m_srsCurrentPeriodicityId]; srcCi++)
-            {
-              std::set<uint16_t>::iterator it = m_ueSrsConfigurationIndexSet.find (srcCi);
-              if (it==m_ueSrsConfigurationIndexSet.end ())
-                {
-                  m_lastAllocatedConfigurationIndex = srcCi;
-                  m_ueSrsConfigurationIndexSet.insert (srcCi);
-                  break;
-                }
-            }
+          NS_FATAL_ERROR ("too many UEs (" << m_srsCiAllocated + 1
+                          << ") for current SRS periodicity "
+                          <<  g_srsPeriodicity[m_srsCurrentPeriodicityId]
+                          << ", consider increasing the value of ns3::LteEnbRrc::SrsPeriodicity");
         }
+      EscalateSrsPeriodicity ();
     }
-  return m_lastAllocatedConfigurationIndex;
 
+  uint16_t offset = m_srsCiFree.back ();
+  m_srsCiFree.pop_back ();
+  m_srsCiUsed[offset] = true;
+  ++m_srsCiAllocated;
+  m_lastAllocatedConfigurationIndex = g_srsCiLow[m_srsCurrentPeriodicityId] + offset;
+  return m_lastAllocatedConfigurationIndex;
 }
 
 
@@ -2027,9 +2063,49 @@ void
 LteEnbRrc::RemoveSrsConfigurationIndex (uint16_t srcCi)
 {
   NS_LOG_FUNCTION (this << srcCi);
-  std::set<uint16_t>::iterator it = m_ueSrsConfigurationIndexSet.find (srcCi);
-  NS_ASSERT_MSG (it != m_ueSrsConfigurationIndexSet.end (), "request to remove unkwown SRS CI " << srcCi);
-  m_ueSrsConfigurationIndexSet.erase (it);
+  uint32_t offset = (uint32_t) srcCi - g_srsCiLow[m_srsCurrentPeriodicityId];
+  NS_ASSERT_MSG (srcCi >= g_srsCiLow[m_srsCurrentPeriodicityId] && offset < m_srsCiUsed.size () && m_srsCiUsed[offset],
+                 "request to remove unkwown SRS CI " << srcCi);
+  m_srsCiUsed[offset] = false;
+  m_srsCiFree.push_back (offset);
+  --m_srsCiAllocated;
+}
+
+void
+LteEnbRrc::ResetSrsConfigurationIndexes ()
+{
+  NS_LOG_FUNCTION (this);
+  uint16_t period = g_srsPeriodicity[m_srsCurrentPeriodicityId];
+  m_srsCiUsed.resize (period, false);
+  m_srsCiFree.clear ();
+  for (uint16_t offset = period; offset > 0; --offset)
+    {
+      if (!m_srsCiUsed[offset - 1])
+        {
+          m_srsCiFree.push_back (offset - 1);
+        }
+    }
+}
+
+void
+LteEnbRrc::EscalateSrsPeriodicity ()
+{
+  uint16_t oldCiLow = g_srsCiLow[m_srsCurrentPeriodicityId];
+  ++m_srsCurrentPeriodicityId;
+  NS_LOG_WARN ("cell " << m_cellId << ": " << m_srsCiAllocated << " UEs, SRS periodicity increased to "
+               << g_srsPeriodicity[m_srsCurrentPeriodicityId]);
+  ResetSrsConfigurationIndexes ();
+
+  for (std::map<uint16_t, Ptr<UeManager> >::iterator it = m_ueMap.begin (); it != m_ueMap.end (); ++it)
+    {
+      // the UE being added is given its index once the escalation is over
+      if (it->first == m_lastAllocatedRnti)
+        {
+          continue;
+        }
+      uint16_t offset = it->second->GetSrsConfigurationIndex () - oldCiLow;
+      it->second->SetSrsConfigurationIndex (g_srsCiLow[m_srsCurrentPeriodicityId] + offset);
+    }
 }
 
 uint8_t
@@ -40,9 +40,11 @@
 #include <ns3/lte-ccn-common.h> // edited
 #include <ns3/names.h>  // edit
 #include <ns3/ipv4-address.h> // edit
+#include <ns3/rnti-slot-table.h> // new
 
 #include <map>
 #include <set>
+#include <vector>
 
 namespace ns3 {
 
@@ -396,6 +398,7 @@ private:
   std::list<uint8_t> m_drbsToBeStarted;
   bool m_needTransmissionModeConfiguration;
   EventId m_connectionTimeout;
+  bool m_handoverFirstDataPending; // new
 };
 
 
@@ -522,6 +525,12 @@ public:
    */
   Ptr<UeManager> GetUeManager (uint16_t rnti);
 
+  /**
+   * \param rnti the identifier of an UE
+   * \return true if the eNB has a context for the RNTI
+   */
+  bool HasUeManager (uint16_t rnti) const; // new
+
   /**
    * configure cell-specific parameters
    *
@@ -592,6 +601,24 @@ public:
                                    RLC_AM_ALWAYS = 3,
                                    PER_BASED = 4};
 
+  /**
+   * Phases of an X2-based handover, in the order they normally occur. The
+   * detach from the source cell and the random access at the target cell
+   * are seen by the UE RRC (HandoverStart and RandomAccessSuccessful), the
+   * controller message by the EpcX2 of the target eNB (IcnMessageReceived);
+   * the other phases are reported by the HandoverPhase trace of the eNB RRC.
+   */
+  enum HandoverPhase_t {HO_PREPARATION = 0,   ///< source: handover request sent
+                        HO_REQUEST_ACK,       ///< source: handover request ack received
+                        HO_SN_STATUS_TRANSFER,///< target: SN status transfer received
+                        HO_DETACH,            ///< UE: handover command received
+                        HO_RACH,              ///< UE: random access to the target done
+                        HO_PATH_SWITCH,       ///< target: path switch acknowledged
+                        HO_CONTROLLER,        ///< target: ICN message of the controller received
+                        HO_FIRST_DATA,        ///< target: first packet sent to the joined UE
+                        HO_CONTEXT_RELEASE,   ///< source: UE context released
+                        HO_N_PHASES}; // new
+
 private:
 
 
@@ -643,8 +670,10 @@ private:
    * remove a UE from the cell
    *
    * \param rnti the C-RNTI identiftying the user
+   * \param handoverCompleted true if the target eNB released the context of
+   * the UE; a UE leaving the cell removed otherwise has its handover aborted
    */
-  void RemoveUe (uint16_t rnti);
+  void RemoveUe (uint16_t rnti, bool handoverCompleted = false); // edit
 
 
   /**
@@ -692,6 +721,19 @@ private:
    */
   void RemoveSrsConfigurationIndex (uint16_t srcCi);
 
+  /**
+   * make all the SRS configuration indexes of the current periodicity
+   * available again, but those already allocated
+   */
+  void ResetSrsConfigurationIndexes (void);
+
+  /**
+   * Switch to the next SRS periodicity when all the indexes of the current
+   * one are allocated. Every UE keeps its offset in the period, its index
+   * being moved to the new range and reconfigured.
+   */
+  void EscalateSrsPeriodicity (void);
+
 
 
   /**
@@ -747,7 +789,12 @@ private:
   uint16_t m_ulBandwidth;
   uint16_t m_lastAllocatedRnti;
 
+  /**
+   * UE managers by RNTI, kept for the UeMap attribute; the lookups go
+   * through m_ueSlots
+   */
   std::map<uint16_t, Ptr<UeManager> > m_ueMap;
+  RntiSlotTable<Ptr<UeManager> > m_ueSlots; // new
 
   struct X2uTeidInfo
   {
@@ -774,7 +821,18 @@ private:
 
   // SRS related attributes
   uint16_t m_srsCurrentPeriodicityId;
-  std::set<uint16_t> m_ueSrsConfigurationIndexSet;
+  /**
+   * SRS configuration indexes of the current periodicity which are not
+   * allocated, as offsets from the first index of the periodicity, the
+   * lowest last
+   */
+  std::vector<uint16_t> m_srsCiFree;
+  /**
+   * allocated SRS configuration indexes, by offset
+   */
+  std::vector<bool> m_srsCiUsed;
+  uint32_t m_srsCiAllocated;
+  bool m_srsPeriodicityEscalation;
   uint16_t m_lastAllocatedConfigurationIndex;
   bool m_reconfigureUes;
 
@@ -791,6 +849,10 @@ private:
   TracedCallback<uint64_t, uint16_t, uint16_t, uint16_t> m_handoverStartTrace;
   //             imsi      cellid    rnti
   TracedCallback<uint64_t, uint16_t, uint16_t> m_handoverEndOkTrace;
+  //             imsi      cellid    rnti      phase
+  TracedCallback<uint64_t, uint16_t, uint16_t, uint8_t> m_handoverPhaseTrace; // new
+  //             imsi      cellid    rnti      report
+  TracedCallback<uint64_t, uint16_t, uint16_t, LteRrcSap::MeasurementReport> m_recvMeasurementReportTrace;
 
 };
 
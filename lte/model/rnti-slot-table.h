@@ -0,0 +1,242 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RNTI_SLOT_TABLE_H
+#define RNTI_SLOT_TABLE_H
+
+#include "ns3/assert.h"
+
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup lte
+ *
+ * Per-UE contexts stored in a vector indexed by RNTI. The RNTIs of a cell
+ * are allocated from 1 upwards, so the vector stays dense and a lookup is
+ * a bounds check and an index.
+ *
+ * Each slot carries a generation counter, incremented whenever a context is
+ * inserted or erased. A (RNTI, generation) pair taken when a context is
+ * created no longer validates once the RNTI has been released and given to
+ * another UE.
+ */
+template <class T>
+class RntiSlotTable
+{
+public:
+  RntiSlotTable ()
+    : m_size (0)
+  {
+  }
+
+  /**
+   * \param rnti the RNTI
+   * \return the context of the UE, or 0 if there is none
+   */
+  T* Find (uint16_t rnti)
+  {
+    if (rnti < m_slots.size () && m_slots[rnti].m_used)
+      {
+        return &m_slots[rnti].m_value;
+      }
+    return 0;
+  }
+
+  const T* Find (uint16_t rnti) const
+  {
+    if (rnti < m_slots.size () && m_slots[rnti].m_used)
+      {
+        return &m_slots[rnti].m_value;
+      }
+    return 0;
+  }
+
+  bool Contains (uint16_t rnti) const
+  {
+    return Find (rnti) != 0;
+  }
+
+  /**
+   * Create the context of a UE, like std::map::operator[]: an existing
+   * context is returned as is
+   *
+   * \param rnti the RNTI
+   * \return the context of the UE
+   */
+  T& Get (uint16_t rnti)
+  {
+    if (rnti >= m_slots.size ())
+      {
+        m_slots.resize (rnti + 1);
+      }
+    Slot &slot = m_slots[rnti];
+    if (!slot.m_used)
+      {
+        slot.m_value = T ();
+        slot.m_used = true;
+        ++slot.m_generation;
+        ++m_size;
+      }
+    return slot.m_value;
+  }
+
+  /**
+   * \param rnti the RNTI
+   * \return true if there was a context to erase
+   */
+  bool Erase (uint16_t rnti)
+  {
+    if (rnti >= m_slots.size () || !m_slots[rnti].m_used)
+      {
+        return false;
+      }
+    Slot &slot = m_slots[rnti];
+    // release the resources held by the context now
+    slot.m_value = T ();
+    slot.m_used = false;
+    ++slot.m_generation;
+    --m_size;
+    return true;
+  }
+
+  /**
+   * \param rnti the RNTI
+   * \return the generation of the context of the UE, 0 if the RNTI was
+   * never used
+   */
+  uint32_t GetGeneration (uint16_t rnti) const
+  {
+    return rnti < m_slots.size () ? m_slots[rnti].m_generation : 0;
+  }
+
+  /**
+   * \param rnti the RNTI
+   * \param generation the generation returned by GetGeneration
+   * \return true if the context the generation was taken from still exists
+   */
+  bool IsValid (uint16_t rnti, uint32_t generation) const
+  {
+    return rnti < m_slots.size () && m_slots[rnti].m_used && m_slots[rnti].m_generation == generation;
+  }
+
+  uint32_t GetSize () const
+  {
+    return m_size;
+  }
+
+  void Clear ()
+  {
+    m_slots.clear ();
+    m_size = 0;
+  }
+
+private:
+  struct Slot
+  {
+    T m_value;
+    uint32_t m_generation;
+    bool m_used;
+
+    Slot () : m_value (), m_generation (0), m_used (false) {}
+  };
+
+  std::vector<Slot> m_slots;
+  uint32_t m_size;
+};
+
+
+/**
+ * \ingroup lte
+ *
+ * Values indexed by GTP-U TEID. The SGW/PGW allocates the TEIDs
+ * sequentially from 1, so they are kept in a vector; the few TEIDs above
+ * MAX_DENSE_TEID, like the reserved VM chunk TEIDs, go to a map.
+ */
+template <class T>
+class TeidTable
+{
+public:
+  static const uint32_t MAX_DENSE_TEID = 1 << 20;
+
+  /**
+   * \param teid the TEID
+   * \return the value, or 0 if there is none
+   */
+  T* Find (uint32_t teid)
+  {
+    if (teid < MAX_DENSE_TEID)
+      {
+        if (teid < m_dense.size () && m_dense[teid].m_used)
+          {
+            return &m_dense[teid].m_value;
+          }
+        return 0;
+      }
+    typename std::map<uint32_t, T>::iterator it = m_sparse.find (teid);
+    return it != m_sparse.end () ? &it->second : 0;
+  }
+
+  void Set (uint32_t teid, const T &value)
+  {
+    if (teid < MAX_DENSE_TEID)
+      {
+        if (teid >= m_dense.size ())
+          {
+            m_dense.resize (teid + 1);
+          }
+        m_dense[teid].m_value = value;
+        m_dense[teid].m_used = true;
+        return;
+      }
+    m_sparse[teid] = value;
+  }
+
+  void Erase (uint32_t teid)
+  {
+    if (teid < MAX_DENSE_TEID)
+      {
+        if (teid < m_dense.size ())
+          {
+            m_dense[teid].m_used = false;
+          }
+        return;
+      }
+    m_sparse.erase (teid);
+  }
+
+private:
+  struct Entry
+  {
+    T m_value;
+    bool m_used;
+
+    Entry () : m_value (), m_used (false) {}
+  };
+
+  std::vector<Entry> m_dense;
+  std::map<uint32_t, T> m_sparse;
+};
+
+template <class T>
+const uint32_t TeidTable<T>::MAX_DENSE_TEID;
+
+} // namespace ns3
+
+#endif // RNTI_SLOT_TABLE_H